@@ -1,6 +1,8 @@
 #include <cstdlib>
 
 #include "igvInterface.h"
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 
 
@@ -201,6 +203,12 @@ void igvInterface::keyboardFunc(unsigned char key, int x, int y) {
 
             std::cout << "Transformation mode: " << (instance->transformationMode ? "RST" : "Sequential") << std::endl;
 
+            break;
+        case 'u':
+        case 'U':
+            if (instance->selectedObject && !instance->selectedObject->undoTransformation()) {
+                std::cout << "Nothing to undo" << std::endl;
+            }
             break;
         case 'r':
         case 'R':
@@ -210,6 +218,10 @@ void igvInterface::keyboardFunc(unsigned char key, int x, int y) {
                 std::cout << "Object transformations reset" << std::endl;
             }
             break;
+        case 't':
+        case 'T':
+            instance->reportSequentialFrameTimes(100000);
+            break;
     }
     glutPostRedisplay(); // refreshes the contents of the view window
 }
@@ -387,3 +399,51 @@ void igvInterface::selectObject(int objectNum) {
             break;
     }
 }
+
+/**
+ * Measures how the frame time of a sequential-mode object depends on the
+ * length of its transformation history. A separate cube is given 1, 10,
+ * 100, ... steps and at each size the frame is drawn a fixed number of
+ * times.
+ * @param maxSteps Largest history size to measure
+ * @pre There is a current OpenGL context
+ * @post The frame times are printed to the standard output
+ */
+void igvInterface::reportSequentialFrameTimes(int maxSteps) {
+    const int FRAMES = 200;
+    Cube benchCube;
+    benchCube.setRSTMode(false);
+
+    std::cout << "Sequential steps | frame time (ms)" << std::endl;
+    int steps = 0;
+    for (int target = 1; target <= maxSteps; target *= 10) {
+        // Small moves that cancel out, so the cube stays in view. The
+        // transform methods log every call, which is not what is measured.
+        std::streambuf *out = std::cout.rdbuf(nullptr);
+        for (; steps < target; ++steps) {
+            switch (steps % 4) {
+                case 0: benchCube.translate(0.01f, 0.0f, 0.0f); break;
+                case 1: benchCube.translate(-0.01f, 0.0f, 0.0f); break;
+                case 2: benchCube.rotate(0.0f, 1.0f, 0.0f); break;
+                case 3: benchCube.rotate(0.0f, -1.0f, 0.0f); break;
+            }
+        }
+        std::cout.rdbuf(out);
+
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < FRAMES; ++f) {
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            camera->applyProjection();
+            camera->applyView();
+            benchCube.draw();
+        }
+        glFinish();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        char line[64];
+        std::snprintf(line, sizeof(line), "%16d | %.4f", steps, ms / FRAMES);
+        std::cout << line << std::endl;
+    }
+    glutPostRedisplay();
+}
@@ -86,6 +86,10 @@ public:
 	void set_window_height(int _window_height);
 
 	void selectObject(int objectNum);
+
+	// pushes up to maxSteps sequential steps onto a cube and prints the frame
+	// time at each tenfold history size
+	void reportSequentialFrameTimes(int maxSteps);
 };
 
 #endif   // __IGVINTERFACE
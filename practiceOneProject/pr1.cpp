@@ -1,4 +1,5 @@
 #include <cstdlib>
+#include <cstring>
 
 #include "igvInterface.h"
 
@@ -11,6 +12,15 @@ int main(int argc, char **argv) {
 	                                                  , "CGIV: Practice 0" // window title
 	);
 
+	// --sequential-benchmark N prints the frame time for histories of up to N
+	// sequential steps and exits
+	for (int a = 1; a + 1 < argc; ++a) {
+		if (std::strcmp(argv[a], "--sequential-benchmark") == 0) {
+			igvInterface::getInstance().reportSequentialFrameTimes(std::atoi(argv[a + 1]));
+			return 0;
+		}
+	}
+
 	// sets the callback functions for event management
 	igvInterface::getInstance().initialize_callbacks();
 
@@ -23,7 +23,7 @@ void Object3D::translate(float dx, float dy, float dz) {
     translateZ += dz;
 
     if (!rstMode) {
-        transformationHistory.emplace_back(TRANSLATE_OP, dx, dy, dz);
+        pushStep(TRANSLATE_OP, dx, dy, dz);
     }
 
     std::cout << "Translation: (" << translateX << ", " << translateY << ", " << translateZ << ")" << std::endl;
@@ -35,7 +35,7 @@ void Object3D::rotate(float rx, float ry, float rz) {
     rotateZ += rz;
 
     if (!rstMode) {
-        transformationHistory.emplace_back(ROTATE_OP, rx, ry, rz);
+        pushStep(ROTATE_OP, rx, ry, rz);
     }
 
     std::cout << "Rotation: (" << rotateX << ", " << rotateY << ", " << rotateZ << ")" << std::endl;
@@ -47,7 +47,7 @@ void Object3D::scale(float sx, float sy, float sz) {
     scaleZ *= sz;
 
     if (!rstMode) {
-        transformationHistory.emplace_back(SCALE_OP, sx, sy, sz);
+        pushStep(SCALE_OP, sx, sy, sz);
     }
 
     std::cout << "Scale: (" << scaleX << ", " << scaleY << ", " << scaleZ << ")" << std::endl;
@@ -70,26 +70,56 @@ void Object3D::applyTransformations() {
         glRotatef(rotateY, 0.0f, 1.0f, 0.0f);
         glRotatef(rotateZ, 0.0f, 0.0f, 1.0f);
     } else {
-        // Sequential Mode: Apply in order of pressing
-        for (const auto& step : transformationHistory) {
-            switch (step.type) {
-                case TRANSLATE_OP:
-                    glTranslatef(step.x, step.y, step.z);
-                    break;
-                case ROTATE_OP:
-                    if (step.x != 0.0f) glRotatef(step.x, 1.0f, 0.0f, 0.0f);
-                    if (step.y != 0.0f) glRotatef(step.y, 0.0f, 1.0f, 0.0f);
-                    if (step.z != 0.0f) glRotatef(step.z, 0.0f, 0.0f, 1.0f);
-                    break;
-                case SCALE_OP:
-                    glScalef(step.x, step.y, step.z);
-                    break;
-            }
+        // Sequential Mode: every step, in order of pressing, already composed
+        glMultMatrixf(sequentialMatrix.data());
+    }
+}
+
+// Matrix of one sequential step, as glTranslatef/glRotatef/glScalef apply it.
+static cgvMatrix4 step_matrix(TransformationType type, float x, float y, float z) {
+    switch (type) {
+        case TRANSLATE_OP:
+            return cgvMatrix4::translation(x, y, z);
+        case ROTATE_OP: {
+            cgvMatrix4 r;
+            if (x != 0.0f) r *= cgvMatrix4::rotation(x, 1.0f, 0.0f, 0.0f);
+            if (y != 0.0f) r *= cgvMatrix4::rotation(y, 0.0f, 1.0f, 0.0f);
+            if (z != 0.0f) r *= cgvMatrix4::rotation(z, 0.0f, 0.0f, 1.0f);
+            return r;
         }
+        case SCALE_OP:
+            return cgvMatrix4::scaling(x, y, z);
     }
+    return cgvMatrix4();
+}
+
+void Object3D::pushStep(TransformationType type, float x, float y, float z) {
+    transformationHistory.emplace_back(type, x, y, z);
+    transformationHistory.back().before = sequentialMatrix;
+    if (transformationHistory.size() > MAX_UNDO_STEPS) transformationHistory.pop_front();
+    sequentialMatrix *= step_matrix(type, x, y, z);
+}
+
+bool Object3D::undoTransformation() {
+    if (transformationHistory.empty()) return false;
+    const TransformationStep& step = transformationHistory.back();
+    switch (step.type) {
+        case TRANSLATE_OP:
+            translateX -= step.x; translateY -= step.y; translateZ -= step.z;
+            break;
+        case ROTATE_OP:
+            rotateX -= step.x; rotateY -= step.y; rotateZ -= step.z;
+            break;
+        case SCALE_OP:
+            scaleX /= step.x; scaleY /= step.y; scaleZ /= step.z;
+            break;
+    }
+    sequentialMatrix = step.before;
+    transformationHistory.pop_back();
+    return true;
 }
 
 void Object3D::clearTransformationHistory() {
     transformationHistory.clear();
+    sequentialMatrix = cgvMatrix4();
 }
-
@@ -5,8 +5,10 @@
 #ifndef PR1_OBJECT3D_H
 #define PR1_OBJECT3D_H
 
+#include <deque>
 #include <iostream>
 #include <GLUT/glut.h>
+#include "cgvMatrix4.h"
 
 enum TransformationType {
     TRANSLATE_OP,
@@ -17,6 +19,7 @@ enum TransformationType {
 struct TransformationStep {
     TransformationType type;
     float x, y, z;
+    cgvMatrix4 before; // sequential matrix before this step, restored on undo
 
     TransformationStep(TransformationType t, float _x, float _y, float _z)
         : type(t), x(_x), y(_y), z(_z) {}
@@ -31,7 +34,14 @@ private:
 
     bool rstMode; // true = RST, false = Sequential
 
-    std::vector<TransformationStep> transformationHistory;
+    // Sequential mode folds every step into sequentialMatrix as it is made,
+    // so drawing costs one glMultMatrixf however long the object has been
+    // edited. Only the most recent steps are kept, for undo.
+    cgvMatrix4 sequentialMatrix;
+    std::deque<TransformationStep> transformationHistory;
+    static const std::size_t MAX_UNDO_STEPS = 64;
+
+    void pushStep(TransformationType type, float x, float y, float z);
 
 public:
     Object3D();
@@ -59,7 +69,13 @@ public:
     // Apply transformations
     void applyTransformations();
 
+    // Forgets the sequential steps: the object is back to the identity in
+    // sequential mode.
     void clearTransformationHistory();
+
+    // Reverts the last sequential step. Returns false when there is nothing
+    // left to undo.
+    bool undoTransformation();
 };
 
 
@@ -0,0 +1,197 @@
+#include "PrimitiveCache.h"
+#include <cmath>
+
+PrimitiveCache& PrimitiveCache::instance() {
+    static PrimitiveCache cache;
+    return cache;
+}
+
+bool PrimitiveCache::Key::operator<(const Key& other) const {
+    if (shape != other.shape) return shape < other.shape;
+    if (a != other.a) return a < other.a;
+    if (b != other.b) return b < other.b;
+    if (c != other.c) return c < other.c;
+    return d < other.d;
+}
+
+void PrimitiveCache::addVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz) {
+    GLfloat v[6] = {x, y, z, nx, ny, nz};
+    vertices.insert(vertices.end(), v, v + 6);
+}
+
+PrimitiveCache::Range PrimitiveCache::sphere(GLfloat radius, GLint slices, GLint stacks) {
+    Key key = {SPHERE, radius, 0.0f, slices, stacks};
+    auto it = ranges.find(key);
+    if (it != ranges.end()) return it->second;
+
+    Range range = {vertexCount(), 0};
+    tessellateSphere(radius, slices, stacks);
+    range.count = vertexCount() - range.first;
+    ranges[key] = range;
+    return range;
+}
+
+PrimitiveCache::Range PrimitiveCache::cylinder(GLfloat radius, GLfloat height, GLint slices) {
+    Key key = {CYLINDER, radius, height, slices, 0};
+    auto it = ranges.find(key);
+    if (it != ranges.end()) return it->second;
+
+    Range range = {vertexCount(), 0};
+    tessellateCylinder(radius, height, slices);
+    range.count = vertexCount() - range.first;
+    ranges[key] = range;
+    return range;
+}
+
+PrimitiveCache::Range PrimitiveCache::cube(GLfloat size) {
+    Key key = {CUBE, size, 0.0f, 0, 0};
+    auto it = ranges.find(key);
+    if (it != ranges.end()) return it->second;
+
+    Range range = {vertexCount(), 0};
+    tessellateCube(size);
+    range.count = vertexCount() - range.first;
+    ranges[key] = range;
+    return range;
+}
+
+PrimitiveCache::Range PrimitiveCache::cone(GLfloat base, GLfloat height, GLint slices, GLint stacks) {
+    Key key = {CONE, base, height, slices, stacks};
+    auto it = ranges.find(key);
+    if (it != ranges.end()) return it->second;
+
+    Range range = {vertexCount(), 0};
+    tessellateCone(base, height, slices, stacks);
+    range.count = vertexCount() - range.first;
+    ranges[key] = range;
+    return range;
+}
+
+void PrimitiveCache::drawSphere(GLfloat radius, GLint slices, GLint stacks) { draw(sphere(radius, slices, stacks)); }
+void PrimitiveCache::drawCylinder(GLfloat radius, GLfloat height, GLint slices) { draw(cylinder(radius, height, slices)); }
+void PrimitiveCache::drawCube(GLfloat size) { draw(cube(size)); }
+void PrimitiveCache::drawCone(GLfloat base, GLfloat height, GLint slices, GLint stacks) { draw(cone(base, height, slices, stacks)); }
+
+void PrimitiveCache::bind() {
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, STRIDE, vertices.data());
+    glNormalPointer(GL_FLOAT, STRIDE, vertices.data() + 3);
+}
+
+void PrimitiveCache::unbind() {
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+}
+
+void PrimitiveCache::draw(const Range& range) {
+    bind();
+    glDrawArrays(GL_TRIANGLES, range.first, range.count);
+    unbind();
+}
+
+void PrimitiveCache::tessellateSphere(GLfloat radius, GLint slices, GLint stacks) {
+    // phi runs from the +z pole (0) to the -z pole (pi), theta around z.
+    auto point = [&](GLint stack, GLint slice, GLfloat* n) {
+        GLfloat phi = static_cast<GLfloat>(M_PI) * stack / stacks;
+        GLfloat theta = 2.0f * static_cast<GLfloat>(M_PI) * slice / slices;
+        n[0] = std::sin(phi) * std::cos(theta);
+        n[1] = std::sin(phi) * std::sin(theta);
+        n[2] = std::cos(phi);
+    };
+    auto emit = [&](const GLfloat* n) {
+        addVertex(n[0] * radius, n[1] * radius, n[2] * radius, n[0], n[1], n[2]);
+    };
+
+    for (GLint i = 0; i < stacks; ++i) {
+        for (GLint j = 0; j < slices; ++j) {
+            GLfloat p00[3], p10[3], p11[3], p01[3];
+            point(i, j, p00);
+            point(i + 1, j, p10);
+            point(i + 1, j + 1, p11);
+            point(i, j + 1, p01);
+            // The quads touching a pole collapse to a single triangle.
+            if (i != stacks - 1) { emit(p00); emit(p10); emit(p11); }
+            if (i != 0) { emit(p00); emit(p11); emit(p01); }
+        }
+    }
+}
+
+void PrimitiveCache::tessellateCylinder(GLfloat radius, GLfloat height, GLint slices) {
+    for (GLint j = 0; j < slices; ++j) {
+        GLfloat a0 = 2.0f * static_cast<GLfloat>(M_PI) * j / slices;
+        GLfloat a1 = 2.0f * static_cast<GLfloat>(M_PI) * (j + 1) / slices;
+        GLfloat c0 = std::cos(a0), s0 = std::sin(a0);
+        GLfloat c1 = std::cos(a1), s1 = std::sin(a1);
+
+        addVertex(radius * c0, radius * s0, 0.0f, c0, s0, 0.0f);
+        addVertex(radius * c1, radius * s1, 0.0f, c1, s1, 0.0f);
+        addVertex(radius * c1, radius * s1, height, c1, s1, 0.0f);
+
+        addVertex(radius * c0, radius * s0, 0.0f, c0, s0, 0.0f);
+        addVertex(radius * c1, radius * s1, height, c1, s1, 0.0f);
+        addVertex(radius * c0, radius * s0, height, c0, s0, 0.0f);
+    }
+}
+
+void PrimitiveCache::tessellateCube(GLfloat size) {
+    const GLfloat h = size * 0.5f;
+    // Each face: normal, then two in-plane axes u and v with u x v = normal.
+    static const GLfloat faces[6][9] = {
+        { 1, 0, 0,   0, 1, 0,   0, 0, 1},
+        {-1, 0, 0,   0, 0, 1,   0, 1, 0},
+        { 0, 1, 0,   0, 0, 1,   1, 0, 0},
+        { 0, -1, 0,  1, 0, 0,   0, 0, 1},
+        { 0, 0, 1,   1, 0, 0,   0, 1, 0},
+        { 0, 0, -1,  0, 1, 0,   1, 0, 0},
+    };
+    for (const auto& f : faces) {
+        const GLfloat* n = f;
+        const GLfloat* u = f + 3;
+        const GLfloat* v = f + 6;
+        auto corner = [&](GLfloat su, GLfloat sv) {
+            addVertex(h * (n[0] + su * u[0] + sv * v[0]),
+                      h * (n[1] + su * u[1] + sv * v[1]),
+                      h * (n[2] + su * u[2] + sv * v[2]),
+                      n[0], n[1], n[2]);
+        };
+        corner(-1, -1); corner(1, -1); corner(1, 1);
+        corner(-1, -1); corner(1, 1); corner(-1, 1);
+    }
+}
+
+void PrimitiveCache::tessellateCone(GLfloat base, GLfloat height, GLint slices, GLint stacks) {
+    // Side normals are constant along each generator line.
+    const GLfloat slant = std::sqrt(height * height + base * base);
+    const GLfloat nr = slant > 0.0f ? height / slant : 0.0f;
+    const GLfloat nz = slant > 0.0f ? base / slant : 1.0f;
+
+    for (GLint j = 0; j < slices; ++j) {
+        GLfloat a0 = 2.0f * static_cast<GLfloat>(M_PI) * j / slices;
+        GLfloat a1 = 2.0f * static_cast<GLfloat>(M_PI) * (j + 1) / slices;
+        GLfloat c0 = std::cos(a0), s0 = std::sin(a0);
+        GLfloat c1 = std::cos(a1), s1 = std::sin(a1);
+
+        // Base disk, facing -z.
+        addVertex(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f);
+        addVertex(base * c1, base * s1, 0.0f, 0.0f, 0.0f, -1.0f);
+        addVertex(base * c0, base * s0, 0.0f, 0.0f, 0.0f, -1.0f);
+
+        for (GLint k = 0; k < stacks; ++k) {
+            GLfloat r0 = base * (1.0f - static_cast<GLfloat>(k) / stacks);
+            GLfloat r1 = base * (1.0f - static_cast<GLfloat>(k + 1) / stacks);
+            GLfloat z0 = height * k / stacks;
+            GLfloat z1 = height * (k + 1) / stacks;
+
+            addVertex(r0 * c0, r0 * s0, z0, nr * c0, nr * s0, nz);
+            addVertex(r0 * c1, r0 * s1, z0, nr * c1, nr * s1, nz);
+            addVertex(r1 * c1, r1 * s1, z1, nr * c1, nr * s1, nz);
+
+            if (k != stacks - 1) { // the top ring collapses to the apex
+                addVertex(r0 * c0, r0 * s0, z0, nr * c0, nr * s0, nz);
+                addVertex(r1 * c1, r1 * s1, z1, nr * c1, nr * s1, nz);
+                addVertex(r1 * c0, r1 * s0, z1, nr * c0, nr * s0, nz);
+            }
+        }
+    }
+}
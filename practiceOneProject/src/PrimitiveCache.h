@@ -0,0 +1,76 @@
+#ifndef PRIMITIVE_CACHE_H
+#define PRIMITIVE_CACHE_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+#include <map>
+#include <vector>
+
+// Tessellated solids shared by the scene objects instead of calling the GLUT
+// shape functions every frame. Each distinct (shape, size, subdivision) is
+// tessellated once into one shared interleaved position/normal array that is
+// drawn with vertex arrays.
+//
+// The shapes match their GLUT/GLU counterparts: spheres and cubes are
+// centred on the origin, cylinders and cones extend from z = 0 to +height.
+class PrimitiveCache {
+public:
+    static PrimitiveCache& instance();
+
+    void drawSphere(GLfloat radius, GLint slices, GLint stacks);
+    void drawCylinder(GLfloat radius, GLfloat height, GLint slices); // open tube, like gluCylinder
+    void drawCube(GLfloat size);
+    void drawCone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+
+    // A contiguous run of triangles in the shared array.
+    struct Range {
+        GLint first;
+        GLsizei count;
+    };
+
+    // Tessellates on first use and returns where the shape lives, for callers
+    // that draw from the shared array themselves.
+    Range sphere(GLfloat radius, GLint slices, GLint stacks);
+    Range cylinder(GLfloat radius, GLfloat height, GLint slices);
+    Range cube(GLfloat size);
+    Range cone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+
+    // Interleaved x, y, z, nx, ny, nz per vertex.
+    static const GLsizei STRIDE = 6 * sizeof(GLfloat);
+    const std::vector<GLfloat>& vertexData() const { return vertices; }
+
+    // Sets the vertex/normal pointers into the shared array. Ranges can then
+    // be drawn with glDrawArrays.
+    void bind();
+    void unbind();
+
+private:
+    PrimitiveCache() = default;
+
+    enum Shape { SPHERE, CYLINDER, CUBE, CONE };
+
+    struct Key {
+        Shape shape;
+        GLfloat a, b;
+        GLint c, d;
+        bool operator<(const Key& other) const;
+    };
+
+    std::map<Key, Range> ranges;
+    std::vector<GLfloat> vertices;
+
+    void draw(const Range& range);
+    void addVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz);
+    GLint vertexCount() const { return static_cast<GLint>(vertices.size() / 6); }
+
+    void tessellateSphere(GLfloat radius, GLint slices, GLint stacks);
+    void tessellateCylinder(GLfloat radius, GLfloat height, GLint slices);
+    void tessellateCube(GLfloat size);
+    void tessellateCone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+};
+
+#endif // PRIMITIVE_CACHE_H
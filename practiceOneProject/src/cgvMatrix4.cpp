@@ -0,0 +1,75 @@
+#include "cgvMatrix4.h"
+#include <cmath>
+
+cgvMatrix4::cgvMatrix4() {
+    for (int i = 0; i < 16; ++i) m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+cgvMatrix4 cgvMatrix4::translation(GLfloat x, GLfloat y, GLfloat z) {
+    cgvMatrix4 r;
+    r(0, 3) = x;
+    r(1, 3) = y;
+    r(2, 3) = z;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::rotation(GLfloat degrees, GLfloat x, GLfloat y, GLfloat z) {
+    cgvMatrix4 r;
+    GLfloat length = std::sqrt(x * x + y * y + z * z);
+    if (length == 0.0f) return r;
+    x /= length; y /= length; z /= length;
+
+    // Same matrix glRotatef builds.
+    GLfloat radians = degrees * static_cast<GLfloat>(M_PI) / 180.0f;
+    GLfloat c = std::cos(radians), s = std::sin(radians), t = 1.0f - c;
+    r(0, 0) = x * x * t + c;     r(0, 1) = x * y * t - z * s; r(0, 2) = x * z * t + y * s;
+    r(1, 0) = y * x * t + z * s; r(1, 1) = y * y * t + c;     r(1, 2) = y * z * t - x * s;
+    r(2, 0) = x * z * t - y * s; r(2, 1) = y * z * t + x * s; r(2, 2) = z * z * t + c;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::scaling(GLfloat x, GLfloat y, GLfloat z) {
+    cgvMatrix4 r;
+    r(0, 0) = x;
+    r(1, 1) = y;
+    r(2, 2) = z;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::lookAt(GLfloat eyeX, GLfloat eyeY, GLfloat eyeZ,
+                              GLfloat centerX, GLfloat centerY, GLfloat centerZ,
+                              GLfloat upX, GLfloat upY, GLfloat upZ) {
+    // Forward, side = forward x up, and the corrected up = side x forward.
+    GLfloat f[3] = {centerX - eyeX, centerY - eyeY, centerZ - eyeZ};
+    GLfloat fl = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    if (fl > 0.0f) { f[0] /= fl; f[1] /= fl; f[2] /= fl; }
+
+    GLfloat s[3] = {f[1] * upZ - f[2] * upY, f[2] * upX - f[0] * upZ, f[0] * upY - f[1] * upX};
+    GLfloat sl = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    if (sl > 0.0f) { s[0] /= sl; s[1] /= sl; s[2] /= sl; }
+
+    GLfloat u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+
+    cgvMatrix4 r;
+    r(0, 0) = s[0];  r(0, 1) = s[1];  r(0, 2) = s[2];
+    r(1, 0) = u[0];  r(1, 1) = u[1];  r(1, 2) = u[2];
+    r(2, 0) = -f[0]; r(2, 1) = -f[1]; r(2, 2) = -f[2];
+    return r * translation(-eyeX, -eyeY, -eyeZ);
+}
+
+cgvMatrix4 cgvMatrix4::operator*(const cgvMatrix4& other) const {
+    cgvMatrix4 r;
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            GLfloat sum = 0.0f;
+            for (int k = 0; k < 4; ++k) sum += (*this)(row, k) * other(k, col);
+            r(row, col) = sum;
+        }
+    }
+    return r;
+}
+
+cgvMatrix4& cgvMatrix4::operator*=(const cgvMatrix4& other) {
+    *this = *this * other;
+    return *this;
+}
@@ -0,0 +1,37 @@
+#ifndef __CGV_MATRIX4_H
+#define __CGV_MATRIX4_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+// 4x4 transform stored column-major, the layout glLoadMatrixf/glMultMatrixf
+// and GLSL expect. Angles are in degrees, as in glRotatef.
+class cgvMatrix4 {
+private:
+    GLfloat m[16];
+
+public:
+    cgvMatrix4(); // identity
+
+    static cgvMatrix4 translation(GLfloat x, GLfloat y, GLfloat z);
+    static cgvMatrix4 rotation(GLfloat degrees, GLfloat x, GLfloat y, GLfloat z);
+    static cgvMatrix4 scaling(GLfloat x, GLfloat y, GLfloat z);
+    // Same matrix gluLookAt builds.
+    static cgvMatrix4 lookAt(GLfloat eyeX, GLfloat eyeY, GLfloat eyeZ,
+                             GLfloat centerX, GLfloat centerY, GLfloat centerZ,
+                             GLfloat upX, GLfloat upY, GLfloat upZ);
+
+    cgvMatrix4 operator*(const cgvMatrix4& other) const;
+    cgvMatrix4& operator*=(const cgvMatrix4& other);
+
+    // Element at (row, column).
+    GLfloat& operator()(int row, int col) { return m[col * 4 + row]; }
+    GLfloat operator()(int row, int col) const { return m[col * 4 + row]; }
+
+    const GLfloat* data() const { return m; }
+};
+
+#endif
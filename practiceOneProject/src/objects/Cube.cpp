@@ -3,11 +3,12 @@
 //
 
 #include "Cube.h"
+#include "src/PrimitiveCache.h"
 
 void Cube::draw() {
     applyTransformations();
     if (getSelected()) glColor3f(1.0f, 0.0f, 0.0f);
     else glColor3f(0.5f, 0.5f, 0.5f);
-    glutSolidCube(0.5f);
+    PrimitiveCache::instance().drawCube(0.5f);
     glPopMatrix();
 }
@@ -1,148 +1,226 @@
 #include "ArticulatedModel.h"
+#include "src/PrimitiveCache.h"
+#include "src/IdPicker.h"
 #include <cmath>
 
 #if defined(__APPLE__) && defined(__MACH__)
 #include <GLUT/glut.h>
-#include <OpenGL/glu.h>
 #else
 #include <GL/glut.h>
-#include <GL/glu.h>
 #endif
 
-// Helper to create a cylinder
-static void draw_cylinder(float radius, float height, int slices) {
-    GLUquadric* quad = gluNewQuadric();
-    gluCylinder(quad, radius, radius, height, slices, 1);
-    gluDeleteQuadric(quad);
-}
-
 ArticulatedModel::ArticulatedModel() : Object3D() {
     active_dof = 0;
     dof[0] = 0.0f; dof[1] = 0.0f; dof[2] = 0.0f;
     dof_min[0] = -180.0f; dof_max[0] = 180.0f;
     dof_min[1] = -90.0f;  dof_max[1] = 90.0f;
     dof_min[2] = -90.0f;  dof_max[2] = 90.0f;
+
+    for (int n = 0; n < NODE_COUNT; ++n) {
+        int parent = node_parent(static_cast<Node>(n));
+        (parent < 0 ? static_cast<SceneNode*>(this) : &nodes[parent])->addChild(&nodes[n]);
+        nodes[n].setLocalMatrix(node_local(static_cast<Node>(n), dof));
+    }
+    setLocalBounds(BoundingBox(reach()), reach());
 }
 
-void ArticulatedModel::draw() {
-    glPushMatrix();
-    applyTransformations();
+BoundingSphere ArticulatedModel::reach() {
+    // Shoulder height, then two arms of 2 and the head's radius. The base is
+    // well inside.
+    return {vec3(0.0f, 0.5f, 0.0f), 2.0f + 2.0f + 0.5f};
+}
 
-    // Base
-    glPushMatrix();
-    glRotatef(dof[0], 0, 1, 0);
-    glColor3f(0.4f, 0.4f, 0.5f);
-    draw_base();
-
-        // Joint 1 & Arm 1
-        glPushMatrix();
-        glTranslatef(0, 0.5, 0);
-        glColor3f(0.8f, 0.2f, 0.2f);
-        glutSolidSphere(0.4, 20, 20);
-        glRotatef(dof[1], 1, 0, 0);
-        draw_arm1();
-
-            // Joint 2 & Arm 2
-            glPushMatrix();
-            glTranslatef(0, 2.0, 0);
-            glColor3f(0.2f, 0.8f, 0.2f);
-            glutSolidSphere(0.3, 20, 20);
-            glRotatef(dof[2], 1, 0, 0);
-            draw_arm2();
-
-                // Head
-                glPushMatrix();
-                glTranslatef(0, 2.0, 0);
-                glColor3f(0.2f, 0.2f, 0.8f);
-                draw_head();
-                glPopMatrix(); // Pop head
-
-            glPopMatrix(); // Pop arm 2
-        glPopMatrix(); // Pop arm 1
-    glPopMatrix(); // Pop base
-
-    glPopMatrix(); // Pop global transformations
-}
-
-void ArticulatedModel::render_for_selection() {
-    glPushMatrix();
-    applyTransformations();
+int ArticulatedModel::node_parent(Node node) {
+    switch (node) {
+        case BASE_JOINT: return -1;
+        case BASE_SHAPE: case SHOULDER: return BASE_JOINT;
+        case JOINT1_SHAPE: case ARM1_JOINT: return SHOULDER;
+        case ARM1_SHAPE: case ELBOW: return ARM1_JOINT;
+        case JOINT2_SHAPE: case ARM2_JOINT: return ELBOW;
+        default: return ARM2_JOINT; // ARM2_SHAPE, HEAD_SHAPE
+    }
+}
 
-    // Base (ID 1 -> DoF 0)
-    glPushMatrix();
-    glRotatef(dof[0], 0, 1, 0);
-    glColor3ub(1, 0, 0);
-    draw_base();
-
-        // Arm 1 (ID 2 -> DoF 1)
-        glPushMatrix();
-        glTranslatef(0, 0.5, 0);
-        glColor3ub(2, 0, 0);
-        glutSolidSphere(0.4, 20, 20);
-        glRotatef(dof[1], 1, 0, 0);
-        draw_arm1();
-
-            // Arm 2 (ID 3 -> DoF 2)
-            glPushMatrix();
-            glTranslatef(0, 2.0, 0);
-            glColor3ub(3, 0, 0);
-            glutSolidSphere(0.3, 20, 20);
-            glRotatef(dof[2], 1, 0, 0);
-            draw_arm2();
-            glPopMatrix(); // Pop arm 2
-        glPopMatrix(); // Pop arm 1
-    glPopMatrix(); // Pop base
-
-    glPopMatrix(); // Pop global
-}
-
-// Drawing methods no longer set their own color
-void ArticulatedModel::draw_base() {
-    glPushMatrix();
-    glScalef(1.5, 1.0, 1.5);
-    glutSolidCube(1.0);
-    glPopMatrix();
+ArticulatedModel::Node ArticulatedModel::part_node(Part part) {
+    static const Node nodes_of_parts[PART_COUNT] = {
+        BASE_SHAPE, JOINT1_SHAPE, ARM1_SHAPE, JOINT2_SHAPE, ARM2_SHAPE, HEAD_SHAPE
+    };
+    return nodes_of_parts[part];
 }
 
-void ArticulatedModel::draw_arm1() {
-    glPushMatrix();
-    glRotatef(-90, 1, 0, 0);
-    draw_cylinder(0.25, 2.0, 20);
-    glPopMatrix();
+cgvMatrix4 ArticulatedModel::node_local(Node node, const float pose[3]) {
+    switch (node) {
+        case BASE_JOINT: return cgvMatrix4::rotation(pose[0], 0, 1, 0);
+        case BASE_SHAPE: return cgvMatrix4::scaling(1.5f, 1.0f, 1.5f);
+        case SHOULDER: return cgvMatrix4::translation(0, 0.5f, 0);
+        case ARM1_JOINT: return cgvMatrix4::rotation(pose[1], 1, 0, 0);
+        case ARM1_SHAPE: return cgvMatrix4::rotation(-90, 1, 0, 0);
+        case ELBOW: return cgvMatrix4::translation(0, 2.0f, 0);
+        case ARM2_JOINT: return cgvMatrix4::rotation(pose[2], 1, 0, 0);
+        case ARM2_SHAPE: return cgvMatrix4::rotation(-90, 1, 0, 0);
+        case HEAD_SHAPE: return cgvMatrix4::translation(0, 2.0f, 0);
+        default: return cgvMatrix4(); // the joint spheres sit on their joint
+    }
 }
 
-void ArticulatedModel::draw_arm2() {
-    glPushMatrix();
-    glRotatef(-90, 1, 0, 0);
-    draw_cylinder(0.2, 2.0, 20);
-    glPopMatrix();
+void ArticulatedModel::pose_changed(int dof_id) {
+    static const Node joints[3] = {BASE_JOINT, ARM1_JOINT, ARM2_JOINT};
+    nodes[joints[dof_id]].setLocalMatrix(node_local(joints[dof_id], dof));
 }
 
-void ArticulatedModel::draw_head() {
+void ArticulatedModel::part_matrices(const float pose[3], cgvMatrix4 parts[PART_COUNT]) {
+    cgvMatrix4 model[NODE_COUNT];
+    for (int n = 0; n < NODE_COUNT; ++n) {
+        int parent = node_parent(static_cast<Node>(n));
+        cgvMatrix4 local = node_local(static_cast<Node>(n), pose);
+        model[n] = parent < 0 ? local : model[parent] * local;
+    }
+    for (int p = 0; p < PART_COUNT; ++p) parts[p] = model[part_node(static_cast<Part>(p))];
+}
+
+ArticulatedModel::PartShape ArticulatedModel::part_shape(Part part) {
+    switch (part) {
+        case BASE: return {PartShape::CUBE, 1.0f, 0.0f};
+        case JOINT1: return {PartShape::SPHERE, 0.4f, 0.0f};
+        case ARM1: return {PartShape::CYLINDER, 0.25f, 2.0f};
+        case JOINT2: return {PartShape::SPHERE, 0.3f, 0.0f};
+        case ARM2: return {PartShape::CYLINDER, 0.2f, 2.0f};
+        default: return {PartShape::SPHERE, 0.5f, 0.0f};
+    }
+}
+
+PrimitiveCache::Range ArticulatedModel::part_range(Part part) {
+    PrimitiveCache& cache = PrimitiveCache::instance();
+    PartShape shape = part_shape(part);
+    switch (shape.kind) {
+        case PartShape::CUBE: return cache.cube(shape.size);
+        case PartShape::CYLINDER: return cache.cylinder(shape.size, shape.height, 20);
+        default: return cache.sphere(shape.size, 20, 20);
+    }
+}
+
+const GLfloat* ArticulatedModel::part_color(Part part) {
+    static const GLfloat colors[PART_COUNT][3] = {
+        {0.4f, 0.4f, 0.5f},
+        {0.8f, 0.2f, 0.2f}, {0.8f, 0.2f, 0.2f},
+        {0.2f, 0.8f, 0.2f}, {0.2f, 0.8f, 0.2f},
+        {0.2f, 0.2f, 0.8f}
+    };
+    return colors[part];
+}
+
+int ArticulatedModel::part_dof(Part part) {
+    switch (part) {
+        case BASE: return 0;
+        case JOINT1: case ARM1: return 1;
+        case JOINT2: case ARM2: return 2;
+        default: return -1; // the head is not pickable
+    }
+}
+
+BoundingBox ArticulatedModel::part_bounds(Part part) {
+    PartShape shape = part_shape(part);
+    GLfloat r = shape.kind == PartShape::CUBE ? shape.size * 0.5f : shape.size;
+    GLfloat zMin = shape.kind == PartShape::CYLINDER ? 0.0f : -r;
+    GLfloat zMax = shape.kind == PartShape::CYLINDER ? shape.height : r;
+    return BoundingBox(vec3(-r, -r, zMin), vec3(r, r, zMax)).transformed(nodes[part_node(part)].getWorldMatrix());
+}
+
+bool ArticulatedModel::intersect(const Ray& ray, RayHit& hit) {
+    RayHit reachHit = hit;
+    if (!Object3D::intersect(ray, reachHit)) return false; // misses the whole reach
+
+    bool found = false;
+    for (int p = 0; p < PART_COUNT; ++p) {
+        PartShape shape = part_shape(static_cast<Part>(p));
+        Ray local = ray.transformed(nodes[part_node(static_cast<Part>(p))].getWorldMatrix().inverse());
+        GLfloat t;
+        bool hitPart;
+        switch (shape.kind) {
+            case PartShape::CUBE: {
+                GLfloat h = shape.size * 0.5f;
+                hitPart = RayTests::box(local, BoundingBox(vec3(-h, -h, -h), vec3(h, h, h)), hit.distance, t);
+                break;
+            }
+            case PartShape::CYLINDER:
+                hitPart = RayTests::cylinder(local, shape.size, shape.height, hit.distance, t);
+                break;
+            default:
+                hitPart = RayTests::sphere(local, vec3(), shape.size, hit.distance, t);
+                break;
+        }
+        if (hitPart) {
+            hit.distance = t;
+            hit.part = p;
+            hit.triangle = -1;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void ArticulatedModel::draw() {
     glPushMatrix();
-    glutSolidSphere(0.5, 20, 20);
+    for (int p = 0; p < PART_COUNT; ++p) drawPacket(p);
     glPopMatrix();
 }
 
+void ArticulatedModel::submit(RenderQueue& queue) {
+    for (int p = 0; p < PART_COUNT; ++p) {
+        SceneNode& node = nodes[part_node(static_cast<Part>(p))];
+        float depth = -node.getModelViewMatrix()(2, 3); // the part's origin
+        queue.add(this, p, DrawState(), depth);
+    }
+}
+
+void ArticulatedModel::drawPacket(int part) {
+    nodes[part_node(static_cast<Part>(part))].loadModelView();
+    glColor3fv(part_color(static_cast<Part>(part)));
+    PrimitiveCache::instance().draw(part_range(static_cast<Part>(part)));
+}
+
+void ArticulatedModel::drawIds(GLuint objectBits) {
+    for (int p = 0; p < PART_COUNT; ++p) {
+        nodes[part_node(static_cast<Part>(p))].loadModelView();
+        IdPicker::setColor(objectBits | p);
+        PrimitiveCache::instance().draw(part_range(static_cast<Part>(p)));
+    }
+}
+
 void ArticulatedModel::next_dof() { active_dof = (active_dof + 1) % 3; }
 void ArticulatedModel::prev_dof() { active_dof = (active_dof - 1 + 3) % 3; }
 
 void ArticulatedModel::increase_dof() {
     dof[active_dof] += 2.0f;
     if (dof[active_dof] > dof_max[active_dof]) dof[active_dof] = dof_max[active_dof];
+    pose_changed(active_dof);
 }
 
 void ArticulatedModel::decrease_dof() {
     dof[active_dof] -= 2.0f;
     if (dof[active_dof] < dof_min[active_dof]) dof[active_dof] = dof_min[active_dof];
+    pose_changed(active_dof);
 }
 
 void ArticulatedModel::set_dof(int dof_id) {
     if (dof_id >= 0 && dof_id < 3) active_dof = dof_id;
 }
 
+void ArticulatedModel::pose_at(float time, float pose[3]) const {
+    pose[0] = (dof_max[0] - dof_min[0]) * 0.5f * sin(time * 0.5f);
+    pose[1] = dof_min[1] + (dof_max[1] - dof_min[1]) * 0.5f * (1 + sin(time * 0.7f));
+    pose[2] = dof_min[2] + (dof_max[2] - dof_min[2]) * 0.5f * (1 + sin(time * 0.9f));
+}
+
 void ArticulatedModel::update(float time) {
-    dof[0] = (dof_max[0] - dof_min[0]) * 0.5f * sin(time * 0.5f);
-    dof[1] = dof_min[1] + (dof_max[1] - dof_min[1]) * 0.5f * (1 + sin(time * 0.7f));
-    dof[2] = dof_min[2] + (dof_max[2] - dof_min[2]) * 0.5f * (1 + sin(time * 0.9f));
+    float pose[3];
+    pose_at(time, pose);
+    set_pose(pose);
+}
+
+void ArticulatedModel::set_pose(const float pose[3]) {
+    for (int d = 0; d < 3; ++d) {
+        dof[d] = pose[d];
+        pose_changed(d);
+    }
 }
@@ -9,14 +9,21 @@
 
 #include "src/Object3D.h"
 #include "src/cgvPoint3D.h"
+#include "src/cgvMatrix4.h"
+#include "src/PrimitiveCache.h"
 
 class ArticulatedModel : public Object3D {
 public:
+    // Rigid parts, each one cached primitive under its own transform.
+    enum Part { BASE, JOINT1, ARM1, JOINT2, ARM2, HEAD, PART_COUNT };
+
     ArticulatedModel();
     ~ArticulatedModel() = default;
 
     void draw() override;
-    void render_for_selection();
+    void submit(RenderQueue& queue) override; // a packet per part
+    void drawPacket(int part) override;
+    void drawIds(GLuint objectBits) override; // parts as primitives
 
     void next_dof();
     void prev_dof();
@@ -25,17 +32,57 @@ public:
     void set_dof(int dof_id);
     void update(float delta_time);
 
+    // Joint angles the animation has at the given time.
+    void pose_at(float time, float pose[3]) const;
+    const float* get_pose() const { return dof; }
+    void set_pose(const float pose[3]);
+
+    // Transform of every part relative to the model for a pose, so many
+    // robots can be drawn without walking the hierarchy each time.
+    static void part_matrices(const float pose[3], cgvMatrix4 parts[PART_COUNT]);
+    // What a part is drawn as before its node's transform: a cube of side
+    // size or a sphere of radius size, both centred, or an open tube of
+    // radius size from z = 0 to height.
+    struct PartShape {
+        enum Kind { CUBE, SPHERE, CYLINDER } kind;
+        GLfloat size;
+        GLfloat height;
+    };
+    static PartShape part_shape(Part part);
+    static PrimitiveCache::Range part_range(Part part);
+    static const GLfloat* part_color(Part part);
+    // Sphere holding the robot in every pose: the arm swings around the
+    // shoulder and reaches the far side of the head at most.
+    static BoundingSphere reach();
+
+    // DoF that picking a part selects, -1 for none.
+    static int part_dof(Part part);
+    // Tests the parts' exact shapes and reports the nearest as hit.part.
+    bool intersect(const Ray& ray, RayHit& hit) override;
+    // World box of one part in the current pose.
+    BoundingBox part_bounds(Part part);
+
 private:
     float dof[3];
     int active_dof;
     float dof_min[3];
     float dof_max[3];
 
-    // Methods to draw primitives
-    void draw_base();
-    void draw_arm1();
-    void draw_arm2();
-    void draw_head();
+    // Joints and part shapes, each a scene node under the model. Parents are
+    // listed before their children. A DoF change only touches its joint
+    // node; the parts below it pick the change up through dirty propagation.
+    enum Node {
+        BASE_JOINT, BASE_SHAPE,
+        SHOULDER, JOINT1_SHAPE, ARM1_JOINT, ARM1_SHAPE,
+        ELBOW, JOINT2_SHAPE, ARM2_JOINT, ARM2_SHAPE, HEAD_SHAPE,
+        NODE_COUNT
+    };
+    SceneNode nodes[NODE_COUNT];
+
+    static int node_parent(Node node);       // -1 for the model itself
+    static Node part_node(Part part);
+    static cgvMatrix4 node_local(Node node, const float pose[3]);
+    void pose_changed(int dof_id);
 };
 
 #endif
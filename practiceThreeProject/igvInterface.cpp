@@ -1,41 +1,69 @@
 #include "igvInterface.h"
-#include "src/AdvancedOBJLoader.h"
+#include "src/OffscreenContext.h"
 #include <iostream>
 #include <cmath>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
 
 igvInterface* igvInterface::_instance = nullptr;
 
-// Static callbacks
-void menu_callback(int option);
-void shading_menu_callback(int option);
-void interaction_menu_callback(int option);
-void animation_menu_callback(int option);
-void material_menu_callback(int option);
-void texture_menu_callback(int option);
-void texture_filter_menu_callback(int option);
-void light_menu_callback(int option);
-void light_select_menu_callback(int option);
+// Time the render thread may spend per frame on finishing loaded assets
+static const double ASSET_UPLOAD_BUDGET_MS = 4.0;
+
+// How often crowd mode and the 'r' reports print
+static const double CROWD_REPORT_INTERVAL_S = 2.0;
+
+// The benchmark's camera path: one turn around the scene over the timed
+// frames, rising and falling this many degrees twice and moving in and out
+// by this fraction of the orbit radius once. The scene animates at a fixed
+// 60 frames per second of scripted time.
+static const float BENCHMARK_PITCH_DEG = 20.0f;
+static const float BENCHMARK_DOLLY = 0.3f;
+static const float BENCHMARK_ANIMATION_FPS = 60.0f;
+
+// Where 'e' writes the profiler's summaries
+static const char* const PROFILE_CSV_PATH = "profile.csv";
+
+// Simulated time a replay advances per frame, whatever the real frame rate
+static const double REPLAY_STEP_MS = 1000.0 / 60.0;
 
 // Mouse and selection state
 static int last_mouse_y;
 static int selected_dof_by_mouse = -1;
-static bool selection_requested = false;
-static int selection_x, selection_y;
+static int hover_x = -1, hover_y = -1; // -1 while the mouse is outside the window
+static bool left_button_down = false;
+static bool dragging_rectangle = false;    // shift-drag in GPU picking mode
+static bool rectangle_pick_pending = false; // the GPU pick in flight is a rectangle
+static int rectangle_x0, rectangle_y0, rectangle_x1, rectangle_y1;
 
 igvInterface& igvInterface::getInstance() {
     if (!_instance) _instance = new igvInterface;
     return *_instance;
 }
 
+// Milliseconds of steady time counted on from startMs. Not
+// glutGet(GLUT_ELAPSED_TIME): GLUT belongs to the main thread.
+static std::function<double()> steady_clock_from(double startMs) {
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return [start, startMs] {
+        return startMs + std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+}
+
 igvInterface::igvInterface() {
     camera = new Camera();
     triangleMesh = new cgvTriangleMesh();
     articulatedModel = new ArticulatedModel();
     floor = new Floor();
+    assetLoader = new AssetLoader();
+    crowd = new CrowdScene();
+    instancedRenderer = new InstancedRenderer();
+    simulation = new Simulation(*articulatedModel);
 
-    if (!AdvancedOBJLoader::load("objFiles/cow.obj", *triangleMesh)) {
-        std::cerr << "Failed to load cow mesh." << std::endl;
-    }
+    // The cow is parsed in the background and shows up once it is ready.
+    assetLoader->load_mesh("objFiles/cow.obj", triangleMesh, true);
     triangleMesh->set_specular_reflectivity(0.1f);
     triangleMesh->set_shininess(10.0f);
     triangleMesh->translate(-5, 0, 0);
@@ -54,13 +82,26 @@ igvInterface::igvInterface() {
     animateLight = false; // Initialized to false
     textureEnabled = true;
     globalAmbientLightOn = true;
+    crowdMode = false;
+    crowdCount = CrowdScene::DEFAULT_COUNT;
+    frustumCulling = true;
+    gpuPicking = false;
+    renderStatsReport = false;
+    profilerHud = false;
+    clock = steady_clock_from(0.0);
+    showcaseOrbitRadius = camera->getOrbitRadius();
+    showcaseFarPlane = camera->getFarPlane();
 }
 
 igvInterface::~igvInterface() {
+    delete assetLoader; // joins the workers before their targets go away
+    delete simulation;  // likewise its thread
     delete camera;
     delete triangleMesh;
     delete articulatedModel;
     delete floor;
+    delete crowd;
+    delete instancedRenderer;
 }
 
 void igvInterface::setupLights() {
@@ -87,7 +128,8 @@ void igvInterface::setupLights() {
 
 void igvInterface::initGLResources() {
     setupLights();
-    floor->init(); // Initialize floor textures
+    floor->init(*assetLoader); // Queue the floor textures
+    instancedRenderer->init();
 }
 
 void igvInterface::configure_environment(int argc, char** argv, int _window_width, int _window_height, int _pos_X, int _pos_Y, std::string _title) {
@@ -99,19 +141,26 @@ void igvInterface::configure_environment(int argc, char** argv, int _window_widt
     glutInitWindowSize(_window_width, _window_height);
     glutInitWindowPosition(_pos_X, _pos_Y);
     glutCreateWindow(_title.c_str());
+    windowed = true;
+
+    create_menus();
+    initGL();
+}
 
-    glEnable(GL_DEPTH_TEST);
+void igvInterface::initGL() {
+    GLState::enable(GL_DEPTH_TEST);
     glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
-    glEnable(GL_LIGHTING);
+    GLState::enable(GL_LIGHTING);
 
-    glEnable(GL_COLOR_MATERIAL);
+    GLState::enable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT, GL_AMBIENT_AND_DIFFUSE);
-    
-    create_menus();
+
     initGLResources(); // Call after context is created
 }
 
 void igvInterface::start_display_loop() {
+    // A replay steps the simulation from idleFunc, in time with its events.
+    if (!replaying) simulation->start(clock);
     glutMainLoop();
 }
 
@@ -119,7 +168,7 @@ void igvInterface::keyboardFunc(unsigned char key, int x, int y) {
     igvInterface* i = &getInstance();
     float move_speed = 0.5f;
     switch (key) {
-        case 27: exit(0);
+        case 27: i->inputRecorder.stop(); i->simulation->stop(); exit(0);
         case 'c': case 'C': i->cameraMode = !i->cameraMode; i->selectLight(-1); break;
         case 'p': case 'P': i->camera->toggleProjection(); break;
         case '=': case '+': i->camera->zoom(-1.0f); break;
@@ -154,8 +203,19 @@ void igvInterface::keyboardFunc(unsigned char key, int x, int y) {
         case 'a': case 'A': i->toggleAnimateModel(); break;
         case 'g': case 'G': i->toggleAnimateCamera(); break;
         case 'b': case 'B': i->toggleAnimateLight(); break; // Shortcut for light animation
+
+        // Crowd mode
+        case 'm': case 'M': i->setCrowdMode(!i->crowdMode); break;
+        case 'v': case 'V': i->toggleInstancing(); break;
+        case '[': i->setCrowdCount(i->crowdCount / 2); break;
+        case ']': i->setCrowdCount(i->crowdCount * 2); break;
+        case 'f': case 'F': i->toggleFrustumCulling(); break;
+        case 'd': case 'D': i->toggleMeshLod(); break;
+        case 'r': case 'R': i->toggleRenderStats(); break;
+        case 'h': case 'H': i->toggleProfiler(); break;
+        case 'e': case 'E': i->exportProfile(); break;
     }
-    glutPostRedisplay();
+    requestRedisplay();
 }
 
 void igvInterface::specialKeyboardFunc(int key, int x, int y) {
@@ -181,7 +241,7 @@ void igvInterface::specialKeyboardFunc(int key, int x, int y) {
             case GLUT_KEY_DOWN: i->selectedObject->translate(0.0f, -move_speed, 0.0f); break; // Up/Down on Y-axis
         }
     }
-    glutPostRedisplay();
+    requestRedisplay();
 }
 
 void igvInterface::reshapeFunc(int w, int h) {
@@ -191,176 +251,642 @@ void igvInterface::reshapeFunc(int w, int h) {
     _instance->camera->setAspectRatio((float)w / h);
 }
 
-void igvInterface::process_selection() {
-    // This is now called from displayFunc
-    glDisable(GL_LIGHTING);
-    glDisable(GL_DITHER);
+PickResult igvInterface::pickAt(int x, int y) {
+    ProfileScope scope("pick");
+    return picker.pick(drawList, camera->getRay(x, y, window_width, window_height));
+}
 
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    camera->applyProjection();
-    camera->applyView();
-    articulatedModel->render_for_selection();
+void igvInterface::drawHover() {
+    if (!hover.hit()) return;
+    BoundingBox box = hover.object == articulatedModel && hover.part >= 0
+        ? articulatedModel->part_bounds(static_cast<ArticulatedModel::Part>(hover.part))
+        : hover.object->getWorldBounds();
+    const vec3& a = box.min;
+    const vec3& b = box.max;
+    const GLfloat corners[8][3] = {
+        {a.x, a.y, a.z}, {b.x, a.y, a.z}, {b.x, b.y, a.z}, {a.x, b.y, a.z},
+        {a.x, a.y, b.z}, {b.x, a.y, b.z}, {b.x, b.y, b.z}, {a.x, b.y, b.z}
+    };
+    static const int edges[12][2] = {
+        {0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6}, {6, 7}, {7, 4},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(SceneNode::getViewMatrix().data());
+    GLState::disable(GL_LIGHTING);
+    glColor3f(1.0f, 1.0f, 0.0f);
+    glBegin(GL_LINES);
+    for (const auto& edge : edges) {
+        glVertex3fv(corners[edge[0]]);
+        glVertex3fv(corners[edge[1]]);
+    }
+    glEnd();
+    GLState::enable(GL_LIGHTING);
+}
 
-    unsigned char pixel[3];
-    glReadPixels(selection_x, window_height - selection_y, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, pixel);
+void igvInterface::handleIdPick(const IdPickResult& result) {
+    if (!rectangle_pick_pending) {
+        GLuint id = result.pixels.empty() ? 0 : result.pixels[0];
+        if (result.object(id) != articulatedModel) return;
+        int dof = ArticulatedModel::part_dof(static_cast<ArticulatedModel::Part>(IdPicker::primitiveOf(id)));
+        if (dof < 0) return;
+        articulatedModel->set_dof(dof);
+        // The button may already be up again by the time the answer is in.
+        if (left_button_down) selected_dof_by_mouse = dof;
+        return;
+    }
 
-    if (pixel[0] > 0 && pixel[0] <= 3) { // Assuming 1, 2, 3 are valid DoF IDs
-        selected_dof_by_mouse = pixel[0] - 1; // 0-indexed DoF
-        articulatedModel->set_dof(selected_dof_by_mouse);
-    } else {
-        selected_dof_by_mouse = -1;
+    // Select everything seen in the rectangle and say how much of it.
+    rectangle_pick_pending = false;
+    for (Object3D* object : result.objects) object->setSelected(false);
+    std::cout << "Rectangle " << result.width << "x" << result.height << ":";
+    if (result.coverage.empty()) std::cout << " nothing";
+    for (std::size_t k = 0; k < result.objects.size(); ++k) {
+        unsigned pixels = 0, primitives = 0;
+        for (const auto& entry : result.coverage) {
+            if (IdPicker::objectOf(entry.first) != static_cast<int>(k)) continue;
+            pixels += entry.second;
+            ++primitives;
+        }
+        if (pixels == 0) continue;
+        result.objects[k]->setSelected(true);
+        std::cout << " " << objectName(result.objects[k]) << " (" << pixels << " px, " << primitives
+                  << (result.objects[k] == articulatedModel ? " parts)" : " primitives)");
     }
+    std::cout << std::endl;
+}
+
+const char* igvInterface::objectName(const Object3D* object) const {
+    if (object == triangleMesh) return "cow";
+    if (object == articulatedModel) return "robot";
+    if (object == floor) return "floor";
+    return "light";
+}
+
+void igvInterface::drawSelectionRectangle() {
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, window_width, window_height, 0, -1, 1); // window coordinates, y down
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    GLState::disable(GL_LIGHTING);
+    GLState::disable(GL_DEPTH_TEST);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glBegin(GL_LINE_LOOP);
+    glVertex2f(rectangle_x0 + 0.5f, rectangle_y0 + 0.5f);
+    glVertex2f(rectangle_x1 + 0.5f, rectangle_y0 + 0.5f);
+    glVertex2f(rectangle_x1 + 0.5f, rectangle_y1 + 0.5f);
+    glVertex2f(rectangle_x0 + 0.5f, rectangle_y1 + 0.5f);
+    glEnd();
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::enable(GL_LIGHTING);
 
-    glEnable(GL_LIGHTING);
-    glEnable(GL_DITHER);
-    selection_requested = false; // Reset flag
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
 }
 
 void igvInterface::displayFunc() {
     igvInterface* i = &getInstance();
 
-    if (selection_requested) {
-        i->process_selection();
+    Profiler::instance().endFrame();
+    {
+        ProfileScope displayScope("display");
+        i->renderFrame();
+        if (i->idPicker.isPending()) requestRedisplay(); // to collect it
+
+        ProfileScope scope("swap");
+        glutSwapBuffers();
+    }
+    i->frameScheduler.frameDrawn();
+    i->scheduleFrames(); // for animations switched on from a menu
+
+    if (i->crowdMode) {
+        // Average time between frames, to find where the crowd gets too big.
+        using clock = std::chrono::steady_clock;
+        static clock::time_point window_start = clock::now();
+        static int frames = 0;
+        ++frames;
+        double elapsed = std::chrono::duration<double>(clock::now() - window_start).count();
+        if (elapsed >= CROWD_REPORT_INTERVAL_S) {
+            std::cout << "Crowd: " << i->crowd->getCount() << " objects, "
+                      << i->instancedRenderer->getDrawCalls() << " draw calls ("
+                      << (i->instancedRenderer->isInstanced() ? "instanced" : "one per object") << "), "
+                      << i->cullStats.culled << " of " << i->cullStats.tested << " culled, "
+                      << i->renderQueue.getStats().state.filtered << " state changes avoided, "
+                      << elapsed * 1000.0 / frames << " ms/frame" << std::endl;
+            window_start = clock::now();
+            frames = 0;
+        }
+    }
+
+    if (i->renderStatsReport) {
+        // GL state calls per frame, averaged like the crowd's frame time.
+        using clock = std::chrono::steady_clock;
+        static clock::time_point window_start = clock::now();
+        static GLState::Counts window_counts = GLState::getCounts();
+        static int frames = 0;
+        ++frames;
+        double elapsed = std::chrono::duration<double>(clock::now() - window_start).count();
+        if (elapsed >= CROWD_REPORT_INTERVAL_S) {
+            const GLState::Counts& counts = GLState::getCounts();
+            std::cout << "GL state per frame: " << (counts.issued - window_counts.issued) / frames << " calls issued, "
+                      << (counts.filtered - window_counts.filtered) / frames << " filtered" << std::endl;
+            i->printRenderStats();
+            window_start = clock::now();
+            window_counts = counts;
+            frames = 0;
+        }
+    }
+}
+
+void igvInterface::renderFrame() {
+    GpuProfileScope gpuFrameScope("frame");
+
+    {
+        ProfileScope scope("asset uploads");
+        assetLoader->pump(ASSET_UPLOAD_BUDGET_MS);
+    }
+
+    {
+        // The GPU pick requested last frame has been read back by now.
+        ProfileScope scope("id readback");
+        IdPickResult picked;
+        if (idPicker.collect(picked)) handleIdPick(picked);
     }
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
-    i->camera->applyProjection();
-    i->camera->applyView();
+    camera->applyProjection();
+    camera->applyView();
+    cgvTriangleMesh::set_lod_projection(camera->getPixelScale(window_height), camera->isPerspective());
 
     // Apply global ambient light
     GLfloat ambient_light[] = { 0.2f, 0.2f, 0.2f, 1.0f };
-    if (!i->globalAmbientLightOn) {
+    if (!globalAmbientLightOn) {
         ambient_light[0] = 0; ambient_light[1] = 0; ambient_light[2] = 0;
     }
-    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient_light);
+    GLState::lightModelAmbient(ambient_light);
 
     // Apply all other lights
-    for (auto const& light : i->lights) {
+    for (auto const& light : lights) {
         light->apply();
     }
 
-    glShadeModel(i->flatShading ? GL_FLAT : GL_SMOOTH);
+    GLState::shadeModel(flatShading ? GL_FLAT : GL_SMOOTH);
 
     // Draw axes
-    glDisable(GL_LIGHTING);
-    glLineWidth(1.0f);
+    GLState::disable(GL_LIGHTING);
+    GLState::lineWidth(1.0f);
     glBegin(GL_LINES);
     glColor3f(1.0, 0.0, 0.0); glVertex3f(-10, 0, 0); glVertex3f(10, 0, 0);
     glColor3f(0.0, 1.0, 0.0); glVertex3f(0, -10, 0); glVertex3f(0, 10, 0);
     glColor3f(0.0, 0.0, 1.0); glVertex3f(0, 0, -10); glVertex3f(0, 0, 10);
     glEnd();
-    glEnable(GL_LIGHTING);
+    GLState::enable(GL_LIGHTING);
+
+    // Draw objects, skipping what the camera cannot see
+    Frustum frustum = frustumCulling ? camera->getFrustum() : Frustum();
+    cullStats.reset();
+    if (crowdMode) {
+        ProfileScope scope("crowd");
+        GpuProfileScope gpuScope("crowd");
+        instancedRenderer->beginFrame();
+        crowd->draw(*instancedRenderer, *triangleMesh, frustum, cullStats);
+    }
+    {
+        ProfileScope scope("objects");
+        GpuProfileScope gpuScope("objects");
+        drawObjects(frustum);
+    }
+
+    if (idPicker.isPending()) {
+        ProfileScope scope("id pass");
+        GpuProfileScope gpuScope("id pass");
+        idPicker.render(drawList, window_width, window_height);
+    }
+
+    // Things move under a still mouse too, so the hover is picked again
+    // every frame; it only costs a few microseconds.
+    hover = hover_x >= 0 ? pickAt(hover_x, hover_y) : PickResult();
+    {
+        GpuProfileScope gpuScope("overlay");
+        drawHover();
+        if (dragging_rectangle) drawSelectionRectangle();
+        // The HUD's text is drawn with GLUT's fonts, which need a window.
+        if (profilerHud && windowed) Profiler::instance().drawHud(window_width, window_height);
+    }
+}
 
-    // Draw objects
-    i->triangleMesh->draw();
-    i->articulatedModel->draw();
-    i->floor->draw();
+bool igvInterface::runBenchmark(const BenchmarkOptions& options, BenchmarkResult& result) {
+    result = BenchmarkResult();
+    result.width = options.width > 0 ? options.width : 500;
+    result.height = options.height > 0 ? options.height : 500;
+    const bool replay = !options.replay.empty();
+    if (replay) {
+        if (!inputReplay.load(options.replay)) {
+            std::cerr << "Benchmark: could not read input log " << options.replay << std::endl;
+            return false;
+        }
+        // Big enough for every size the window had, unless told otherwise.
+        if (options.width <= 0) inputReplay.getMaxWindowSize(result.width, result.height);
+    }
+
+    OffscreenContext context;
+    std::string error;
+    if (!context.create(result.width, result.height, error)) {
+        std::cerr << "Benchmark: " << error << std::endl;
+        return false;
+    }
+    initGL();
+    reshapeFunc(result.width, result.height);
+    instancedRenderer->setEnabled(options.instanced);
+    result.instanced = instancedRenderer->isInstanced();
+    if (options.scene == "crowd") {
+        if (options.crowdCount > 0) setCrowdCount(options.crowdCount);
+        setCrowdMode(true);
+    }
+    while (assetLoader->busy()) {
+        if (assetLoader->pump(ASSET_UPLOAD_BUDGET_MS) == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
 
-    // Draw light visualizations
-    for (auto const& light : i->lights) {
-        light->draw();
+    result.renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    if (replay) {
+        beginReplay();
+        return runReplayBenchmark(options, result);
+    }
+    result.frameMs.reserve(options.frames);
+
+    using clock = std::chrono::steady_clock;
+    const float two_pi = 6.2831853f;
+    const float radius = camera->getOrbitRadius();
+    float pitch = 0.0f;
+    for (int f = -options.warmupFrames; f < options.frames; ++f) {
+        const float phase = static_cast<float>(f) / options.frames;
+        const float nextPitch = BENCHMARK_PITCH_DEG * std::sin(2.0f * two_pi * phase);
+        camera->orbit(360.0f / options.frames, nextPitch - pitch);
+        pitch = nextPitch;
+        camera->setOrbitRadius(radius * (1.0f - BENCHMARK_DOLLY * std::sin(two_pi * phase)));
+
+        const float time = f / BENCHMARK_ANIMATION_FPS;
+        if (crowdMode) crowd->update(*articulatedModel, time);
+        else articulatedModel->update(time);
+
+        Profiler::instance().endFrame();
+        const std::uint64_t triangles = Profiler::instance().getTriangles();
+        const clock::time_point start = clock::now();
+        renderFrame();
+        glFinish(); // the frame is only done once the GPU is
+        const double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        if (f >= 0) {
+            result.frameMs.push_back(ms);
+            result.triangles += Profiler::instance().getTriangles() - triangles;
+        }
     }
+    result.objects = static_cast<int>(drawList.size()) + (crowdMode ? crowd->getCount() : 0);
+    return true;
+}
 
-    glutSwapBuffers();
+bool igvInterface::runReplayBenchmark(const BenchmarkOptions& options, BenchmarkResult& result) {
+    // The same frames as a window replaying the log would draw: the events
+    // due, then idleFunc, then the frame, with simulated time standing still
+    // through the warm-up.
+    for (int f = 0; f < options.warmupFrames; ++f) {
+        Profiler::instance().endFrame();
+        renderFrame();
+    }
+    glFinish();
+
+    using clock = std::chrono::steady_clock;
+    while (replaying) {
+        idleFunc();
+        Profiler::instance().endFrame();
+        const std::uint64_t triangles = Profiler::instance().getTriangles();
+        const clock::time_point start = clock::now();
+        renderFrame();
+        glFinish();
+        result.frameMs.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+        result.triangles += Profiler::instance().getTriangles() - triangles;
+    }
+    result.objects = static_cast<int>(drawList.size()) + (crowdMode ? crowd->getCount() : 0);
+    return true;
 }
 
-void igvInterface::idleFunc() {
-    static float last_time = 0;
-    float current_time = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
-    if (last_time == 0) last_time = current_time;
-    float delta_time = current_time - last_time;
-    last_time = current_time;
+void igvInterface::drawObjects(const Frustum& frustum) {
+    // The showcase objects, the floor, and the light gizmos, in drawing order.
+    drawList.clear();
+    if (!crowdMode) {
+        drawList.push_back(triangleMesh);
+        drawList.push_back(articulatedModel);
+    }
+    drawList.push_back(floor);
+    for (auto const& light : lights) drawList.push_back(light.get());
+
+    // Test all the boxes in one batch. Objects without bounds, like the cow
+    // while it loads, are always drawn.
+    objectVisible.assign(drawList.size(), 1);
+    boundedObjects.clear();
+    objectBounds.clear();
+    for (std::size_t k = 0; k < drawList.size(); ++k) {
+        if (!drawList[k]->hasBounds()) continue;
+        boundedObjects.push_back(k);
+        objectBounds.push_back(drawList[k]->getWorldBounds());
+    }
+    boundedVisible.resize(boundedObjects.size());
+    frustum.cull(objectBounds, boundedObjects.size(), boundedVisible.data(), &cullStats);
+    for (std::size_t b = 0; b < boundedObjects.size(); ++b) objectVisible[boundedObjects[b]] = boundedVisible[b];
+
+    renderQueue.clear();
+    for (std::size_t k = 0; k < drawList.size(); ++k) {
+        if (objectVisible[k]) drawList[k]->submit(renderQueue);
+    }
+    renderQueue.execute();
+}
 
+void igvInterface::idleFunc() {
     igvInterface* i = &getInstance();
-    if (i->animateModel) i->articulatedModel->update(current_time);
-    if (i->animateCamera) i->camera->orbit(delta_time * 10.0f, 0);
-
-    if (i->animateLight) {
-        if (!i->lights.empty()) {
-            float radius = 7.0f;
-            float speed = 0.5f;
-            float light_x = sin(current_time * speed) * radius;
-            float light_z = cos(current_time * speed) * radius;
-            i->lights[0]->setPosition(light_x, 5.0f, light_z);
+    if (i->windowed) {
+        if (!i->needsFrames()) {
+            // Nothing moves: let GLUT sleep until the next event instead of
+            // calling back straight away. scheduleFrames() restarts us.
+            glutIdleFunc(nullptr);
+            i->idleRunning = false;
+            i->frameScheduler.stop();
+            return;
         }
+        i->frameScheduler.waitForNextFrame();
     }
 
-    glutPostRedisplay();
+    ProfileScope scope("idle");
+    if (i->replaying) i->stepReplay();
+    i->applySimulation(i->clock());
+    requestRedisplay();
+}
+
+void igvInterface::applySimulation(double nowMs) {
+    simulation->setAnimations(animateModel, animateCamera, animateLight);
+    if (!simulation->isRunning()) simulation->advanceTo(nowMs);
+    if (!simulation->sample(nowMs, simulated)) return;
+
+    if (animateModel) {
+        if (crowdMode) crowd->pose(simulated.crowdPoses);
+        else articulatedModel->set_pose(simulated.robotPose);
+    }
+    // The orbit only grows while the camera animates; the rest of the user's
+    // orbiting is theirs. It is wrapped to [0, 360), so a step across 0
+    // comes out near -360 and is unwrapped.
+    float orbitDelta = simulated.cameraOrbitDeg - cameraOrbitApplied;
+    if (orbitDelta < -180.0f) orbitDelta += 360.0f;
+    else if (orbitDelta > 180.0f) orbitDelta -= 360.0f;
+    camera->orbit(orbitDelta, 0);
+    cameraOrbitApplied = simulated.cameraOrbitDeg;
+    if (animateLight && !lights.empty()) {
+        lights[0]->setPosition(simulated.lightPosition[0], simulated.lightPosition[1], simulated.lightPosition[2]);
+    }
 }
 
 void igvInterface::mouseFunc(int button, int state, int x, int y) {
     igvInterface* i = &getInstance();
     if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
-        if (!i->articulatedInteractionKeyboard) {
-            selection_requested = true;
-            selection_x = x;
-            selection_y = y;
-            last_mouse_y = y;
-            glutPostRedisplay(); // Request a redraw to process selection
+        left_button_down = true;
+        last_mouse_y = y;
+        selected_dof_by_mouse = -1;
+        if (i->articulatedInteractionKeyboard) return;
+
+        if (i->gpuPicking) {
+            if (i->inputModifiers & GLUT_ACTIVE_SHIFT) {
+                dragging_rectangle = true;
+                rectangle_x0 = rectangle_x1 = x;
+                rectangle_y0 = rectangle_y1 = y;
+            } else {
+                i->idPicker.request(x, y); // answered in handleIdPick next frame
+                rectangle_pick_pending = false;
+            }
+        } else {
+            PickResult picked = i->pickAt(x, y);
+            if (picked.object == i->articulatedModel && picked.part >= 0) {
+                selected_dof_by_mouse =
+                    ArticulatedModel::part_dof(static_cast<ArticulatedModel::Part>(picked.part));
+            }
+            if (selected_dof_by_mouse >= 0) i->articulatedModel->set_dof(selected_dof_by_mouse);
         }
+        requestRedisplay();
     }
     if (button == GLUT_LEFT_BUTTON && state == GLUT_UP) {
+        left_button_down = false;
         selected_dof_by_mouse = -1;
+        if (dragging_rectangle) {
+            dragging_rectangle = false;
+            i->idPicker.request(std::min(rectangle_x0, rectangle_x1), std::min(rectangle_y0, rectangle_y1),
+                                std::abs(rectangle_x1 - rectangle_x0) + 1, std::abs(rectangle_y1 - rectangle_y0) + 1);
+            rectangle_pick_pending = true;
+            requestRedisplay();
+        }
     }
 }
 
 void igvInterface::motionFunc(int x, int y) {
     igvInterface* i = &getInstance();
-    if (selected_dof_by_mouse != -1) {
+    if (dragging_rectangle) {
+        rectangle_x1 = x;
+        rectangle_y1 = y;
+        requestRedisplay();
+    } else if (selected_dof_by_mouse != -1) {
         float dy = y - last_mouse_y;
         if (dy > 0) i->articulatedModel->decrease_dof();
         if (dy < 0) i->articulatedModel->increase_dof();
         last_mouse_y = y;
-        glutPostRedisplay();
+        requestRedisplay();
+    }
+}
+
+void igvInterface::passiveMotionFunc(int x, int y) {
+    igvInterface* i = &getInstance();
+    hover_x = x;
+    hover_y = y;
+    // Only redraw when the mouse moved onto something else.
+    if (!i->pickAt(x, y).sameTarget(i->hover)) requestRedisplay();
+}
+
+void igvInterface::entryFunc(int state) {
+    if (state == GLUT_LEFT) {
+        hover_x = hover_y = -1;
+        requestRedisplay();
+    }
+}
+
+void igvInterface::handleInput(const InputEvent& event) {
+    const bool escape = event.type == InputEvent::KEY && event.code == 27;
+    if (replaying) {
+        // The window's real size still applies; the rest of the user's input
+        // would put the replay out of step.
+        if (event.type == InputEvent::RESHAPE) reshapeFunc(event.x, event.y);
+        else if (escape) dispatch(event);
+        return;
+    }
+    if (!escape) inputRecorder.record(event, clock());
+    dispatch(event);
+    scheduleFrames();
+}
+
+void igvInterface::dispatch(const InputEvent& event) {
+    inputModifiers = event.modifiers;
+    switch (event.type) {
+        case InputEvent::KEY: keyboardFunc(static_cast<unsigned char>(event.code), event.x, event.y); break;
+        case InputEvent::SPECIAL_KEY: specialKeyboardFunc(event.code, event.x, event.y); break;
+        case InputEvent::MOUSE: mouseFunc(event.code, event.state, event.x, event.y); break;
+        case InputEvent::MOTION: motionFunc(event.x, event.y); break;
+        case InputEvent::PASSIVE_MOTION: passiveMotionFunc(event.x, event.y); break;
+        case InputEvent::ENTRY: entryFunc(event.state); break;
+        case InputEvent::MENU: menuFunc(event.code, event.state); break;
+        case InputEvent::RESHAPE:
+            // In a window, the recorded size is asked of the window manager
+            // and arrives through reshapeFunc like any other resize.
+            if (replaying && windowed) glutReshapeWindow(event.x, event.y);
+            else reshapeFunc(event.x, event.y);
+            break;
+    }
+    inputModifiers = 0;
+}
+
+void igvInterface::stepReplay() {
+    // The session starts once its assets are in, whatever they took to load.
+    if (assetLoader->busy()) return;
+    replayTimeMs += REPLAY_STEP_MS;
+    InputEvent event;
+    while (inputReplay.next(replayTimeMs, event)) dispatch(event);
+    if (inputReplay.isFinished()) {
+        replaying = false;
+        std::cout << "Replay finished: " << inputReplay.getCount() << " events over "
+                  << inputReplay.getDurationMs() / 1000.0 << " s" << std::endl;
+        // Live from here on. Time carries on from where the replay left the
+        // simulation, which now gets its own thread as in a live session.
+        clock = steady_clock_from(replayTimeMs);
+        if (windowed) simulation->start(clock);
+    }
+}
+
+bool igvInterface::startRecording(const std::string& path) {
+    if (!inputRecorder.start(path, window_width, window_height, clock())) {
+        std::cerr << "Could not write input log " << path << std::endl;
+        return false;
     }
+    std::cout << "Recording input to " << path << std::endl;
+    return true;
+}
+
+bool igvInterface::startReplay(const std::string& path) {
+    if (!inputReplay.load(path)) {
+        std::cerr << "Could not read input log " << path << std::endl;
+        return false;
+    }
+    std::cout << "Replaying " << inputReplay.getCount() << " input events from " << path << std::endl;
+    beginReplay();
+    return true;
+}
+
+void igvInterface::beginReplay() {
+    inputReplay.rewind();
+    replaying = true;
+    replayTimeMs = 0.0;
+    clock = [this] { return replayTimeMs; };
+    InputEvent initialSize = {};
+    initialSize.type = InputEvent::RESHAPE;
+    initialSize.x = static_cast<std::int16_t>(inputReplay.getWindowWidth());
+    initialSize.y = static_cast<std::int16_t>(inputReplay.getWindowHeight());
+    dispatch(initialSize);
+}
+
+void igvInterface::requestRedisplay() {
+    if (getInstance().windowed) glutPostRedisplay();
+}
+
+bool igvInterface::needsFrames() {
+    return animateModel || animateCamera || animateLight || replaying || assetLoader->busy();
+}
+
+void igvInterface::scheduleFrames() {
+    if (windowed && !idleRunning && needsFrames()) {
+        glutIdleFunc(idleFunc);
+        idleRunning = true;
+    }
+}
+
+static InputEvent input_event(InputEvent::Type type, int modifiers, int code, int state, int x, int y) {
+    InputEvent event = {};
+    event.type = type;
+    event.modifiers = static_cast<std::uint8_t>(modifiers);
+    event.code = static_cast<std::uint16_t>(code);
+    event.state = static_cast<std::int16_t>(state);
+    event.x = static_cast<std::int16_t>(x);
+    event.y = static_cast<std::int16_t>(y);
+    return event;
+}
+
+template <int menu>
+void igvInterface::menuCallback(int option) {
+    getInstance().handleInput(input_event(InputEvent::MENU, 0, menu, option, 0, 0));
 }
 
 void igvInterface::create_menus() {
-    int shading_menu = glutCreateMenu(shading_menu_callback);
+    int shading_menu = glutCreateMenu(menuCallback<SHADING_MENU>);
     glutAddMenuEntry("Flat", 1);
     glutAddMenuEntry("Smooth", 2);
 
-    int interaction_menu = glutCreateMenu(interaction_menu_callback);
+    int interaction_menu = glutCreateMenu(menuCallback<INTERACTION_MENU>);
     glutAddMenuEntry("Keyboard", 1);
     glutAddMenuEntry("Mouse (Picking)", 2);
+    glutAddMenuEntry("Mouse (GPU ID Buffer, Shift-Drag Selects)", 3);
 
-    int animation_menu = glutCreateMenu(animation_menu_callback);
+    int animation_menu = glutCreateMenu(menuCallback<ANIMATION_MENU>);
     glutAddMenuEntry("Toggle Model Animation", 1);
     glutAddMenuEntry("Toggle Camera Animation", 2);
     glutAddMenuEntry("Toggle Light Animation", 3); // Added light animation menu
 
-    int material_menu = glutCreateMenu(material_menu_callback);
+    int material_menu = glutCreateMenu(menuCallback<MATERIAL_MENU>);
     glutAddMenuEntry("Rubber", 1);
     glutAddMenuEntry("Plastic", 2);
     glutAddMenuEntry("Metal", 3);
 
-    int texture_filter_menu = glutCreateMenu(texture_filter_menu_callback);
+    int texture_filter_menu = glutCreateMenu(menuCallback<TEXTURE_FILTER_MENU>);
     glutAddMenuEntry("Nearest, Nearest", 1);
     glutAddMenuEntry("Linear, Nearest", 2);
     glutAddMenuEntry("Nearest, Linear", 3);
     glutAddMenuEntry("Linear, Linear", 4);
 
-    int texture_main_menu = glutCreateMenu(texture_menu_callback);
+    int texture_main_menu = glutCreateMenu(menuCallback<TEXTURE_MENU>);
     glutAddMenuEntry("Toggle Textures", 1);
     glutAddMenuEntry("Grid", 2);
     glutAddMenuEntry("Water", 3);
     glutAddMenuEntry("Bricks", 4);
     glutAddSubMenu("Filters", texture_filter_menu);
 
-    int light_select_menu = glutCreateMenu(light_select_menu_callback);
+    int light_select_menu = glutCreateMenu(menuCallback<LIGHT_SELECT_MENU>);
     glutAddMenuEntry("None", 1);
     glutAddMenuEntry("Point Light", 2);
     glutAddMenuEntry("Spotlight", 3);
 
-    int light_main_menu = glutCreateMenu(light_menu_callback);
+    int light_main_menu = glutCreateMenu(menuCallback<LIGHT_MENU>);
     glutAddMenuEntry("Toggle Global Ambient", 1);
     glutAddMenuEntry("Toggle Point Light", 2);
     glutAddMenuEntry("Toggle Directional Light", 3);
     glutAddMenuEntry("Toggle Spotlight", 4);
     glutAddSubMenu("Move Light", light_select_menu);
 
-    glutCreateMenu(menu_callback);
+    int scene_menu = glutCreateMenu(menuCallback<SCENE_MENU>);
+    glutAddMenuEntry("Showcase", 1);
+    glutAddMenuEntry("Crowd", 2);
+    glutAddMenuEntry("Toggle Instancing", 3);
+    glutAddMenuEntry("Toggle Frustum Culling", 4);
+    glutAddMenuEntry("Toggle Mesh LOD", 5);
+    glutAddMenuEntry("Toggle Profiler HUD", 6);
+    glutAddMenuEntry("Export Profile CSV", 7);
+
+    glutCreateMenu(menuCallback<MAIN_MENU>);
+    glutAddSubMenu("Scene", scene_menu);
     glutAddSubMenu("Lights", light_main_menu);
     glutAddSubMenu("Textures", texture_main_menu);
     glutAddSubMenu("Floor Material", material_menu);
@@ -373,13 +899,24 @@ void igvInterface::create_menus() {
 }
 
 void igvInterface::initialize_callbacks() {
-    glutKeyboardFunc(keyboardFunc);
-    glutSpecialFunc(specialKeyboardFunc);
-    glutReshapeFunc(reshapeFunc);
+    // GLUT only reports the modifiers during key and button callbacks.
+    glutKeyboardFunc([](unsigned char key, int x, int y) {
+        getInstance().handleInput(input_event(InputEvent::KEY, glutGetModifiers(), key, 0, x, y));
+    });
+    glutSpecialFunc([](int key, int x, int y) {
+        getInstance().handleInput(input_event(InputEvent::SPECIAL_KEY, glutGetModifiers(), key, 0, x, y));
+    });
+    glutReshapeFunc([](int w, int h) { getInstance().handleInput(input_event(InputEvent::RESHAPE, 0, 0, 0, w, h)); });
     glutDisplayFunc(displayFunc);
-    glutIdleFunc(idleFunc);
-    glutMouseFunc(mouseFunc);
-    glutMotionFunc(motionFunc);
+    glutIdleFunc(idleFunc); // stops itself once nothing animates
+    idleRunning = true;
+    glutMouseFunc([](int button, int state, int x, int y) {
+        getInstance().handleInput(input_event(InputEvent::MOUSE, glutGetModifiers(), button, state, x, y));
+    });
+    glutMotionFunc([](int x, int y) { getInstance().handleInput(input_event(InputEvent::MOTION, 0, 0, 0, x, y)); });
+    glutPassiveMotionFunc(
+        [](int x, int y) { getInstance().handleInput(input_event(InputEvent::PASSIVE_MOTION, 0, 0, 0, x, y)); });
+    glutEntryFunc([](int state) { getInstance().handleInput(input_event(InputEvent::ENTRY, 0, 0, state, 0, 0)); });
 }
 
 void igvInterface::selectObject(int objectNum) {
@@ -395,6 +932,14 @@ void igvInterface::selectObject(int objectNum) {
 
 void igvInterface::setShading(bool flat) { flatShading = flat; }
 void igvInterface::setInteraction(bool keyboard) { articulatedInteractionKeyboard = keyboard; }
+
+void igvInterface::setGpuPicking(bool enabled) {
+    if (enabled && !IdPicker::isSupported()) {
+        std::cerr << "GPU picking needs framebuffer and pixel buffer objects; using ray picking" << std::endl;
+        enabled = false;
+    }
+    gpuPicking = enabled;
+}
 void igvInterface::toggleAnimateModel() { animateModel = !animateModel; }
 void igvInterface::toggleAnimateCamera() { animateCamera = !animateCamera; }
 void igvInterface::toggleAnimateLight() { animateLight = !animateLight; } // Implemented toggle
@@ -423,63 +968,154 @@ void igvInterface::moveSelectedLight(float dx, float dy, float dz) {
     }
 }
 
-void menu_callback(int option) {
-    igvInterface::getInstance().selectObject(option);
-    glutPostRedisplay();
+void igvInterface::setCrowdMode(bool enabled) {
+    if (enabled == crowdMode) return;
+    crowdMode = enabled;
+    if (crowdMode) {
+        if (crowd->getCount() != crowdCount) crowd->build(crowdCount);
+        // Pull the camera back far enough to see the whole grid.
+        showcaseOrbitRadius = camera->getOrbitRadius();
+        showcaseFarPlane = camera->getFarPlane();
+        camera->setOrbitRadius(crowd->getExtent() * 1.5f);
+        camera->setFarPlane(crowd->getExtent() * 6.0f);
+    } else {
+        camera->setOrbitRadius(showcaseOrbitRadius);
+        camera->setFarPlane(showcaseFarPlane);
+    }
+    simulation->setCrowdPhases(crowdMode ? crowd->getPhases() : std::vector<float>());
 }
 
-void shading_menu_callback(int option) {
-    igvInterface::getInstance().setShading(option == 1);
-    glutPostRedisplay();
+void igvInterface::setCrowdCount(int count) {
+    if (count < 1) count = 1;
+    crowdCount = count;
+    if (crowdMode) {
+        crowd->build(crowdCount);
+        camera->setFarPlane(crowd->getExtent() * 6.0f);
+        simulation->setCrowdPhases(crowd->getPhases());
+    }
+    std::cout << "Crowd size: " << crowdCount << std::endl;
 }
 
-void interaction_menu_callback(int option) {
-    igvInterface::getInstance().setInteraction(option == 1);
+void igvInterface::toggleInstancing() {
+    instancedRenderer->setEnabled(!instancedRenderer->isEnabled());
+    if (instancedRenderer->isEnabled() && !instancedRenderer->isAvailable()) {
+        std::cout << "Instancing on, but unsupported here: drawing one call per instance" << std::endl;
+    } else {
+        std::cout << "Instancing " << (instancedRenderer->isEnabled() ? "on" : "off") << std::endl;
+    }
 }
 
-void animation_menu_callback(int option) {
-    if (option == 1) igvInterface::getInstance().toggleAnimateModel();
-    if (option == 2) igvInterface::getInstance().toggleAnimateCamera();
-    if (option == 3) igvInterface::getInstance().toggleAnimateLight(); // Added handler for light animation
+void igvInterface::toggleFrustumCulling() {
+    frustumCulling = !frustumCulling;
+    std::cout << "Frustum culling " << (frustumCulling ? "on" : "off") << " (last frame: "
+              << cullStats.culled << " of " << cullStats.tested << " objects culled)" << std::endl;
 }
 
-void material_menu_callback(int option) {
-    igvInterface::getInstance().setFloorMaterial(option - 1);
-    glutPostRedisplay();
+void igvInterface::toggleMeshLod() {
+    cgvTriangleMesh::set_lod_enabled(!cgvTriangleMesh::is_lod_enabled());
+    std::cout << "Mesh LOD " << (cgvTriangleMesh::is_lod_enabled() ? "on" : "off") << std::endl;
 }
 
-void texture_menu_callback(int option) {
-    switch (option) {
-        case 1: igvInterface::getInstance().toggleTexture(); break;
-        case 2: igvInterface::getInstance().setFloorTexture(0); break;
-        case 3: igvInterface::getInstance().setFloorTexture(1); break;
-        case 4: igvInterface::getInstance().setFloorTexture(2); break;
+void igvInterface::toggleRenderStats() {
+    renderStatsReport = !renderStatsReport;
+    std::cout << "Render stats " << (renderStatsReport ? "on" : "off") << std::endl;
+    if (renderStatsReport) printRenderStats();
+
+    // The frame report runs off a timer, so it keeps coming while no frames are drawn.
+    ++frameReportGeneration;
+    if (renderStatsReport && windowed) {
+        frameScheduler.takeReport();
+        glutTimerFunc(static_cast<unsigned>(CROWD_REPORT_INTERVAL_S * 1000.0), frameReportFunc, frameReportGeneration);
     }
-    glutPostRedisplay();
 }
 
-void texture_filter_menu_callback(int option) {
-    igvInterface::getInstance().setTextureFilter(option - 1);
-    glutPostRedisplay();
+void igvInterface::frameReportFunc(int generation) {
+    igvInterface* i = &getInstance();
+    if (generation != i->frameReportGeneration) return; // switched off since
+    const FrameScheduler::Report report = i->frameScheduler.takeReport();
+    std::cout << "Frames: " << report.frames << " in " << report.seconds << " s ("
+              << report.frames / report.seconds << " fps, ";
+    if (i->frameScheduler.getTargetFps() > 0.0) std::cout << "paced to " << i->frameScheduler.getTargetFps();
+    else std::cout << "unpaced";
+    std::cout << "), CPU ";
+    if (report.cpu >= 0.0) std::cout << report.cpu * 100.0 << "%" << std::endl;
+    else std::cout << "unknown" << std::endl;
+    glutTimerFunc(static_cast<unsigned>(CROWD_REPORT_INTERVAL_S * 1000.0), frameReportFunc, generation);
+}
+
+void igvInterface::toggleProfiler() {
+    profilerHud = !profilerHud;
+    Profiler::instance().setGpuTiming(profilerHud);
+    std::cout << "Profiler HUD " << (profilerHud ? "on" : "off") << std::endl;
 }
 
-void light_menu_callback(int option) {
-    switch (option) {
-        case 1: igvInterface::getInstance().toggleLight(-1); break; // Ambient
-        case 2: igvInterface::getInstance().toggleLight(0); break;  // Point
-        case 3: igvInterface::getInstance().toggleLight(1); break;  // Directional
-        case 4: igvInterface::getInstance().toggleLight(2); break;  // Spot
+void igvInterface::exportProfile() const {
+    if (Profiler::instance().writeCsv(PROFILE_CSV_PATH)) {
+        std::cout << "Wrote " << PROFILE_CSV_PATH << std::endl;
+    } else {
+        std::cerr << "Could not write " << PROFILE_CSV_PATH << std::endl;
     }
-    glutPostRedisplay();
 }
 
-void light_select_menu_callback(int option) {
-    switch (option) {
-        case 1: igvInterface::getInstance().selectLight(-1); break; // None
-        case 2: igvInterface::getInstance().selectLight(0); break;  // Point
-        case 3: igvInterface::getInstance().selectLight(2); break;  // Spot
+void igvInterface::printRenderStats() const {
+    const RenderQueue::Stats& stats = renderQueue.getStats();
+    std::cout << "Render queue (last frame): " << stats.packets << " packets, " << stats.state.issued
+              << " state changes, " << stats.state.filtered << " of " << stats.state.requested() << " avoided"
+              << std::endl;
+}
+
+void igvInterface::menuFunc(int menu, int option) {
+    igvInterface* i = &getInstance();
+    switch (menu) {
+        case MAIN_MENU: i->selectObject(option); break;
+        case SHADING_MENU: i->setShading(option == 1); break;
+        case INTERACTION_MENU:
+            i->setInteraction(option == 1);
+            i->setGpuPicking(option == 3);
+            break;
+        case ANIMATION_MENU:
+            if (option == 1) i->toggleAnimateModel();
+            if (option == 2) i->toggleAnimateCamera();
+            if (option == 3) i->toggleAnimateLight(); // Added handler for light animation
+            break;
+        case MATERIAL_MENU: i->setFloorMaterial(option - 1); break;
+        case TEXTURE_MENU:
+            switch (option) {
+                case 1: i->toggleTexture(); break;
+                case 2: i->setFloorTexture(0); break;
+                case 3: i->setFloorTexture(1); break;
+                case 4: i->setFloorTexture(2); break;
+            }
+            break;
+        case TEXTURE_FILTER_MENU: i->setTextureFilter(option - 1); break;
+        case LIGHT_MENU:
+            switch (option) {
+                case 1: i->toggleLight(-1); break; // Ambient
+                case 2: i->toggleLight(0); break;  // Point
+                case 3: i->toggleLight(1); break;  // Directional
+                case 4: i->toggleLight(2); break;  // Spot
+            }
+            break;
+        case LIGHT_SELECT_MENU:
+            switch (option) {
+                case 1: i->selectLight(-1); break; // None
+                case 2: i->selectLight(0); break;  // Point
+                case 3: i->selectLight(2); break;  // Spot
+            }
+            break;
+        case SCENE_MENU:
+            switch (option) {
+                case 1: i->setCrowdMode(false); break;
+                case 2: i->setCrowdMode(true); break;
+                case 3: i->toggleInstancing(); break;
+                case 4: i->toggleFrustumCulling(); break;
+                case 5: i->toggleMeshLod(); break;
+                case 6: i->toggleProfiler(); break;
+                case 7: i->exportProfile(); break;
+            }
+            break;
     }
-    glutPostRedisplay();
+    requestRedisplay();
 }
 
 int igvInterface::get_window_width() { return window_width; }
@@ -7,6 +7,7 @@
 #include <GL/glut.h>
 #endif
 
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
@@ -15,12 +16,55 @@
 #include "ArticulatedModel.h"
 #include "src/Floor.h"
 #include "src/Light.h"
+#include "src/AssetLoader.h"
+#include "src/CrowdScene.h"
+#include "src/InstancedRenderer.h"
+#include "src/Frustum.h"
+#include "src/Picker.h"
+#include "src/IdPicker.h"
+#include "src/RenderQueue.h"
+#include "src/GLState.h"
+#include "src/Profiler.h"
+#include "src/Benchmark.h"
+#include "src/InputLog.h"
+#include "src/FrameScheduler.h"
+#include "src/Simulation.h"
 
 class igvInterface {
 private:
     cgvTriangleMesh* triangleMesh;
     ArticulatedModel* articulatedModel;
     Floor* floor;
+    AssetLoader* assetLoader;
+
+    // Crowd mode replaces the showcase cow and robot with a grid of copies.
+    CrowdScene* crowd;
+    InstancedRenderer* instancedRenderer;
+    bool crowdMode;
+    int crowdCount;
+    float showcaseOrbitRadius, showcaseFarPlane;
+
+    // Frustum culling of the objects and crowd, with last frame's counts.
+    bool frustumCulling;
+    CullStats cullStats;
+    std::vector<Object3D*> drawList;
+    // The visible objects' draws, sorted by state each frame.
+    RenderQueue renderQueue;
+    bool renderStatsReport;
+    bool profilerHud; // timings on screen, GPU ones included
+    std::vector<std::size_t> boundedObjects; // drawList indices, in objectBounds order
+    BoundingBoxArray objectBounds;
+    std::vector<unsigned char> objectVisible, boundedVisible;
+
+    // Ray picking over drawList: clicks select the robot's DoFs, and what is
+    // under the resting mouse is outlined.
+    Picker picker;
+    PickResult hover;
+
+    // GPU picking instead: clicks and shift-drag rectangles are answered
+    // from an ID buffer read back a frame later.
+    bool gpuPicking;
+    IdPicker idPicker;
     
     std::vector<std::unique_ptr<Light>> lights;
     int selectedLight;
@@ -41,12 +85,67 @@ private:
 
     int window_width = 0;
     int window_height = 0;
+    bool windowed = false; // false while rendering offscreen, without GLUT
+
+    // Every input event goes through handleInput, so a session can be
+    // recorded and replayed through the same handlers. Animation reads the
+    // time from clock (milliseconds), which a replay drives in fixed steps.
+    // The clock may be called from the simulation thread.
+    InputRecorder inputRecorder;
+    InputReplay inputReplay;
+    bool replaying = false;
+    double replayTimeMs = 0.0;
+    int inputModifiers = 0; // GLUT_ACTIVE_* bits of the event being handled
+    std::function<double()> clock;
+
+    // Redraws happen on request; idleFunc only runs, paced to the target
+    // frame rate, while something animates.
+    FrameScheduler frameScheduler;
+    bool idleRunning = false;
+
+    // The animations, stepped at a fixed rate on their own thread (on the
+    // render thread during a replay) and drawn interpolated.
+    Simulation* simulation;
+    SimulationState simulated;     // this frame's
+    float cameraOrbitApplied = 0.0f; // of simulated.cameraOrbitDeg, already turned
+    int frameReportGeneration = 0; // tells the live report timer from stale ones
 
     static igvInterface* _instance;
 
-    void process_selection();
+    PickResult pickAt(int x, int y);
+    void drawHover();
+    void handleIdPick(const IdPickResult& result);
+    void drawSelectionRectangle();
+    const char* objectName(const Object3D* object) const;
     void setupLights();
+    void applySimulation(double nowMs);
     void initGLResources(); // New method
+    void initGL();           // GL state and resources, once a context is current
+    // Everything displayFunc draws, without touching GLUT.
+    void renderFrame();
+    void drawObjects(const Frustum& frustum);
+    void handleInput(const InputEvent& event);
+    void dispatch(const InputEvent& event);
+    // The menus, as a MENU event's code. Recorded in logs: only append.
+    enum Menu {
+        MAIN_MENU, SHADING_MENU, INTERACTION_MENU, ANIMATION_MENU, MATERIAL_MENU, TEXTURE_MENU,
+        TEXTURE_FILTER_MENU, LIGHT_MENU, LIGHT_SELECT_MENU, SCENE_MENU
+    };
+    // The GLUT callback of a menu. Selections go through handleInput like any
+    // other input, so that they are recorded and replayed with it.
+    template <int menu> static void menuCallback(int option);
+    // Replays inputReplay from its start, already loaded.
+    void beginReplay();
+    // Advances the replay by one step and handles the events now due.
+    void stepReplay();
+    bool runReplayBenchmark(const BenchmarkOptions& options, BenchmarkResult& result);
+    static void requestRedisplay(); // glutPostRedisplay, when there is a window
+    // True while frames must keep coming without input: animations, a
+    // replay, or assets still loading.
+    bool needsFrames();
+    // Restarts idleFunc if it stopped and something now needs frames.
+    void scheduleFrames();
+    static void frameReportFunc(int generation);
 
 public:
     static igvInterface& getInstance();
@@ -59,18 +158,34 @@ public:
     static void displayFunc();
     static void mouseFunc(int button, int state, int x, int y);
     static void motionFunc(int x, int y);
+    static void passiveMotionFunc(int x, int y);
+    static void entryFunc(int state);
     static void idleFunc();
+    // An entry of a Menu, numbered as create_menus numbers them.
+    static void menuFunc(int menu, int option);
 
     void configure_environment(int argc, char** argv, int _window_width, int _window_height, int _pos_X, int _pos_Y, std::string _title);
     void initialize_callbacks();
     void start_display_loop();
+    // Renders offscreen instead of opening a window; see Benchmark.h.
+    bool runBenchmark(const BenchmarkOptions& options, BenchmarkResult& result);
     void create_menus();
 
+    // --record FILE: write every input event to FILE. --replay FILE: feed
+    // FILE's events back instead of the user's, one 60th of a second per
+    // frame. Menu selections are recorded too.
+    bool startRecording(const std::string& path);
+    bool startReplay(const std::string& path);
+    void setClock(std::function<double()> _clock) { clock = std::move(_clock); }
+    // --fps N: the rate animated frames are paced to; 0 for as fast as possible.
+    void setFrameRate(double fps) { frameScheduler.setTargetFps(fps); }
+
     void selectObject(int objectNum);
 
     // Menu callbacks
     void setShading(bool flat);
     void setInteraction(bool keyboard);
+    void setGpuPicking(bool enabled);
     void toggleAnimateModel();
     void toggleAnimateCamera();
     void toggleAnimateLight(); // Added for light animation
@@ -81,6 +196,21 @@ public:
     void toggleLight(int lightIndex);
     void selectLight(int lightIndex);
     void moveSelectedLight(float dx, float dy, float dz);
+    void setCrowdMode(bool enabled);
+    void setCrowdCount(int count);
+    void toggleInstancing();
+    void toggleFrustumCulling();
+    void toggleMeshLod();
+    // 'r': every few seconds, print the GL state calls per frame, issued and
+    // filtered by GLState, with the render queue's share, and the frame rate
+    // and CPU use, idle periods included.
+    void toggleRenderStats();
+    void printRenderStats() const;
+    // 'h': time the GPU passes too and show all timings on screen; 'e':
+    // write them to profile.csv.
+    void toggleProfiler();
+    void exportProfile() const;
+    const CullStats& getCullStats() const { return cullStats; }
 
     int get_window_width();
     int get_window_height();
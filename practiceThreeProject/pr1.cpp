@@ -1,9 +1,29 @@
 #include <cstdlib>
+#include <cstring>
+#include <iostream>
 
 #include "igvInterface.h"
 
 
 int main(int argc, char **argv) {
+	// --benchmark renders offscreen and prints timings instead (see Benchmark.h)
+	if (Benchmark::isRequested(argc, argv)) {
+		BenchmarkOptions options;
+		if (!Benchmark::parseArguments(argc, argv, options)) return 1;
+		if (options.jobs) return Benchmark::runJobScaling(std::cout, options) ? 0 : 1;
+		if (options.dedup) return Benchmark::runDedup(std::cout, options) ? 0 : 1;
+		if (options.math) return Benchmark::runMath(std::cout) ? 0 : 1;
+
+		// stdout is for the JSON alone; the usual chatter goes to stderr.
+		std::streambuf* stdout_buffer = std::cout.rdbuf(std::cerr.rdbuf());
+		BenchmarkResult result;
+		bool ok = igvInterface::getInstance().runBenchmark(options, result);
+		std::cout.rdbuf(stdout_buffer);
+		if (!ok) return 1;
+		Benchmark::writeJson(std::cout, options, result);
+		return 0;
+	}
+
 	// initializes the display window
 	igvInterface::getInstance().configure_environment(argc, argv
 	                                                  , 500, 500 // window size
@@ -11,6 +31,25 @@ int main(int argc, char **argv) {
 	                                                  , "CGIV: Practice 0" // window title
 	);
 
+	// --crowd N starts in crowd mode with N objects
+	for (int a = 1; a + 1 < argc; ++a) {
+		if (std::strcmp(argv[a], "--crowd") == 0) {
+			igvInterface::getInstance().setCrowdCount(std::atoi(argv[a + 1]));
+			igvInterface::getInstance().setCrowdMode(true);
+		}
+	}
+
+	// --fps N paces animated frames to N per second (0: unpaced)
+	for (int a = 1; a + 1 < argc; ++a) {
+		if (std::strcmp(argv[a], "--fps") == 0) igvInterface::getInstance().setFrameRate(std::atof(argv[a + 1]));
+	}
+
+	// --record FILE logs the session's input; --replay FILE plays one back
+	for (int a = 1; a + 1 < argc; ++a) {
+		if (std::strcmp(argv[a], "--record") == 0 && !igvInterface::getInstance().startRecording(argv[a + 1])) return 1;
+		if (std::strcmp(argv[a], "--replay") == 0 && !igvInterface::getInstance().startReplay(argv[a + 1])) return 1;
+	}
+
 	// sets the callback functions for event management
 	igvInterface::getInstance().initialize_callbacks();
 
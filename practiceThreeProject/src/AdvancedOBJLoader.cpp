@@ -1,126 +1,331 @@
 #include "AdvancedOBJLoader.h"
-#include <fstream>
-#include <sstream>
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "VertexIndexMap.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <iostream>
-#include <map>
 
 struct VertexTuple {
     unsigned int v_idx, n_idx;
-    bool operator<(const VertexTuple& other) const {
-        if (v_idx != other.v_idx) return v_idx < other.v_idx;
-        return n_idx < other.n_idx;
+};
+
+// The file is tokenized in place: every helper takes a cursor into the mapped
+// buffer and advances it, so no line or token is ever copied to the heap.
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline void skip_blanks(const char*& p, const char* end) {
+    while (p < end && is_blank(*p)) ++p;
+}
+
+static inline const char* find_line_end(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', end - p);
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+// Returns the next whitespace-delimited token as [begin, end).
+static inline void next_token(const char*& p, const char* end, const char*& tok_begin, const char*& tok_end) {
+    skip_blanks(p, end);
+    tok_begin = p;
+    while (p < end && !is_blank(*p)) ++p;
+    tok_end = p;
+}
+
+static inline bool parse_float(const char*& p, const char* end, float& out) {
+    skip_blanks(p, end);
+    if (p < end && *p == '+') ++p; // from_chars does not accept an explicit '+'
+    auto result = std::from_chars(p, end, out);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+static inline bool parse_uint(const char*& p, const char* end, unsigned int& out) {
+    auto result = std::from_chars(p, end, out);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    return true;
+}
+
+static inline bool parse_point(const char*& p, const char* end, cgvPoint3D& point) {
+    return parse_float(p, end, point[X]) && parse_float(p, end, point[Y]) && parse_float(p, end, point[Z]);
+}
+
+// Parses one face corner in any of the forms v, v/t, v//n or v/t/n.
+static inline bool parse_corner(const char*& p, const char* end, VertexTuple& tuple) {
+    skip_blanks(p, end);
+    tuple = {0, 0};
+    if (!parse_uint(p, end, tuple.v_idx)) return false;
+    if (p < end && *p == '/') {
+        ++p;
+        unsigned int t_idx;
+        parse_uint(p, end, t_idx); // texture coordinates are not used
+        if (p < end && *p == '/') {
+            ++p;
+            parse_uint(p, end, tuple.n_idx);
+        }
     }
+    return true;
+}
+
+// Raw records of one line-aligned chunk of the file. Indices are kept exactly
+// as written (1-based, global to the file) and resolved during the merge.
+struct FaceRecord {
+    VertexTuple corners[3];
+    // Positions and normals of the chunk above the face. A face may only use
+    // those and the earlier chunks', as when the file is read line by line.
+    unsigned int v_seen, n_seen;
+};
+
+struct GroupMarker {
+    std::size_t face_index; // number of faces of the chunk that precede the tag
+    std::string name;       // empty when the tag carries no name
+};
+
+struct ChunkRecords {
+    std::vector<cgvPoint3D> v, n;
+    std::vector<FaceRecord> faces;
+    std::vector<GroupMarker> groups;
+    std::size_t v_base = 0, n_base = 0; // positions and normals of the earlier chunks
 };
 
+// Chunks below this size are not worth a thread of their own.
+static const std::size_t MIN_CHUNK_BYTES = 256 * 1024;
+
+static inline bool token_is(const char* begin, const char* end, const char* keyword) {
+    std::size_t len = std::strlen(keyword);
+    return static_cast<std::size_t>(end - begin) == len && std::memcmp(begin, keyword, len) == 0;
+}
+
+static void parse_chunk(const char* p, const char* end, bool track_groups, ChunkRecords& out) {
+    while (p < end) {
+        const char* eol = find_line_end(p, end);
+        const char *prefix, *prefix_end;
+        next_token(p, eol, prefix, prefix_end);
+
+        if (token_is(prefix, prefix_end, "v")) {
+            cgvPoint3D v;
+            parse_point(p, eol, v);
+            out.v.push_back(v);
+        } else if (token_is(prefix, prefix_end, "vn")) {
+            cgvPoint3D n;
+            parse_point(p, eol, n);
+            out.n.push_back(n);
+        } else if (token_is(prefix, prefix_end, "f")) {
+            FaceRecord face;
+            face.v_seen = static_cast<unsigned int>(out.v.size());
+            face.n_seen = static_cast<unsigned int>(out.n.size());
+            bool valid = true;
+            for (auto& corner : face.corners) {
+                if (!parse_corner(p, eol, corner)) { valid = false; break; }
+            }
+            if (valid) out.faces.push_back(face);
+        } else if (track_groups && (token_is(prefix, prefix_end, "o") || token_is(prefix, prefix_end, "g"))) {
+            const char *name, *name_end;
+            next_token(p, eol, name, name_end);
+            out.groups.push_back({out.faces.size(), std::string(name, name_end)});
+        }
+        p = eol < end ? eol + 1 : end;
+    }
+}
+
+// Splits the file into line-aligned chunks and parses them concurrently. The
+// chunks come back in file order, so merging them in sequence reproduces the
+// serial parse exactly.
+static std::vector<ChunkRecords> parse_records(const MappedFile& file, bool track_groups) {
+    const char* data = file.data();
+    const std::size_t size = file.size();
+
+    std::size_t chunk_count = std::min<std::size_t>(JobSystem::instance().thread_count() * 4, size / MIN_CHUNK_BYTES);
+    if (chunk_count == 0) chunk_count = 1;
+
+    std::vector<const char*> bounds(chunk_count + 1);
+    bounds[0] = data;
+    bounds[chunk_count] = data + size;
+    for (std::size_t i = 1; i < chunk_count; ++i) {
+        const char* split = data + size / chunk_count * i;
+        if (split < bounds[i - 1]) split = bounds[i - 1];
+        const char* eol = find_line_end(split, data + size);
+        bounds[i] = eol < data + size ? eol + 1 : eol;
+    }
+
+    std::vector<ChunkRecords> chunks(chunk_count);
+    JobSystem::instance().for_each(chunk_count, [&](std::size_t i) {
+        parse_chunk(bounds[i], bounds[i + 1], track_groups, chunks[i]);
+    });
+    for (std::size_t i = 1; i < chunk_count; ++i) {
+        chunks[i].v_base = chunks[i - 1].v_base + chunks[i - 1].v.size();
+        chunks[i].n_base = chunks[i - 1].n_base + chunks[i - 1].n.size();
+    }
+    return chunks;
+}
+
+// Concatenates the per-chunk vertex (or normal) arrays in file order.
+static void gather_points(const std::vector<ChunkRecords>& chunks,
+                          std::vector<cgvPoint3D> ChunkRecords::*member, std::vector<cgvPoint3D>& out) {
+    std::vector<std::size_t> offsets(chunks.size() + 1, 0);
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        offsets[i + 1] = offsets[i] + (chunks[i].*member).size();
+    }
+    out.resize(offsets.back());
+    JobSystem::instance().for_each(chunks.size(), [&](std::size_t i) {
+        std::copy((chunks[i].*member).begin(), (chunks[i].*member).end(), out.begin() + offsets[i]);
+    });
+}
+
+// Indices are checked against what precedes the face in the file, so a face
+// that refers ahead is dropped (or loses its normals) as in a serial parse.
 static void process_face_data(
-    std::stringstream& line_ss,
+    const ChunkRecords& chunk, const FaceRecord& face,
     const std::vector<cgvPoint3D>& temp_v, const std::vector<cgvPoint3D>& temp_n,
-    cgvTriangleMesh& mesh, std::map<VertexTuple, unsigned int>& vertex_map) {
+    cgvTriangleMesh& mesh, VertexIndexMap& vertex_map) {
 
-    std::vector<unsigned int> face_indices;
+    const std::size_t v_count = chunk.v_base + face.v_seen;
+    const std::size_t n_count = chunk.n_base + face.n_seen;
+    VertexTuple corners[3];
     for (int i = 0; i < 3; ++i) {
-        std::string face_part;
-        line_ss >> face_part;
-        std::stringstream part_ss(face_part);
-        
-        VertexTuple tuple = {0, 0};
-        part_ss >> tuple.v_idx;
-        if (part_ss.str().find("//") != std::string::npos) {
-            part_ss.ignore(2);
-            part_ss >> tuple.n_idx;
-        }
+        corners[i] = face.corners[i];
+        if (corners[i].v_idx == 0 || corners[i].v_idx > v_count) return;
+        if (corners[i].n_idx > n_count) corners[i].n_idx = 0;
+    }
 
-        auto it = vertex_map.find(tuple);
-        if (it != vertex_map.end()) {
-            face_indices.push_back(it->second);
-        } else {
-            unsigned int new_idx = mesh.get_vertices().size();
+    unsigned int face_indices[3];
+    for (int i = 0; i < 3; ++i) {
+        const VertexTuple& tuple = corners[i];
+        bool inserted;
+        face_indices[i] = vertex_map.find_or_insert(tuple.v_idx, tuple.n_idx, mesh.get_vertices().size(), inserted);
+        if (inserted) {
             mesh.get_vertices().push_back(temp_v[tuple.v_idx - 1]);
             if (tuple.n_idx > 0) {
                 mesh.get_normals().push_back(temp_n[tuple.n_idx - 1]);
             }
-            vertex_map[tuple] = new_idx;
-            face_indices.push_back(new_idx);
         }
     }
     mesh.get_triangles().emplace_back(face_indices[0], face_indices[1], face_indices[2]);
 }
 
 bool AdvancedOBJLoader::load(const std::string& path, cgvTriangleMesh& mesh) {
-    std::ifstream file(path);
-    if (!file.is_open()) return false;
+    if (MeshCache::read(path, mesh)) return true;
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    std::vector<ChunkRecords> chunks = parse_records(file, false);
 
     std::vector<cgvPoint3D> temp_v, temp_n;
-    std::map<VertexTuple, unsigned int> vertex_map;
+    gather_points(chunks, &ChunkRecords::v, temp_v);
+    gather_points(chunks, &ChunkRecords::n, temp_n);
+
+    // Most meshes emit roughly one vertex per position, so size the table for that.
+    VertexIndexMap vertex_map(temp_v.size());
     mesh.get_vertices().clear();
     mesh.get_normals().clear();
     mesh.get_triangles().clear();
+    mesh.get_vertices().reserve(temp_v.size());
 
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string prefix;
-        ss >> prefix;
-        if (prefix == "v") {
-            cgvPoint3D v; ss >> v[X] >> v[Y] >> v[Z];
-            temp_v.push_back(v);
-        } else if (prefix == "vn") {
-            cgvPoint3D n; ss >> n[X] >> n[Y] >> n[Z];
-            temp_n.push_back(n);
-        } else if (prefix == "f") {
-            process_face_data(ss, temp_v, temp_n, mesh, vertex_map);
+    // Deduplication assigns indices in first-use order, so it stays serial.
+    for (const auto& chunk : chunks) {
+        for (const auto& face : chunk.faces) {
+            process_face_data(chunk, face, temp_v, temp_n, mesh, vertex_map);
         }
     }
 
-    if (mesh.get_normals().empty()) {
+    // Faces that give no normals leave the list short; generate them all then.
+    if (mesh.get_normals().size() != mesh.get_vertices().size()) {
         mesh.compute_normals();
     }
+
+    if (!MeshCache::write(path, file.data(), file.size(), mesh)) {
+        std::cerr << "Could not write mesh cache " << MeshCache::cache_path(path) << std::endl;
+    }
     return true;
 }
 
+// A run of consecutive faces between two o/g tags. It may span several chunks.
+struct FaceSlice {
+    const ChunkRecords* chunk;
+    std::size_t begin, end;
+};
+
+struct GroupRuns {
+    cgvTriangleMesh* mesh;
+    std::vector<std::vector<FaceSlice>> runs; // each run starts with an empty vertex map
+};
+
 bool AdvancedOBJLoader::load_articulated(const std::string& path, std::map<std::string, cgvTriangleMesh*>& meshes) {
-    std::ifstream file(path);
-    if (!file.is_open()) return false;
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    std::vector<ChunkRecords> chunks = parse_records(file, true);
 
     std::vector<cgvPoint3D> temp_v, temp_n;
-    cgvTriangleMesh* current_mesh = nullptr;
+    gather_points(chunks, &ChunkRecords::v, temp_v);
+    gather_points(chunks, &ChunkRecords::n, temp_n);
+
+    // Walk the group tags in file order to assign every face run to its mesh.
+    std::vector<GroupRuns> groups;
+    std::map<cgvTriangleMesh*, std::size_t> group_of_mesh;
+    std::vector<FaceSlice>* current_run = nullptr;
     std::string current_name = "default";
-    std::map<VertexTuple, unsigned int> vertex_map;
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string prefix;
-        ss >> prefix;
-
-        if (prefix == "o" || prefix == "g") {
-            ss >> current_name;
-            if (meshes.find(current_name) == meshes.end()) {
-                meshes[current_name] = new cgvTriangleMesh();
-            }
-            current_mesh = meshes[current_name];
-            vertex_map.clear();
-        } else if (prefix == "v") {
-            cgvPoint3D v; ss >> v[X] >> v[Y] >> v[Z];
-            temp_v.push_back(v);
-        } else if (prefix == "vn") {
-            cgvPoint3D n; ss >> n[X] >> n[Y] >> n[Z];
-            temp_n.push_back(n);
-        } else if (prefix == "f") {
-            if (!current_mesh) {
-                if (meshes.find(current_name) == meshes.end()) {
-                    meshes[current_name] = new cgvTriangleMesh();
+
+    auto open_run = [&]() {
+        if (meshes.find(current_name) == meshes.end()) {
+            meshes[current_name] = new cgvTriangleMesh();
+        }
+        cgvTriangleMesh* mesh = meshes[current_name];
+        auto it = group_of_mesh.find(mesh);
+        if (it == group_of_mesh.end()) {
+            it = group_of_mesh.emplace(mesh, groups.size()).first;
+            groups.push_back({mesh, {}});
+        }
+        auto& runs = groups[it->second].runs;
+        runs.emplace_back();
+        current_run = &runs.back();
+    };
+    auto add_slice = [&](const ChunkRecords& chunk, std::size_t begin, std::size_t end) {
+        if (begin == end) return;
+        if (!current_run) open_run();
+        current_run->push_back({&chunk, begin, end});
+    };
+
+    for (const auto& chunk : chunks) {
+        std::size_t begin = 0;
+        for (const auto& marker : chunk.groups) {
+            add_slice(chunk, begin, marker.face_index);
+            begin = marker.face_index;
+            if (!marker.name.empty()) current_name = marker.name;
+            open_run();
+        }
+        add_slice(chunk, begin, chunk.faces.size());
+    }
+
+    // Different meshes share nothing but the read-only vertex pools.
+    JobSystem::instance().for_each(groups.size(), [&](std::size_t g) {
+        VertexIndexMap vertex_map;
+        for (const auto& run : groups[g].runs) {
+            // A run cannot emit more vertices than it has corners or positions.
+            std::size_t run_faces = 0;
+            for (const auto& slice : run) run_faces += slice.end - slice.begin;
+            vertex_map.reset(std::min(temp_v.size(), run_faces * 3));
+            for (const auto& slice : run) {
+                for (std::size_t f = slice.begin; f < slice.end; ++f) {
+                    process_face_data(*slice.chunk, slice.chunk->faces[f], temp_v, temp_n, *groups[g].mesh, vertex_map);
                 }
-                current_mesh = meshes[current_name];
             }
-            process_face_data(ss, temp_v, temp_n, *current_mesh, vertex_map);
         }
-    }
+    });
 
-    for (auto const& [name, mesh] : meshes) {
-        if (mesh->get_normals().empty()) {
-            mesh->compute_normals();
+    std::vector<cgvTriangleMesh*> all_meshes;
+    for (auto const& [name, mesh] : meshes) all_meshes.push_back(mesh);
+    JobSystem::instance().for_each(all_meshes.size(), [&](std::size_t i) {
+        if (all_meshes[i]->get_normals().size() != all_meshes[i]->get_vertices().size()) {
+            all_meshes[i]->compute_normals();
         }
-    }
+    });
     return true;
 }
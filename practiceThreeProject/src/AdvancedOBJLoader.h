@@ -8,7 +8,8 @@
 
 class AdvancedOBJLoader {
 public:
-    // Loads a single mesh from an OBJ file.
+    // Loads a single mesh from an OBJ file. The result is cached in a binary
+    // sidecar next to the file (see MeshCache) and reused while it is fresh.
     static bool load(const std::string& path, cgvTriangleMesh& mesh);
 
     // Loads multiple meshes from a single OBJ file, separating them by object/group tags.
@@ -0,0 +1,110 @@
+#include "AssetLoader.h"
+#include "AdvancedOBJLoader.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "Profiler.h"
+#include "Texture.h"
+#include "cgvTriangleMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    JobSystem::instance().wait(jobs); // they point back here
+}
+
+void AssetLoader::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++in_flight;
+    }
+    JobSystem::instance().run_background([this, job = std::move(job)]() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                --in_flight;
+                return;
+            }
+        }
+
+        Upload upload = job();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uploads.push_back(std::move(upload));
+        --in_flight;
+    }, &jobs);
+}
+
+void AssetLoader::load_mesh(const std::string& path, cgvTriangleMesh* target, bool optimize) {
+    target->set_loading(true);
+    submit([path, target, optimize]() -> Upload {
+        ProfileScope scope("load mesh");
+        auto mesh = std::make_shared<cgvTriangleMesh>();
+        bool ok = AdvancedOBJLoader::load(path, *mesh);
+        if (ok) mesh->compute_bounds();
+        if (ok && optimize) {
+            MeshOptimizationReport report;
+            MeshOptimizer::optimize(*mesh, &report);
+            std::cout << "Optimized " << path << ": ACMR " << report.before.acmr << " -> " << report.after.acmr
+                      << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
+        }
+        if (ok && !MeshCache::read_lods(path, *mesh)) {
+            // The levels index the optimized vertex order, so they come after it.
+            MeshSimplifier::build_lods(*mesh);
+            if (!MeshCache::write_lods(path, *mesh)) {
+                std::cerr << "Could not write LOD cache " << MeshCache::lod_path(path) << std::endl;
+            }
+        }
+        if (ok) mesh->build_bvh(); // after the optimizer has reordered the triangles
+        return [path, target, mesh, ok]() {
+            if (ok) {
+                target->swap_geometry(*mesh);
+            } else {
+                std::cerr << "Failed to load mesh " << path << std::endl;
+            }
+            target->set_loading(false);
+        };
+    });
+}
+
+void AssetLoader::load_texture(const std::string& path, Texture* target) {
+    submit([path, target]() -> Upload {
+        ProfileScope scope("decode texture");
+        auto image = std::make_shared<std::vector<unsigned char>>();
+        unsigned width = 0, height = 0;
+        bool ok = Texture::decode(path, *image, width, height);
+        return [target, image, width, height, ok]() {
+            if (ok) target->upload(*image, width, height);
+        };
+    });
+}
+
+int AssetLoader::pump(double budget_ms) {
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::duration<double, std::milli>(budget_ms);
+
+    int finished = 0;
+    do {
+        Upload upload;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploads.empty()) break;
+            upload = std::move(uploads.front());
+            uploads.pop_front();
+        }
+        upload();
+        ++finished;
+    } while (clock::now() < deadline);
+    return finished;
+}
+
+bool AssetLoader::busy() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return in_flight > 0 || !uploads.empty();
+}
@@ -0,0 +1,53 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include "JobSystem.h"
+
+class cgvTriangleMesh;
+class Texture;
+
+// Loads assets in the background. Parsing and decoding run as background
+// jobs on the JobSystem's workers; the finished CPU buffers are queued and
+// handed to their target objects on the render thread by pump(), which may
+// touch GL.
+class AssetLoader {
+public:
+    AssetLoader() = default;
+    ~AssetLoader(); // waits for the loads already started, skips the rest
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Parses an OBJ file off-thread and moves the geometry into target.
+    // target draws a placeholder until then. With optimize set, the mesh is
+    // also run through MeshOptimizer and the cache statistics are printed.
+    void load_mesh(const std::string& path, cgvTriangleMesh* target, bool optimize = false);
+
+    // Decodes a PNG file off-thread and uploads it into target.
+    void load_texture(const std::string& path, Texture* target);
+
+    // Runs finished uploads on the calling thread until budget_ms is spent
+    // (at least one per call). Returns how many assets were finished.
+    int pump(double budget_ms);
+
+    // True while any asset is queued, being decoded or waiting for upload.
+    bool busy();
+
+private:
+    using Upload = std::function<void()>;
+    using Job = std::function<Upload()>;
+
+    void submit(Job job);
+
+    JobCounter jobs;
+    std::mutex mutex;
+    std::deque<Upload> uploads;
+    std::size_t in_flight = 0; // submitted and not yet in uploads
+    bool stopping = false;
+};
+
+#endif // ASSET_LOADER_H
@@ -0,0 +1,135 @@
+#include "BVH.h"
+#include <algorithm>
+
+// Half the surface area of a box, which is all the heuristic compares.
+static GLfloat half_area(const BoundingBox& box) {
+    if (box.isEmpty()) return 0.0f;
+    vec3 e = box.max - box.min;
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+static void expand(BoundingBox& box, const BoundingBox& other) {
+    if (other.isEmpty()) return;
+    box.expand(other.min);
+    box.expand(other.max);
+}
+
+void BVH::clear() {
+    nodes.clear();
+    primitiveIndices.clear();
+}
+
+void BVH::build(const std::vector<BoundingBox>& primitiveBounds) {
+    clear();
+    if (primitiveBounds.empty()) return;
+
+    const std::uint32_t count = static_cast<std::uint32_t>(primitiveBounds.size());
+    std::vector<vec3> centroids(count);
+    primitiveIndices.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        centroids[i] = primitiveBounds[i].center();
+        primitiveIndices[i] = i;
+    }
+
+    // A binary tree over n leaves has at most 2n - 1 nodes.
+    nodes.reserve(2 * count - 1);
+    nodes.push_back({BoundingBox(), 0, count});
+    subdivide(0, 0, primitiveBounds, centroids);
+    nodes.shrink_to_fit();
+}
+
+void BVH::refit(const std::vector<BoundingBox>& primitiveBounds) {
+    // Children always come after their parent, so walking backwards sees
+    // both children of a node before the node itself.
+    for (std::size_t n = nodes.size(); n-- > 0;) {
+        Node& node = nodes[n];
+        BoundingBox bounds;
+        if (node.isLeaf()) {
+            for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                expand(bounds, primitiveBounds[primitiveIndices[i]]);
+            }
+        } else {
+            expand(bounds, nodes[node.first].bounds);
+            expand(bounds, nodes[node.first + 1].bounds);
+        }
+        node.bounds = bounds;
+    }
+}
+
+void BVH::subdivide(std::uint32_t nodeIndex, int depth, const std::vector<BoundingBox>& primitiveBounds,
+                    const std::vector<vec3>& centroids) {
+    const std::uint32_t first = nodes[nodeIndex].first;
+    const std::uint32_t count = nodes[nodeIndex].count;
+
+    BoundingBox bounds, centroidBounds;
+    for (std::uint32_t i = first; i < first + count; ++i) {
+        expand(bounds, primitiveBounds[primitiveIndices[i]]);
+        centroidBounds.expand(centroids[primitiveIndices[i]]);
+    }
+    nodes[nodeIndex].bounds = bounds;
+    if (count <= MAX_LEAF_SIZE || depth >= MAX_DEPTH) return;
+
+    // Drop the primitives into bins along each axis and take the bin
+    // boundary where area(left) * n(left) + area(right) * n(right) is least.
+    int bestAxis = -1, bestSplit = 0;
+    GLfloat bestCost = half_area(bounds) * count; // cost of staying a leaf
+    for (int axis = 0; axis < 3; ++axis) {
+        GLfloat low = centroidBounds.min[axis], high = centroidBounds.max[axis];
+        if (high <= low) continue; // every centroid in one plane
+        GLfloat scale = BIN_COUNT / (high - low);
+
+        BoundingBox binBounds[BIN_COUNT];
+        std::uint32_t binCount[BIN_COUNT] = {};
+        for (std::uint32_t i = first; i < first + count; ++i) {
+            std::uint32_t p = primitiveIndices[i];
+            int bin = std::min(BIN_COUNT - 1, static_cast<int>((centroids[p][axis] - low) * scale));
+            ++binCount[bin];
+            expand(binBounds[bin], primitiveBounds[p]);
+        }
+
+        // Sweep from the right to get the area and count right of each
+        // boundary, then from the left to evaluate them.
+        GLfloat rightArea[BIN_COUNT - 1];
+        std::uint32_t rightCount[BIN_COUNT - 1];
+        BoundingBox sweep;
+        std::uint32_t n = 0;
+        for (int b = BIN_COUNT - 1; b > 0; --b) {
+            expand(sweep, binBounds[b]);
+            n += binCount[b];
+            rightArea[b - 1] = half_area(sweep);
+            rightCount[b - 1] = n;
+        }
+        sweep = BoundingBox();
+        n = 0;
+        for (int b = 0; b < BIN_COUNT - 1; ++b) {
+            expand(sweep, binBounds[b]);
+            n += binCount[b];
+            if (n == 0 || rightCount[b] == 0) continue;
+            GLfloat cost = half_area(sweep) * n + rightArea[b] * rightCount[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+    if (bestAxis < 0) return; // no split beats a leaf
+
+    GLfloat low = centroidBounds.min[bestAxis];
+    GLfloat scale = BIN_COUNT / (centroidBounds.max[bestAxis] - low);
+    auto middle = std::partition(primitiveIndices.begin() + first, primitiveIndices.begin() + first + count,
+                                 [&](std::uint32_t p) {
+                                     int bin = std::min(BIN_COUNT - 1,
+                                                        static_cast<int>((centroids[p][bestAxis] - low) * scale));
+                                     return bin <= bestSplit;
+                                 });
+    std::uint32_t leftCount = static_cast<std::uint32_t>(middle - primitiveIndices.begin()) - first;
+
+    std::uint32_t left = static_cast<std::uint32_t>(nodes.size());
+    nodes.push_back({BoundingBox(), first, leftCount});
+    nodes.push_back({BoundingBox(), first + leftCount, count - leftCount});
+    nodes[nodeIndex].first = left;
+    nodes[nodeIndex].count = 0;
+    subdivide(left, depth + 1, primitiveBounds, centroids);
+    subdivide(left + 1, depth + 1, primitiveBounds, centroids);
+}
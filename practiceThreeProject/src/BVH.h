@@ -0,0 +1,103 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <vector>
+#include "BoundingVolume.h"
+#include "Ray.h"
+
+// Bounding volume hierarchy over a set of primitives known only by their
+// boxes: triangles of a mesh, or whole objects of the scene. Nodes are split
+// with the surface area heuristic evaluated over a few bins per axis, and
+// stored flat with the two children of a node side by side, so a ray walks
+// it with a small stack and no pointers.
+class BVH {
+public:
+    struct Node {
+        BoundingBox bounds;
+        std::uint32_t first; // leaf: first entry of primitiveIndices; inner: left child
+        std::uint32_t count; // primitives in a leaf, 0 for an inner node
+        bool isLeaf() const { return count > 0; }
+    };
+
+    void build(const std::vector<BoundingBox>& primitiveBounds);
+    // Recomputes every node's box for moved primitives, keeping the tree.
+    // Much cheaper than a build, but the tree gets looser as things move.
+    void refit(const std::vector<BoundingBox>& primitiveBounds);
+    void clear();
+    bool empty() const { return nodes.empty(); }
+
+    const std::vector<Node>& getNodes() const { return nodes; }
+    const std::vector<std::uint32_t>& getPrimitiveIndices() const { return primitiveIndices; }
+
+    // Calls hitPrimitive(index, hit) for every primitive in a leaf the ray
+    // reaches before hit.distance, nearer children first. hitPrimitive tests
+    // the primitive and returns true after lowering hit.distance to its hit,
+    // which prunes the rest of the walk. Returns whether anything was hit.
+    template <class HitPrimitive>
+    bool traverse(const Ray& ray, RayHit& hit, HitPrimitive hitPrimitive) const;
+
+private:
+    std::vector<Node> nodes;
+    std::vector<std::uint32_t> primitiveIndices;
+
+    static const int BIN_COUNT = 12;
+    static const std::uint32_t MAX_LEAF_SIZE = 4;
+    static const int MAX_DEPTH = 48; // deeper nodes become leaves, whatever their size
+
+    void subdivide(std::uint32_t nodeIndex, int depth, const std::vector<BoundingBox>& primitiveBounds,
+                   const std::vector<vec3>& centroids);
+};
+
+template <class HitPrimitive>
+bool BVH::traverse(const Ray& ray, RayHit& hit, HitPrimitive hitPrimitive) const {
+    if (nodes.empty()) return false;
+    const vec3 inverseDirection = RayTests::inverse(ray.direction);
+
+    GLfloat t;
+    if (!RayTests::box(ray, inverseDirection, nodes[0].bounds, hit.distance, t)) return false;
+
+    // Each entry remembers where the ray enters its box, so a subtree that
+    // starts beyond a hit found meanwhile is dropped when popped.
+    struct Entry {
+        std::uint32_t node;
+        GLfloat t;
+    };
+    Entry stack[MAX_DEPTH + 1];
+    int top = 0;
+    stack[top++] = {0, t};
+
+    bool found = false;
+    while (top > 0) {
+        Entry entry = stack[--top];
+        if (entry.t >= hit.distance) continue;
+        const Node& node = nodes[entry.node];
+        if (node.isLeaf()) {
+            for (std::uint32_t i = node.first; i < node.first + node.count; ++i) {
+                if (hitPrimitive(primitiveIndices[i], hit)) found = true;
+            }
+            continue;
+        }
+
+        GLfloat tLeft, tRight;
+        bool left = RayTests::box(ray, inverseDirection, nodes[node.first].bounds, hit.distance, tLeft);
+        bool right = RayTests::box(ray, inverseDirection, nodes[node.first + 1].bounds, hit.distance, tRight);
+        // The nearer child goes on top.
+        if (left && right) {
+            if (tLeft <= tRight) {
+                stack[top++] = {node.first + 1, tRight};
+                stack[top++] = {node.first, tLeft};
+            } else {
+                stack[top++] = {node.first, tLeft};
+                stack[top++] = {node.first + 1, tRight};
+            }
+        } else if (left) {
+            stack[top++] = {node.first, tLeft};
+        } else if (right) {
+            stack[top++] = {node.first + 1, tRight};
+        }
+    }
+    return found;
+}
+
+#endif // BVH_H
@@ -0,0 +1,549 @@
+#include "Benchmark.h"
+#include "AdvancedOBJLoader.h"
+#include "CrowdScene.h"
+#include "JobSystem.h"
+#include "VertexIndexMap.h"
+#include "cgvMath.h"
+#include "cgvTriangleMesh.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+static const char* const BENCHMARK_FLAG = "--benchmark";
+
+// The --jobs workloads: a grid mesh of GRID_SIDE^2 quads, written out as an
+// OBJ of OBJ_GROUPS objects for the parser; a crowd of CROWD_OBJECTS; and
+// GRAPH_STAGES stages of GRAPH_JOBS jobs, each stage waiting on the last.
+// Each is timed REPEATS times per thread count and the median kept.
+static const int GRID_SIDE = 600;
+static const int OBJ_GROUPS = 16;
+static const int CROWD_OBJECTS = 20000;
+static const int GRAPH_STAGES = 4;
+static const int GRAPH_JOBS = 4096;
+static const int REPEATS = 5;
+
+// Vectors per --math operation
+static const std::size_t MATH_VECTORS = 1 << 20;
+
+static bool parse_int(const char* text, int minimum, int& value) {
+    char* end;
+    long parsed = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || parsed < minimum || parsed > 1000000000L) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+// Nearest rank, like the profiler's.
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    std::size_t rank = static_cast<std::size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::max<std::size_t>(rank, 1) - 1];
+}
+
+static std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+bool Benchmark::isRequested(int argc, char** argv) {
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], BENCHMARK_FLAG) == 0) return true;
+    }
+    return false;
+}
+
+bool Benchmark::parseArguments(int argc, char** argv, BenchmarkOptions& options) {
+    for (int a = 1; a < argc; ++a) {
+        const char* arg = argv[a];
+        const char* value = a + 1 < argc ? argv[a + 1] : nullptr;
+        bool ok = true;
+        if (std::strcmp(arg, BENCHMARK_FLAG) == 0) {
+            continue;
+        } else if (std::strcmp(arg, "--scene") == 0 && value) {
+            options.scene = value;
+            ok = options.scene == "showcase" || options.scene == "crowd";
+        } else if (std::strcmp(arg, "--crowd") == 0 && value) {
+            ok = parse_int(value, 1, options.crowdCount);
+            options.scene = "crowd";
+        } else if (std::strcmp(arg, "--frames") == 0 && value) {
+            ok = parse_int(value, 1, options.frames);
+        } else if (std::strcmp(arg, "--jobs") == 0) {
+            options.jobs = true;
+            continue;
+        } else if (std::strcmp(arg, "--dedup") == 0) {
+            options.dedup = true;
+            continue;
+        } else if (std::strcmp(arg, "--math") == 0) {
+            options.math = true;
+            continue;
+        } else if (std::strcmp(arg, "--instanced") == 0) {
+            options.instanced = true;
+            continue;
+        } else if (std::strcmp(arg, "--obj") == 0 && value) {
+            options.obj = value;
+        } else if (std::strcmp(arg, "--faces") == 0 && value) {
+            ok = parse_int(value, 2, options.faces);
+        } else if (std::strcmp(arg, "--threads") == 0 && value) {
+            ok = parse_int(value, 1, options.threads);
+        } else if (std::strcmp(arg, "--replay") == 0 && value) {
+            options.replay = value;
+        } else if (std::strcmp(arg, "--size") == 0 && value) {
+            ok = std::sscanf(value, "%dx%d", &options.width, &options.height) == 2 && options.width > 0 &&
+                 options.height > 0;
+        } else {
+            std::cerr << "Unknown benchmark argument " << arg << std::endl;
+            return false;
+        }
+        if (!ok) {
+            std::cerr << "Bad value " << value << " for " << arg << std::endl;
+            return false;
+        }
+        ++a;
+    }
+    return true;
+}
+
+long Benchmark::peakRssKb() {
+#if defined(_WIN32)
+    return 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__) && defined(__MACH__)
+    return static_cast<long>(usage.ru_maxrss / 1024); // bytes there
+#else
+    return static_cast<long>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+void Benchmark::writeJson(std::ostream& out, const BenchmarkOptions& options, const BenchmarkResult& result) {
+    std::vector<double> sorted = result.frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : sorted) total += ms;
+    const double seconds = total / 1000.0;
+    const std::size_t frames = sorted.size();
+
+    char line[160];
+    out << "{\n";
+    out << "  \"scene\": " << json_string(options.scene) << ",\n";
+    if (!options.replay.empty()) out << "  \"replay\": " << json_string(options.replay) << ",\n";
+    out << "  \"objects\": " << result.objects << ",\n";
+    out << "  \"renderer\": " << json_string(result.renderer) << ",\n";
+    out << "  \"instanced\": " << (result.instanced ? "true" : "false") << ",\n";
+    out << "  \"width\": " << result.width << ",\n";
+    out << "  \"height\": " << result.height << ",\n";
+    out << "  \"frames\": " << frames << ",\n";
+    if (frames > 0) {
+        std::snprintf(line, sizeof(line),
+                      "  \"frame_ms\": {\"min\": %.4f, \"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, "
+                      "\"max\": %.4f},\n",
+                      sorted.front(), total / frames, percentile(sorted, 0.5), percentile(sorted, 0.9),
+                      percentile(sorted, 0.99), sorted.back());
+        out << line;
+        std::snprintf(line, sizeof(line), "  \"fps\": %.2f,\n", frames / seconds);
+        out << line;
+        out << "  \"triangles_per_frame\": " << result.triangles / frames << ",\n";
+        std::snprintf(line, sizeof(line), "  \"triangles_per_second\": %.0f,\n", result.triangles / seconds);
+        out << line;
+    }
+    out << "  \"peak_rss_kb\": " << peakRssKb() << "\n";
+    out << "}" << std::endl;
+}
+
+static void make_grid(int side, cgvTriangleMesh& mesh) {
+    std::vector<cgvPoint3D>& vertices = mesh.get_vertices();
+    std::vector<cgvTriangle>& triangles = mesh.get_triangles();
+    vertices.clear();
+    triangles.clear();
+    for (int z = 0; z <= side; ++z) {
+        for (int x = 0; x <= side; ++x) {
+            vertices.push_back(cgvPoint3D(x, std::sin(x * 0.1f) * std::cos(z * 0.1f), z));
+        }
+    }
+    for (int z = 0; z < side; ++z) {
+        for (int x = 0; x < side; ++x) {
+            unsigned v = z * (side + 1) + x;
+            triangles.emplace_back(v, v + side + 1, v + 1);
+            triangles.emplace_back(v + 1, v + side + 1, v + side + 2);
+        }
+    }
+}
+
+static bool write_obj(const std::string& path, const cgvTriangleMesh& mesh, int groups) {
+    std::ofstream out(path);
+    char line[96];
+    for (const cgvPoint3D& v : mesh.get_vertices()) {
+        std::snprintf(line, sizeof(line), "v %g %g %g\n", v[X], v[Y], v[Z]);
+        out << line;
+    }
+    const std::vector<cgvTriangle>& triangles = mesh.get_triangles();
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        if (t % ((triangles.size() + groups - 1) / groups) == 0) out << "o part" << t << "\n";
+        const unsigned* v = triangles[t].v;
+        std::snprintf(line, sizeof(line), "f %u %u %u\n", v[0] + 1, v[1] + 1, v[2] + 1);
+        out << line;
+    }
+    return static_cast<bool>(out);
+}
+
+static double median_ms(const std::function<void()>& workload) {
+    using clock = std::chrono::steady_clock;
+    std::vector<double> times;
+    for (int r = 0; r < REPEATS; ++r) {
+        const clock::time_point start = clock::now();
+        workload();
+        times.push_back(std::chrono::duration<double, std::milli>(clock::now() - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+bool Benchmark::runJobScaling(std::ostream& out, const BenchmarkOptions& options) {
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned threads = options.threads > 0 ? static_cast<unsigned>(options.threads) : hardware;
+    JobSystem::set_worker_count(std::max(1u, threads - 1));
+    JobSystem& jobs = JobSystem::instance();
+
+    cgvTriangleMesh grid;
+    make_grid(GRID_SIDE, grid);
+    const std::string obj_path = (std::filesystem::temp_directory_path() / "pr3_jobs_benchmark.obj").string();
+    if (!write_obj(obj_path, grid, OBJ_GROUPS)) {
+        std::cerr << "Could not write " << obj_path << std::endl;
+        return false;
+    }
+    ArticulatedModel robot;
+    CrowdScene crowd;
+    crowd.build(CROWD_OBJECTS);
+    const std::vector<float> phases = crowd.getPhases();
+    std::vector<float> poses(phases.size() * 3);
+
+    struct Workload {
+        const char* name;
+        std::function<void()> run;
+        std::vector<double> ms;
+    };
+    std::vector<Workload> workloads;
+    workloads.push_back({"obj parse", [&] {
+        std::map<std::string, cgvTriangleMesh*> meshes;
+        AdvancedOBJLoader::load_articulated(obj_path, meshes);
+        for (auto& named : meshes) delete named.second;
+    }, {}});
+    workloads.push_back({"normals", [&] { grid.compute_normals(); }, {}});
+    workloads.push_back({"crowd pose", [&] {
+        for (std::size_t r = 0; r < phases.size(); ++r) robot.pose_at(1.0f + phases[r], &poses[3 * r]);
+        crowd.pose(poses);
+    }, {}});
+    std::vector<float> slots(GRAPH_JOBS);
+    workloads.push_back({"job graph", [&] {
+        JobCounter stages[GRAPH_STAGES];
+        for (int s = 0; s < GRAPH_STAGES; ++s) {
+            for (int j = 0; j < GRAPH_JOBS; ++j) {
+                auto job = [&slots, j] {
+                    float x = slots[j];
+                    for (int k = 0; k < 200; ++k) x = x * 0.999f + 1.0f;
+                    slots[j] = x;
+                };
+                if (s == 0) jobs.run(job, &stages[0]);
+                else jobs.run_after(stages[s - 1], job, &stages[s]);
+            }
+        }
+        jobs.wait(stages[GRAPH_STAGES - 1]);
+    }, {}});
+
+    for (unsigned t = 1; t <= threads; ++t) {
+        jobs.set_thread_limit(t);
+        for (Workload& workload : workloads) workload.ms.push_back(median_ms(workload.run));
+        std::cerr << "Jobs benchmark: " << t << " of " << threads << " threads done" << std::endl;
+    }
+    jobs.set_thread_limit(0);
+    std::filesystem::remove(obj_path);
+
+    char number[32];
+    out << "{\n";
+    out << "  \"benchmark\": \"jobs\",\n";
+    out << "  \"hardware_threads\": " << hardware << ",\n";
+    out << "  \"repeats\": " << REPEATS << ",\n";
+    out << "  \"threads\": [";
+    for (unsigned t = 1; t <= threads; ++t) out << (t > 1 ? ", " : "") << t;
+    out << "],\n";
+    out << "  \"workloads\": [\n";
+    for (std::size_t w = 0; w < workloads.size(); ++w) {
+        const Workload& workload = workloads[w];
+        out << "    {\"name\": " << json_string(workload.name) << ", \"ms\": [";
+        for (std::size_t t = 0; t < workload.ms.size(); ++t) {
+            std::snprintf(number, sizeof(number), "%s%.3f", t ? ", " : "", workload.ms[t]);
+            out << number;
+        }
+        out << "], \"speedup\": [";
+        for (std::size_t t = 0; t < workload.ms.size(); ++t) {
+            std::snprintf(number, sizeof(number), "%s%.2f", t ? ", " : "", workload.ms[0] / workload.ms[t]);
+            out << number;
+        }
+        out << "]}" << (w + 1 < workloads.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}" << std::endl;
+    return true;
+}
+
+typedef std::pair<unsigned int, unsigned int> Corner; // (v_idx, n_idx), 1-based
+
+// The face corners of an OBJ in file order. Like the loader, only the first
+// three corners of a face are kept, a face with fewer is skipped, and
+// texture indices are dropped.
+static bool read_corners(const std::string& path, std::vector<Corner>& corners, std::size_t& vertex_records) {
+    std::ifstream in(path);
+    if (!in) return false;
+    corners.clear();
+    vertex_records = 0;
+    std::string line, token;
+    while (std::getline(in, line)) {
+        if (line.size() > 1 && line[0] == 'v' && (line[1] == ' ' || line[1] == '\t')) {
+            ++vertex_records;
+        } else if (line.size() > 1 && line[0] == 'f' && (line[1] == ' ' || line[1] == '\t')) {
+            std::istringstream tokens(line.substr(2));
+            Corner face[3];
+            int count = 0;
+            while (count < 3 && tokens >> token) {
+                unsigned int v = 0, t = 0, n = 0;
+                if (std::sscanf(token.c_str(), "%u/%u/%u", &v, &t, &n) != 3) {
+                    n = 0;
+                    if (std::sscanf(token.c_str(), "%u//%u", &v, &n) != 2) n = 0;
+                }
+                face[count++] = Corner(v, n);
+            }
+            if (count == 3) corners.insert(corners.end(), face, face + 3);
+        }
+    }
+    return true;
+}
+
+bool Benchmark::runDedup(std::ostream& out, const BenchmarkOptions& options) {
+    // A side x side grid has 2 * side^2 faces.
+    int side = 1;
+    while (2.0 * side * side < options.faces) ++side;
+    const std::string grid_path = (std::filesystem::temp_directory_path() / "pr3_dedup_benchmark.obj").string();
+    {
+        cgvTriangleMesh grid;
+        make_grid(side, grid);
+        if (!write_obj(grid_path, grid, 1)) {
+            std::cerr << "Could not write " << grid_path << std::endl;
+            return false;
+        }
+    }
+
+    struct Input {
+        std::string name;
+        std::vector<Corner> corners;
+        std::size_t vertex_records = 0;
+        std::size_t vertices = 0;
+        double map_ms = 0.0, flat_ms = 0.0;
+    };
+    Input inputs[2];
+    inputs[0].name = options.obj;
+    inputs[1].name = "grid " + std::to_string(side) + "x" + std::to_string(side);
+    bool ok = read_corners(options.obj, inputs[0].corners, inputs[0].vertex_records);
+    if (!ok) std::cerr << "Could not read " << options.obj << std::endl;
+    ok = ok && read_corners(grid_path, inputs[1].corners, inputs[1].vertex_records);
+    std::filesystem::remove(grid_path);
+    if (!ok) return false;
+
+    for (Input& input : inputs) {
+        std::vector<unsigned int> by_map(input.corners.size()), by_flat(input.corners.size());
+        input.map_ms = median_ms([&] {
+            std::map<Corner, unsigned int> vertex_map;
+            unsigned int next = 0;
+            for (std::size_t c = 0; c < input.corners.size(); ++c) {
+                auto found = vertex_map.emplace(input.corners[c], next);
+                if (found.second) ++next;
+                by_map[c] = found.first->second;
+            }
+            input.vertices = next;
+        });
+        input.flat_ms = median_ms([&] {
+            VertexIndexMap vertex_map(input.vertex_records); // sized as load sizes it
+            unsigned int next = 0;
+            for (std::size_t c = 0; c < input.corners.size(); ++c) {
+                bool inserted;
+                by_flat[c] = vertex_map.find_or_insert(input.corners[c].first, input.corners[c].second, next, inserted);
+                if (inserted) ++next;
+            }
+        });
+        if (by_map != by_flat) {
+            std::cerr << "VertexIndexMap disagrees with std::map on " << input.name << std::endl;
+            return false;
+        }
+        std::cerr << "Dedup benchmark: " << input.name << " done" << std::endl;
+    }
+
+    char line[160];
+    out << "{\n";
+    out << "  \"benchmark\": \"dedup\",\n";
+    out << "  \"repeats\": " << REPEATS << ",\n";
+    out << "  \"inputs\": [\n";
+    for (std::size_t i = 0; i < 2; ++i) {
+        const Input& input = inputs[i];
+        out << "    {\"name\": " << json_string(input.name) << ", \"faces\": " << input.corners.size() / 3
+            << ", \"vertices\": " << input.vertices;
+        std::snprintf(line, sizeof(line), ", \"std_map_ms\": %.3f, \"flat_ms\": %.3f, \"speedup\": %.2f}",
+                      input.map_ms, input.flat_ms, input.map_ms / input.flat_ms);
+        out << line << (i + 1 < 2 ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}" << std::endl;
+    return true;
+}
+
+// The same n vectors as cgvPoint3D, as vec3 and as SoA arrays.
+struct MathVectors {
+    std::vector<cgvPoint3D> points;
+    std::vector<vec3> vectors;
+    std::vector<GLfloat> x, y, z;
+
+    explicit MathVectors(std::size_t n) : points(n), vectors(n), x(n), y(n), z(n) {}
+    vec3_soa soa() { return vec3_soa{x.data(), y.data(), z.data()}; }
+
+    // Whether the three layouts hold exactly the same floats.
+    bool identical() const {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            const GLfloat p[3] = {points[i][X], points[i][Y], points[i][Z]};
+            const GLfloat v[3] = {vectors[i].x, vectors[i].y, vectors[i].z};
+            const GLfloat s[3] = {x[i], y[i], z[i]};
+            if (std::memcmp(p, v, sizeof(p)) != 0 || std::memcmp(p, s, sizeof(p)) != 0) return false;
+        }
+        return true;
+    }
+};
+
+bool Benchmark::runMath(std::ostream& out) {
+    const std::size_t n = MATH_VECTORS;
+    MathVectors a(n), b(n), result(n);
+    unsigned seed = 1;
+    auto next = [&seed] {
+        seed = seed * 1664525u + 1013904223u;
+        return static_cast<GLfloat>(seed >> 8) / (1 << 24) * 20.0f - 10.0f;
+    };
+    for (MathVectors* input : {&a, &b}) {
+        for (std::size_t i = 0; i < n; ++i) {
+            GLfloat x = next(), y = next(), z = next();
+            input->points[i] = cgvPoint3D(x, y, z);
+            input->vectors[i] = vec3(x, y, z);
+            input->x[i] = x;
+            input->y[i] = y;
+            input->z[i] = z;
+        }
+    }
+    const cgvMatrix4 matrix = cgvMatrix4::translation(1, 2, 3) * cgvMatrix4::rotation(30, 0, 1, 0) *
+                              cgvMatrix4::scaling(2, 2, 2);
+    const mat4 m(matrix);
+
+    struct Operation {
+        const char* name;
+        std::function<void()> point, vector, soa; // soa is empty where there is no batch kernel
+        double ms[3] = {0.0, 0.0, 0.0};
+        bool identical = false;
+    };
+    std::vector<Operation> operations;
+    operations.push_back({"add", [&] {
+        for (std::size_t i = 0; i < n; ++i) result.points[i] = a.points[i] + b.points[i];
+    }, [&] {
+        for (std::size_t i = 0; i < n; ++i) result.vectors[i] = a.vectors[i] + b.vectors[i];
+    }, nullptr});
+    operations.push_back({"cross", [&] {
+        for (std::size_t i = 0; i < n; ++i) result.points[i] = a.points[i].cross(b.points[i]);
+    }, [&] {
+        for (std::size_t i = 0; i < n; ++i) result.vectors[i] = cross(a.vectors[i], b.vectors[i]);
+    }, [&] {
+        cross(a.soa(), b.soa(), result.soa(), n);
+    }});
+    operations.push_back({"normalize", [&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            result.points[i] = a.points[i];
+            result.points[i].normalize();
+        }
+    }, [&] {
+        for (std::size_t i = 0; i < n; ++i) result.vectors[i] = normalize(a.vectors[i]);
+    }, [&] {
+        result.x = a.x;
+        result.y = a.y;
+        result.z = a.z;
+        normalize(result.soa(), n);
+    }});
+    operations.push_back({"transform", [&] {
+        // Element by element, the way cgvMatrix4 alone has to be applied.
+        for (std::size_t i = 0; i < n; ++i) {
+            const cgvPoint3D& p = a.points[i];
+            result.points[i] = cgvPoint3D(
+                matrix(0, 0) * p[X] + matrix(0, 1) * p[Y] + matrix(0, 2) * p[Z] + matrix(0, 3),
+                matrix(1, 0) * p[X] + matrix(1, 1) * p[Y] + matrix(1, 2) * p[Z] + matrix(1, 3),
+                matrix(2, 0) * p[X] + matrix(2, 1) * p[Y] + matrix(2, 2) * p[Z] + matrix(2, 3));
+        }
+    }, [&] {
+        for (std::size_t i = 0; i < n; ++i) result.vectors[i] = m.transform_point(a.vectors[i]);
+    }, [&] {
+        transform_points(m, a.soa(), result.soa(), n);
+    }});
+
+    for (Operation& operation : operations) {
+        operation.ms[0] = median_ms(operation.point);
+        operation.ms[1] = median_ms(operation.vector);
+        if (operation.soa) {
+            operation.ms[2] = median_ms(operation.soa);
+            operation.identical = result.identical();
+        } else {
+            operation.identical = std::memcmp(result.points.data(), result.vectors.data(), n * sizeof(vec3)) == 0;
+        }
+    }
+
+    char line[192];
+    out << "{\n";
+    out << "  \"benchmark\": \"math\",\n";
+    out << "  \"simd_width\": " << cgvSimd::WIDTH << ",\n";
+    out << "  \"vectors\": " << n << ",\n";
+    out << "  \"repeats\": " << REPEATS << ",\n";
+    out << "  \"operations\": [\n";
+    for (std::size_t o = 0; o < operations.size(); ++o) {
+        const Operation& operation = operations[o];
+        std::snprintf(line, sizeof(line), "    {\"name\": %s, \"cgvPoint3D_ms\": %.3f, \"vec3_ms\": %.3f, ",
+                      json_string(operation.name).c_str(), operation.ms[0], operation.ms[1]);
+        out << line;
+        if (operation.soa) {
+            std::snprintf(line, sizeof(line), "\"soa_ms\": %.3f, ", operation.ms[2]);
+            out << line;
+        } else {
+            out << "\"soa_ms\": null, ";
+        }
+        out << "\"identical\": " << (operation.identical ? "true" : "false") << "}"
+            << (o + 1 < operations.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}" << std::endl;
+    return true;
+}
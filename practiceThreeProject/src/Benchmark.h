@@ -0,0 +1,87 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// pr3 --benchmark [--scene showcase|crowd] [--crowd N] [--frames N] [--size WxH]
+//                 [--replay FILE] [--instanced]
+// pr3 --benchmark --jobs [--threads N]
+// pr3 --benchmark --dedup [--obj FILE] [--faces N]
+// pr3 --benchmark --math
+//
+// Renders a scene offscreen while the camera flies a fixed path, then prints
+// the frame times, triangle throughput and peak memory as JSON on stdout.
+// With --replay, a recorded session (see InputLog.h) drives the frames
+// instead, one 60th of a second of it per frame, until it runs out.
+// --instanced draws the crowd with instancing, where the driver has it,
+// instead of one call per object.
+// Everything else the program prints goes to stderr meanwhile, so the
+// output can be piped straight into a script.
+//
+// With --jobs, nothing is rendered: OBJ parsing, normal generation, crowd
+// posing and a graph of small dependent jobs are timed on the JobSystem with
+// 1, 2, ... N threads (default: the hardware's), to show how each scales.
+//
+// With --dedup, the OBJ loader's vertex deduplication is timed on its own:
+// every face corner of FILE (default objFiles/cow.obj) and of a synthetic
+// grid of about N faces (default 5000000) goes through the old std::map
+// and through VertexIndexMap, and both must hand out the same indices.
+//
+// With --math, vector addition, cross products, normalization and point
+// transforms over a million vectors are timed three ways: cgvPoint3D with
+// cgvMatrix4, cgvMath's vec3 and mat4, and cgvMath's SoA batch kernels.
+struct BenchmarkOptions {
+    std::string scene = "showcase";
+    int crowdCount = 0; // 0: CrowdScene's default
+    int frames = 300;      // ignored by a replay
+    int warmupFrames = 30; // rendered first, not timed
+    int width = 0;         // 0: the replayed session's largest window, or 500
+    int height = 0;
+    std::string replay;    // input log to replay; empty for the camera path
+    bool instanced = false; // draw the crowd with instancing
+    bool jobs = false;     // the JobSystem scaling benchmark instead
+    int threads = 0;       // its largest thread count; 0: the hardware's
+    bool dedup = false;    // the vertex deduplication benchmark instead
+    std::string obj = "objFiles/cow.obj"; // its real-world input
+    int faces = 5000000;                  // its synthetic input's size
+    bool math = false;     // the vector math benchmark instead
+};
+
+struct BenchmarkResult {
+    std::string renderer;
+    int width = 0, height = 0; // rendered at
+    int objects = 0;
+    bool instanced = false; // whether the crowd was drawn instanced
+    std::vector<double> frameMs; // one per timed frame, GPU work included
+    std::uint64_t triangles = 0; // over the timed frames
+};
+
+class Benchmark {
+public:
+    static bool isRequested(int argc, char** argv);
+
+    // Fills options from the arguments. Returns false, after printing why,
+    // on anything it does not understand.
+    static bool parseArguments(int argc, char** argv, BenchmarkOptions& options);
+
+    // Largest resident set of the process so far, in kilobytes; 0 where
+    // unknown.
+    static long peakRssKb();
+
+    static void writeJson(std::ostream& out, const BenchmarkOptions& options, const BenchmarkResult& result);
+
+    // Runs the --jobs benchmark and writes its JSON. Must run before
+    // anything else uses the JobSystem, since it sizes the pool.
+    static bool runJobScaling(std::ostream& out, const BenchmarkOptions& options);
+
+    // Runs the --dedup benchmark and writes its JSON.
+    static bool runDedup(std::ostream& out, const BenchmarkOptions& options);
+
+    // Runs the --math benchmark and writes its JSON.
+    static bool runMath(std::ostream& out);
+};
+
+#endif // BENCHMARK_H
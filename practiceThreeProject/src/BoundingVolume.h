@@ -0,0 +1,77 @@
+#ifndef BOUNDING_VOLUME_H
+#define BOUNDING_VOLUME_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "cgvMath.h"
+
+struct BoundingSphere {
+    vec3 center;
+    GLfloat radius = 0;
+};
+
+// Axis-aligned box. A default one is empty and grows with expand().
+struct BoundingBox {
+    vec3 min = vec3(std::numeric_limits<GLfloat>::max(), std::numeric_limits<GLfloat>::max(),
+                    std::numeric_limits<GLfloat>::max());
+    vec3 max = vec3(-std::numeric_limits<GLfloat>::max(), -std::numeric_limits<GLfloat>::max(),
+                    -std::numeric_limits<GLfloat>::max());
+
+    BoundingBox() = default;
+    BoundingBox(const vec3& min, const vec3& max) : min(min), max(max) {}
+    explicit BoundingBox(const BoundingSphere& sphere)
+        : min(sphere.center - vec3(sphere.radius, sphere.radius, sphere.radius)),
+          max(sphere.center + vec3(sphere.radius, sphere.radius, sphere.radius)) {}
+
+    bool isEmpty() const { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+    void expand(const vec3& p) {
+        min = vec3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = vec3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+
+    vec3 center() const { return (min + max) * 0.5f; }
+    vec3 halfExtent() const { return (max - min) * 0.5f; }
+
+    // The box around this box after an affine transform: the centre moves
+    // with the matrix and each half extent picks up |m| of the others.
+    BoundingBox transformed(const cgvMatrix4& m) const {
+        if (isEmpty()) return *this;
+        vec3 c = center(), e = halfExtent();
+        vec3 newCenter, newExtent;
+        for (int row = 0; row < 3; ++row) {
+            newCenter[row] = m(row, 0) * c.x + m(row, 1) * c.y + m(row, 2) * c.z + m(row, 3);
+            newExtent[row] = std::fabs(m(row, 0)) * e.x + std::fabs(m(row, 1)) * e.y + std::fabs(m(row, 2)) * e.z;
+        }
+        return BoundingBox(newCenter - newExtent, newCenter + newExtent);
+    }
+};
+
+// Many boxes as centre and half-extent arrays, the layout the frustum tests
+// several boxes at a time from.
+struct BoundingBoxArray {
+    std::vector<GLfloat> centerX, centerY, centerZ;
+    std::vector<GLfloat> extentX, extentY, extentZ;
+
+    std::size_t size() const { return centerX.size(); }
+    void clear() { resize(0); }
+
+    void resize(std::size_t count) {
+        for (auto* v : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) v->resize(count);
+    }
+
+    void set(std::size_t i, const BoundingBox& box) {
+        vec3 c = box.center(), e = box.halfExtent();
+        centerX[i] = c.x; centerY[i] = c.y; centerZ[i] = c.z;
+        extentX[i] = e.x; extentY[i] = e.y; extentZ[i] = e.z;
+    }
+
+    void push_back(const BoundingBox& box) {
+        resize(size() + 1);
+        set(size() - 1, box);
+    }
+};
+
+#endif // BOUNDING_VOLUME_H
@@ -1,4 +1,5 @@
 #include "Camera.h"
+#include "SceneNode.h"
 #include <iostream>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
@@ -46,6 +47,10 @@ void Camera::zoom(float delta) {
     if (orbitRadius < 1.0f) orbitRadius = 1.0f;
 }
 
+void Camera::setOrbitRadius(float radius) {
+    orbitRadius = radius < 1.0f ? 1.0f : radius;
+}
+
 void Camera::moveNearPlane(float delta) {
     nearPlane += delta;
     if (nearPlane < 0.01f) nearPlane = 0.01f;
@@ -57,6 +62,10 @@ void Camera::moveFarPlane(float delta) {
     if (farPlane <= nearPlane) farPlane = nearPlane + 0.1f;
 }
 
+void Camera::setFarPlane(float distance) {
+    farPlane = distance > nearPlane ? distance : nearPlane + 0.1f;
+}
+
 void Camera::toggleProjection() {
     perspectiveMode = !perspectiveMode;
 }
@@ -67,20 +76,44 @@ void Camera::setAspectRatio(float ratio) {
 
 void Camera::applyProjection() {
     glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
+    glLoadMatrixf(getProjectionMatrix().data());
+}
 
+cgvMatrix4 Camera::getProjectionMatrix() const {
     if (perspectiveMode) {
-        gluPerspective(fov, aspectRatio, nearPlane, farPlane);
-    } else {
-        float size = orbitRadius * 0.1f; // Adjust ortho size based on radius
-        glOrtho(-size * aspectRatio, size * aspectRatio, -size, size, nearPlane, farPlane);
+        return cgvMatrix4::perspective(fov, aspectRatio, nearPlane, farPlane);
     }
+    float size = orbitRadius * 0.1f; // Adjust ortho size based on radius
+    return cgvMatrix4::orthographic(-size * aspectRatio, size * aspectRatio, -size, size, nearPlane, farPlane);
 }
 
-void Camera::applyView() {
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+Frustum Camera::getFrustum() const {
+    return Frustum(getProjectionMatrix() * getViewMatrix());
+}
+
+Ray Camera::getRay(int x, int y, int width, int height) const {
+    if (width <= 0 || height <= 0) return Ray();
+    float ndcX = 2.0f * (x + 0.5f) / width - 1.0f;
+    float ndcY = 1.0f - 2.0f * (y + 0.5f) / height;
+
+    // Back through the projection and view to the pixel's points on the
+    // near and far planes.
+    mat4 inverse((getProjectionMatrix() * getViewMatrix()).inverse());
+    vec4 nearPoint = inverse * vec4(ndcX, ndcY, -1.0f, 1.0f);
+    vec4 farPoint = inverse * vec4(ndcX, ndcY, 1.0f, 1.0f);
+    vec3 origin = nearPoint.xyz() / nearPoint.w;
+    return Ray(origin, normalize(farPoint.xyz() / farPoint.w - origin));
+}
+
+float Camera::getPixelScale(int viewportHeight) const {
+    if (perspectiveMode) {
+        return viewportHeight / (2.0f * std::tan(fov * static_cast<float>(M_PI) / 360.0f));
+    }
+    float size = orbitRadius * 0.1f; // as in getProjectionMatrix
+    return viewportHeight / (2.0f * size);
+}
 
+cgvMatrix4 Camera::getViewMatrix() const {
     float radY = orbitAngleY * M_PI / 180.0f;
     float radX = orbitAngleX * M_PI / 180.0f;
 
@@ -88,6 +121,13 @@ void Camera::applyView() {
     float y = orbitRadius * sin(radX);
     float z = orbitRadius * cos(radX) * cos(radY);
 
-    gluLookAt(x, y, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
-    glRotatef(yawAngle, 0.0f, 1.0f, 0.0f);
+    return cgvMatrix4::lookAt(x, y, z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f)
+         * cgvMatrix4::rotation(yawAngle, 0.0f, 1.0f, 0.0f);
+}
+
+void Camera::applyView() {
+    cgvMatrix4 view = getViewMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(view.data());
+    SceneNode::setViewMatrix(view);
 }
@@ -1,6 +1,10 @@
 #ifndef PR1_CAMERA_H
 #define PR1_CAMERA_H
 
+#include "cgvMatrix4.h"
+#include "Frustum.h"
+#include "Ray.h"
+
 class Camera {
 private:
     float orbitRadius;
@@ -25,9 +29,12 @@ public:
     void yaw(float delta);
     void zoom(float delta);
 
+    void setOrbitRadius(float radius);
+
     // Clipping planes
     void moveNearPlane(float delta);
     void moveFarPlane(float delta);
+    void setFarPlane(float distance);
 
     // Projection
     void toggleProjection();
@@ -35,10 +42,24 @@ public:
 
     // Apply camera transformations
     void applyProjection();
-    void applyView();
+    void applyView(); // also publishes the view matrix to the scene nodes
+
+    cgvMatrix4 getViewMatrix() const;
+    cgvMatrix4 getProjectionMatrix() const; // the one applyProjection loads
+    Frustum getFrustum() const;             // world-space planes of projection * view
+
+    // World-space ray through the centre of window pixel (x, y), y down as
+    // GLUT reports it. It starts on the near plane and has a unit direction.
+    Ray getRay(int x, int y, int width, int height) const;
+
+    // Window pixels covered by one world unit: at unit distance in
+    // perspective, anywhere in orthographic. Drives mesh LOD selection.
+    float getPixelScale(int viewportHeight) const;
 
     // Getters
     bool isPerspective() const { return perspectiveMode; }
+    float getOrbitRadius() const { return orbitRadius; }
+    float getFarPlane() const { return farPlane; }
 };
 
 
@@ -0,0 +1,201 @@
+#include "CrowdScene.h"
+#include "JobSystem.h"
+#include "SceneNode.h"
+#include <algorithm>
+#include <cmath>
+
+// The cow model sits about 4.5 units along +x from its origin.
+static const float COW_CENTER_X = 4.5f;
+static const float COW_SCALE = 0.5f;
+static const GLfloat COW_COLOR[4] = {0.6f, 0.6f, 0.8f, 1.0f};
+
+// Robots posed per job
+static const std::size_t POSE_GRAIN = 512;
+// Cows measured per job when picking their levels of detail
+static const std::size_t LEVEL_GRAIN = 2048;
+
+// Deterministic per-cell variation, so a given grid always looks the same.
+static float cell_random(unsigned cell) {
+    cell *= 2654435761u;
+    cell ^= cell >> 16;
+    return (cell & 0xffff) / 65535.0f;
+}
+
+// The x, y and z arrays of n vectors stored one after the other in soa.
+static vec3_soa soa_arrays(std::vector<GLfloat>& soa, std::size_t n) {
+    return vec3_soa{soa.data(), soa.data() + n, soa.data() + 2 * n};
+}
+
+// Copies the visible instances into the batch.
+static void fill_batch(InstanceBatch& batch, const std::vector<InstanceBatch::Instance>& all,
+                       const std::vector<unsigned char>& visible) {
+    auto& instances = batch.get_instances();
+    instances.clear();
+    for (std::size_t i = 0; i < all.size(); ++i) {
+        if (visible[i]) instances.push_back(all[i]);
+    }
+}
+
+CrowdScene::CrowdScene() : count(0), extent(0.0f), cowRadius(0.0f), cowBoundsReady(false), robotsPosed(true) {}
+
+void CrowdScene::build(int _count, float spacing) {
+    count = _count > 0 ? _count : 0;
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+    extent = side * spacing * 0.5f;
+
+    robots.clear();
+    cowInstances.clear();
+    robotBounds.clear();
+    cowBoundsReady = false;
+    robotsPosed = true;
+    cowVisible.clear();
+    robotVisible.clear();
+    cowLevels.clear();
+    BoundingBox reach(ArticulatedModel::reach());
+
+    for (int i = 0; i < count; ++i) {
+        int row = i / side, col = i % side;
+        float x = (col - (side - 1) * 0.5f) * spacing;
+        float z = (row - (side - 1) * 0.5f) * spacing;
+        float yaw = 360.0f * cell_random(i);
+
+        cgvMatrix4 placement = cgvMatrix4::translation(x, 0, z) * cgvMatrix4::rotation(yaw, 0, 1, 0);
+        if ((row + col) % 2 == 0) {
+            InstanceBatch::Instance cow;
+            cow.model = placement
+                * cgvMatrix4::scaling(COW_SCALE, COW_SCALE, COW_SCALE)
+                * cgvMatrix4::translation(-COW_CENTER_X, 0, 0);
+            for (int c = 0; c < 4; ++c) cow.color[c] = COW_COLOR[c];
+            cowInstances.push_back(cow);
+        } else {
+            robots.push_back({placement, 20.0f * cell_random(i + count)});
+            robotBounds.push_back(reach.transformed(placement));
+        }
+    }
+
+    // Start every robot in the rest pose.
+    const float rest[3] = {0.0f, 0.0f, 0.0f};
+    cgvMatrix4 local[ArticulatedModel::PART_COUNT];
+    ArticulatedModel::part_matrices(rest, local);
+    for (int p = 0; p < ArticulatedModel::PART_COUNT; ++p) {
+        const GLfloat* color = ArticulatedModel::part_color(static_cast<ArticulatedModel::Part>(p));
+        auto& instances = partInstances[p];
+        instances.resize(robots.size());
+        for (std::size_t r = 0; r < robots.size(); ++r) {
+            instances[r].model = robots[r].placement * local[p];
+            instances[r].color[0] = color[0];
+            instances[r].color[1] = color[1];
+            instances[r].color[2] = color[2];
+            instances[r].color[3] = 1.0f;
+        }
+    }
+}
+
+void CrowdScene::update(const ArticulatedModel& robot, float time) {
+    std::vector<float> poses(robots.size() * 3);
+    for (std::size_t r = 0; r < robots.size(); ++r) robot.pose_at(time + robots[r].phase, &poses[3 * r]);
+    pose(poses);
+}
+
+void CrowdScene::pose(const std::vector<float>& poses) {
+    if (poses.size() != robots.size() * 3) return; // for an older layout
+    JobSystem::instance().parallel_for(robots.size(), POSE_GRAIN, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t r = begin; r < end; ++r) {
+            cgvMatrix4 local[ArticulatedModel::PART_COUNT];
+            ArticulatedModel::part_matrices(&poses[3 * r], local);
+            for (int p = 0; p < ArticulatedModel::PART_COUNT; ++p) {
+                partInstances[p][r].model = robots[r].placement * local[p];
+            }
+        }
+    });
+    robotsPosed = true;
+}
+
+std::vector<float> CrowdScene::getPhases() const {
+    std::vector<float> phases(robots.size());
+    for (std::size_t r = 0; r < robots.size(); ++r) phases[r] = robots[r].phase;
+    return phases;
+}
+
+bool CrowdScene::cull(const BoundingBoxArray& bounds, const Frustum& frustum, CullStats& stats,
+                      std::vector<unsigned char>& last) {
+    visible.resize(bounds.size());
+    frustum.cull(bounds, bounds.size(), visible.data(), &stats);
+    if (visible == last) return false;
+    last.swap(visible);
+    return true;
+}
+
+bool CrowdScene::selectCowLevels(const cgvTriangleMesh& cow) {
+    // Distances are measured in view space, where the instances' scale is
+    // all that changes the size of the mesh.
+    const std::size_t n = cowInstances.size();
+    viewCenters.resize(3 * n);
+    const vec3_soa view = soa_arrays(viewCenters, n);
+    const vec3_soa centers = soa_arrays(cowCenters, n);
+    const mat4 viewMatrix(SceneNode::getViewMatrix());
+    levels.resize(n);
+    JobSystem::instance().parallel_for(n, LEVEL_GRAIN, [&](std::size_t begin, std::size_t end) {
+        const vec3_soa from = {centers.x + begin, centers.y + begin, centers.z + begin};
+        const vec3_soa to = {view.x + begin, view.y + begin, view.z + begin};
+        transform_points(viewMatrix, from, to, end - begin);
+        for (std::size_t c = begin; c < end; ++c) {
+            if (!cowVisible[c]) {
+                levels[c] = 0;
+                continue;
+            }
+            float distance = length(vec3(view.x[c], view.y[c], view.z[c])) - cowRadius;
+            std::size_t level = cow.select_lod(distance, COW_SCALE);
+            levels[c] = static_cast<unsigned char>(std::min<std::size_t>(level, MAX_COW_LODS - 1));
+        }
+    });
+    if (levels == cowLevels) return false;
+    cowLevels.swap(levels);
+    return true;
+}
+
+void CrowdScene::fillCowBatches() {
+    for (int l = 0; l < MAX_COW_LODS; ++l) cows[l].get_instances().clear();
+    for (std::size_t c = 0; c < cowInstances.size(); ++c) {
+        if (cowVisible[c]) cows[cowLevels[c]].get_instances().push_back(cowInstances[c]);
+    }
+}
+
+void CrowdScene::draw(InstancedRenderer& renderer, cgvTriangleMesh& cow, const Frustum& frustum, CullStats& stats) {
+    if (!cow.is_loading()) {
+        if (!cowBoundsReady && cow.hasBounds()) {
+            // The instances only get boxes once the mesh has its own.
+            const std::size_t n = cowInstances.size();
+            cowBounds.resize(n);
+            cowCenters.resize(3 * n);
+            const vec3_soa centers = soa_arrays(cowCenters, n);
+            for (std::size_t c = 0; c < n; ++c) {
+                cowBounds.set(c, cow.getLocalBounds().transformed(cowInstances[c].model));
+                vec3 center = mat4(cowInstances[c].model).transform_point(cow.getLocalSphere().center);
+                centers.x[c] = center.x;
+                centers.y[c] = center.y;
+                centers.z[c] = center.z;
+            }
+            cowRadius = cow.getLocalSphere().radius * COW_SCALE;
+            cowBoundsReady = true;
+            cowVisible.clear();
+        }
+        if (cowBoundsReady) {
+            bool changed = cull(cowBounds, frustum, stats, cowVisible);
+            if (selectCowLevels(cow) || changed) fillCowBatches();
+        } else if (cows[0].size() != cowInstances.size()) {
+            cows[0].get_instances() = cowInstances; // no box to cull or measure with
+            for (int l = 1; l < MAX_COW_LODS; ++l) cows[l].get_instances().clear();
+        }
+        for (int l = 0; l < MAX_COW_LODS; ++l) renderer.drawMesh(cow, cows[l], l);
+    }
+
+    bool changed = cull(robotBounds, frustum, stats, robotVisible);
+    if (changed || robotsPosed) {
+        for (int p = 0; p < ArticulatedModel::PART_COUNT; ++p) fill_batch(parts[p], partInstances[p], robotVisible);
+        robotsPosed = false;
+    }
+    for (int p = 0; p < ArticulatedModel::PART_COUNT; ++p) {
+        renderer.drawPrimitive(ArticulatedModel::part_range(static_cast<ArticulatedModel::Part>(p)), parts[p]);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef CROWD_SCENE_H
+#define CROWD_SCENE_H
+
+#include <vector>
+#include "InstancedRenderer.h"
+#include "cgvTriangleMesh.h"
+#include "ArticulatedModel.h"
+#include "Frustum.h"
+
+// A square grid of cows and robots in a checkerboard, all sharing the one cow
+// mesh and the robot's cached parts. Each robot runs the robot animation with
+// its own phase. Everything is drawn through an InstancedRenderer: one batch
+// per cow level of detail and one per robot part. Only the cows and robots
+// whose boxes are in the frustum go into the batches, and each visible cow
+// goes into the batch of the level its distance from the camera calls for.
+class CrowdScene {
+public:
+    static const int DEFAULT_COUNT = 10000;
+    static const int MAX_COW_LODS = 4; // coarser mesh levels share the last batch
+
+    CrowdScene();
+
+    // Lays out count objects spacing units apart, centred on the origin.
+    void build(int count, float spacing = 8.0f);
+    int getCount() const { return count; }
+    float getExtent() const { return extent; } // half the side of the grid
+
+    // Poses every robot for the given animation time.
+    void update(const ArticulatedModel& robot, float time);
+    // Poses every robot from three DoFs each, as Simulation computes them.
+    void pose(const std::vector<float>& poses);
+    // The robots' animation time offsets, in pose() order.
+    std::vector<float> getPhases() const;
+
+    // Culls the cows and robots against the frustum, adding to stats, and
+    // draws the rest. The view matrix published to the scene nodes places
+    // the cows' levels of detail.
+    void draw(InstancedRenderer& renderer, cgvTriangleMesh& cow, const Frustum& frustum, CullStats& stats);
+
+private:
+    struct Robot {
+        cgvMatrix4 placement;
+        float phase;
+    };
+
+    int count;
+    float extent;
+
+    std::vector<Robot> robots;
+
+    // Every instance, and the world box of every cow and robot. The box of
+    // a robot covers all its poses, so animating does not move it.
+    std::vector<InstanceBatch::Instance> cowInstances;
+    std::vector<InstanceBatch::Instance> partInstances[ArticulatedModel::PART_COUNT];
+    BoundingBoxArray cowBounds, robotBounds;
+    // World centres of the cows' bounding spheres and, per frame, their view
+    // space positions, each stored SoA: every x, then every y, then every z.
+    std::vector<GLfloat> cowCenters, viewCenters;
+    float cowRadius;
+    bool cowBoundsReady; // the cow mesh loads in the background
+    bool robotsPosed;    // the part instances changed since the last draw
+
+    // Visibility of the last drawn frame; the batches are only refilled when
+    // it or the instances change.
+    std::vector<unsigned char> cowVisible, robotVisible, visible;
+    // Level of every cow (visible or not) in the last drawn frame.
+    std::vector<unsigned char> cowLevels, levels;
+
+    // The visible instances, as drawn.
+    InstanceBatch cows[MAX_COW_LODS];
+    InstanceBatch parts[ArticulatedModel::PART_COUNT];
+
+    // Culls one kind of object and refills its batches if anything changed.
+    bool cull(const BoundingBoxArray& bounds, const Frustum& frustum, CullStats& stats,
+              std::vector<unsigned char>& last);
+    // Picks every visible cow's level; true if any changed.
+    bool selectCowLevels(const cgvTriangleMesh& cow);
+    void fillCowBatches();
+};
+
+#endif // CROWD_SCENE_H
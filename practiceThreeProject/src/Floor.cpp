@@ -1,12 +1,16 @@
 #include "Floor.h"
+#include "AssetLoader.h"
+#include "GLState.h"
+#include "Profiler.h"
 
 Floor::Floor(float size) : _size(size), currentMaterialIndex(0), textureEnabled(true), currentTextureIndex(0) {
     createMaterials();
+    setLocalBounds(BoundingBox(vec3(-_size / 2, 0.0f, -_size / 2), vec3(_size / 2, 0.0f, _size / 2)));
     // loadTextures() is now called from init()
 }
 
-void Floor::init() {
-    loadTextures();
+void Floor::init(AssetLoader& loader) {
+    loadTextures(loader);
 }
 
 void Floor::createMaterials() {
@@ -29,15 +33,16 @@ void Floor::createMaterials() {
     materials.emplace_back(amb3, diff3, spec3, 76.8f);
 }
 
-void Floor::loadTextures() {
+void Floor::loadTextures(AssetLoader& loader) {
+    // The floor is drawn untextured until each image has been decoded and uploaded.
     textures.push_back(std::make_unique<Texture>());
-    textures.back()->load("textures/grid.png");
+    loader.load_texture("textures/grid.png", textures.back().get());
 
     textures.push_back(std::make_unique<Texture>());
-    textures.back()->load("textures/water.png");
+    loader.load_texture("textures/water.png", textures.back().get());
 
     textures.push_back(std::make_unique<Texture>());
-    textures.back()->load("textures/bricks.png");
+    loader.load_texture("textures/bricks.png", textures.back().get());
 }
 
 void Floor::setMaterial(int materialIndex) {
@@ -69,19 +74,47 @@ void Floor::setTextureFilters(int filterType) {
     }
 }
 
+const Texture* Floor::currentTexture() const {
+    if (!textureEnabled || currentTextureIndex >= textures.size()) return nullptr;
+    const Texture* texture = textures[currentTextureIndex].get();
+    return texture->isLoaded() ? texture : nullptr;
+}
+
 void Floor::draw() {
     glPushMatrix();
-    applyTransformations();
-
     materials[currentMaterialIndex].apply();
 
-    if (textureEnabled && currentTextureIndex < textures.size()) {
-        glEnable(GL_TEXTURE_2D);
-        textures[currentTextureIndex]->bind();
+    const Texture* texture = currentTexture();
+    if (texture) {
+        GLState::enable(GL_TEXTURE_2D);
+        texture->bind();
     } else {
-        glDisable(GL_TEXTURE_2D);
+        GLState::disable(GL_TEXTURE_2D);
     }
 
+    drawPacket(0);
+
+    if (texture) {
+        texture->unbind();
+        GLState::disable(GL_TEXTURE_2D);
+    }
+    glPopMatrix();
+}
+
+void Floor::submit(RenderQueue& queue) {
+    DrawState state;
+    state.material = &materials[currentMaterialIndex];
+    const Texture* texture = currentTexture();
+    state.texture = texture ? texture->getId() : 0;
+    queue.add(this, 0, state, viewDepth());
+}
+
+void Floor::drawPacket(int) {
+    applyTransformations();
+
+    // Ambient and diffuse follow the colour; white lets the texture show
+    // its own colours instead of whatever was drawn last.
+    glColor3f(1.0f, 1.0f, 1.0f);
     glBegin(GL_QUADS);
     glNormal3f(0.0f, 1.0f, 0.0f);
     
@@ -91,11 +124,5 @@ void Floor::draw() {
     glTexCoord2f(1.0f, 0.0f); glVertex3f(_size / 2, 0.0f, -_size / 2);
     
     glEnd();
-
-    if (textureEnabled) {
-        textures[currentTextureIndex]->unbind();
-        glDisable(GL_TEXTURE_2D);
-    }
-
-    glPopMatrix();
+    Profiler::instance().addTriangles(2);
 }
@@ -7,11 +7,15 @@
 #include <vector>
 #include <memory>
 
+class AssetLoader;
+
 class Floor : public Object3D {
 public:
     Floor(float size = 20.0f);
-    void init(); // New method
+    void init(AssetLoader& loader); // Queues the texture decodes
     void draw() override;
+    void submit(RenderQueue& queue) override;
+    void drawPacket(int part) override;
     void setMaterial(int materialIndex);
     void toggleTexture(bool enable);
     void setTexture(int textureIndex);
@@ -19,7 +23,8 @@ public:
 
 private:
     void createMaterials();
-    void loadTextures();
+    void loadTextures(AssetLoader& loader);
+    const Texture* currentTexture() const; // null when drawn untextured
 
     float _size;
     std::vector<Material> materials;
@@ -0,0 +1,55 @@
+#include "FrameScheduler.h"
+#include <thread>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+FrameScheduler::FrameScheduler(double targetFps)
+    : reportStart(clock::now()), reportCpuSeconds(processCpuSeconds()) {
+    setTargetFps(targetFps);
+}
+
+void FrameScheduler::setTargetFps(double fps) {
+    targetFps = fps > 0.0 ? fps : 0.0;
+    period = targetFps > 0.0 ? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / targetFps))
+                             : clock::duration::zero();
+    running = false;
+}
+
+void FrameScheduler::waitForNextFrame() {
+    const clock::time_point now = clock::now();
+    if (!running || now >= nextFrame + period) {
+        // Starting, or more than a frame late: pace from here.
+        running = true;
+        nextFrame = now + period;
+        return;
+    }
+    std::this_thread::sleep_until(nextFrame);
+    nextFrame += period;
+}
+
+FrameScheduler::Report FrameScheduler::takeReport() {
+    const clock::time_point now = clock::now();
+    const double cpuSeconds = processCpuSeconds();
+
+    Report report;
+    report.seconds = std::chrono::duration<double>(now - reportStart).count();
+    report.frames = frames;
+    if (cpuSeconds >= 0.0 && report.seconds > 0.0) report.cpu = (cpuSeconds - reportCpuSeconds) / report.seconds;
+
+    reportStart = now;
+    reportCpuSeconds = cpuSeconds;
+    frames = 0;
+    return report;
+}
+
+double FrameScheduler::processCpuSeconds() {
+#if defined(_WIN32)
+    return -1.0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1.0;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
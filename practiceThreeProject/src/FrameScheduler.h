@@ -0,0 +1,56 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <chrono>
+
+// Paces animated frames. The window only redraws on its own while something
+// moves; in between, the caller sleeps in waitForNextFrame() until the next
+// frame is due instead of redrawing as fast as it can. When nothing moves,
+// the caller stops asking for frames altogether and input wakes it up again.
+//
+// It also counts the frames drawn and the process's CPU time, so the idle
+// cost of a window can be checked.
+class FrameScheduler {
+public:
+    static constexpr double DEFAULT_FPS = 60.0;
+
+    struct Report {
+        double seconds = 0.0;  // wall time covered
+        unsigned frames = 0;   // drawn in it
+        double cpu = -1.0;     // CPU time over wall time, all threads; -1 where unknown
+    };
+
+    explicit FrameScheduler(double targetFps = DEFAULT_FPS);
+
+    // 0 leaves animated frames unpaced.
+    void setTargetFps(double fps);
+    double getTargetFps() const { return targetFps; }
+
+    // Sleeps until the next animated frame is due. A caller that fell behind
+    // does not catch up: the frame after a late one is a whole period later.
+    void waitForNextFrame();
+    // Animation stopped; the first frame after it restarts is not delayed.
+    void stop() { running = false; }
+
+    void frameDrawn() { ++frames; }
+
+    // What happened since the last report.
+    Report takeReport();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    double targetFps;
+    clock::duration period;
+    clock::time_point nextFrame;
+    bool running = false;
+
+    unsigned frames = 0;
+    clock::time_point reportStart;
+    double reportCpuSeconds;
+
+    // User plus system time of the whole process; negative where unknown.
+    static double processCpuSeconds();
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,113 @@
+#include "Frustum.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <cmath>
+
+// Boxes per job when culling: the test is a few dozen multiplies a box, so
+// smaller slices would cost more to hand out than to run.
+static const std::size_t CULL_GRAIN = 4096;
+
+Frustum::Frustum() {
+    for (auto& plane : planes) plane[0] = plane[1] = plane[2] = plane[3] = 0.0f;
+}
+
+Frustum::Frustum(const cgvMatrix4& m) {
+    // Each plane is the last row of the matrix plus or minus one of the
+    // others (left/right, bottom/top, near/far).
+    for (int p = 0; p < 6; ++p) {
+        int row = p / 2;
+        GLfloat sign = (p % 2 == 0) ? 1.0f : -1.0f;
+        for (int col = 0; col < 4; ++col) planes[p][col] = m(3, col) + sign * m(row, col);
+
+        GLfloat length = std::sqrt(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        if (length > 0.0f) {
+            for (int col = 0; col < 4; ++col) planes[p][col] /= length;
+        }
+    }
+}
+
+bool Frustum::intersects(const BoundingBox& box) const {
+    if (box.isEmpty()) return false;
+    vec3 c = box.center(), e = box.halfExtent();
+    for (const auto& plane : planes) {
+        GLfloat distance = plane[0] * c.x + plane[1] * c.y + plane[2] * c.z + plane[3];
+        GLfloat radius = std::fabs(plane[0]) * e.x + std::fabs(plane[1]) * e.y + std::fabs(plane[2]) * e.z;
+        if (distance + radius < 0.0f) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const {
+    for (const auto& plane : planes) {
+        GLfloat distance = plane[0] * sphere.center.x + plane[1] * sphere.center.y + plane[2] * sphere.center.z + plane[3];
+        if (distance + sphere.radius < 0.0f) return false;
+    }
+    return true;
+}
+
+std::size_t Frustum::cull(const BoundingBoxArray& boxes, std::size_t count, unsigned char* visible,
+                          CullStats* stats) const {
+    std::atomic<std::size_t> inside{0};
+    JobSystem::instance().parallel_for(count, CULL_GRAIN, [&](std::size_t begin, std::size_t end) {
+        inside += cullRange(boxes, begin, end, visible);
+    });
+
+    if (stats) {
+        stats->tested += static_cast<unsigned>(count);
+        stats->culled += static_cast<unsigned>(count - inside);
+    }
+    return inside;
+}
+
+std::size_t Frustum::cullRange(const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+                               unsigned char* visible) const {
+    const GLfloat* cx = boxes.centerX.data();
+    const GLfloat* cy = boxes.centerY.data();
+    const GLfloat* cz = boxes.centerZ.data();
+    const GLfloat* ex = boxes.extentX.data();
+    const GLfloat* ey = boxes.extentY.data();
+    const GLfloat* ez = boxes.extentZ.data();
+
+    std::size_t inside = 0;
+    std::size_t i = begin;
+#if CGV_SSE
+    // One box per lane; a lane is out as soon as any plane rejects it.
+    typedef cgvSimd S;
+    S::batch a[6], b[6], c[6], d[6], absA[6], absB[6], absC[6];
+    for (int p = 0; p < 6; ++p) {
+        a[p] = S::set1(planes[p][0]); absA[p] = S::set1(std::fabs(planes[p][0]));
+        b[p] = S::set1(planes[p][1]); absB[p] = S::set1(std::fabs(planes[p][1]));
+        c[p] = S::set1(planes[p][2]); absC[p] = S::set1(std::fabs(planes[p][2]));
+        d[p] = S::set1(planes[p][3]);
+    }
+    const S::batch zero = S::set1(0.0f);
+    for (const std::size_t whole = end - (end - begin) % S::WIDTH; i < whole; i += S::WIDTH) {
+        S::batch x = S::load(cx + i), y = S::load(cy + i), z = S::load(cz + i);
+        S::batch hx = S::load(ex + i), hy = S::load(ey + i), hz = S::load(ez + i);
+        S::batch outside = zero;
+        for (int p = 0; p < 6; ++p) {
+            S::batch distance = S::add(S::add(S::add(S::mul(a[p], x), S::mul(b[p], y)), S::mul(c[p], z)), d[p]);
+            S::batch radius = S::add(S::add(S::mul(absA[p], hx), S::mul(absB[p], hy)), S::mul(absC[p], hz));
+            outside = S::mask_or(outside, S::less(S::add(distance, radius), zero));
+        }
+        int bits = S::mask_bits(outside);
+        for (std::size_t k = 0; k < S::WIDTH; ++k) {
+            visible[i + k] = ((bits >> k) & 1) ? 0 : 1;
+            inside += visible[i + k];
+        }
+    }
+#endif
+    for (; i < end; ++i) {
+        visible[i] = 1;
+        for (const auto& plane : planes) {
+            GLfloat distance = plane[0] * cx[i] + plane[1] * cy[i] + plane[2] * cz[i] + plane[3];
+            GLfloat radius = std::fabs(plane[0]) * ex[i] + std::fabs(plane[1]) * ey[i] + std::fabs(plane[2]) * ez[i];
+            if (distance + radius < 0.0f) {
+                visible[i] = 0;
+                break;
+            }
+        }
+        inside += visible[i];
+    }
+    return inside;
+}
@@ -0,0 +1,44 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <cstddef>
+#include "BoundingVolume.h"
+#include "cgvMatrix4.h"
+
+// Objects tested against the frustum in a frame and how many of them were
+// skipped.
+struct CullStats {
+    unsigned tested = 0;
+    unsigned culled = 0;
+
+    void reset() { tested = culled = 0; }
+};
+
+// The six clipping planes of a camera, in the space its view-projection
+// matrix maps from (world space for projection * view). The tests are
+// conservative: a volume is only rejected when it lies wholly outside one
+// plane, so a few invisible objects near the corners still pass.
+class Frustum {
+public:
+    Frustum(); // no planes: everything is inside
+    explicit Frustum(const cgvMatrix4& viewProjection);
+
+    bool intersects(const BoundingBox& box) const;
+    bool intersects(const BoundingSphere& sphere) const;
+
+    // Tests boxes [0, count) several at a time, in slices on the job system,
+    // and sets visible[i] to 1 or 0. Returns how many are visible and adds
+    // the counts to stats if given.
+    std::size_t cull(const BoundingBoxArray& boxes, std::size_t count, unsigned char* visible,
+                     CullStats* stats = nullptr) const;
+
+private:
+    // One slice of cull: boxes [begin, end). Returns how many are visible.
+    std::size_t cullRange(const BoundingBoxArray& boxes, std::size_t begin, std::size_t end,
+                          unsigned char* visible) const;
+
+    // a, b, c, d with (a, b, c) of unit length; inside where ax + by + cz + d >= 0.
+    GLfloat planes[6][4];
+};
+
+#endif // FRUSTUM_H
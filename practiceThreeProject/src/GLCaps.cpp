@@ -0,0 +1,182 @@
+#include "GLCaps.h"
+#include <cstdio>
+#include <cstring>
+
+static void query_version(int& major, int& minor) {
+    static int cached_major = -1, cached_minor = -1;
+    if (cached_major < 0) {
+        cached_major = cached_minor = 0;
+        const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+        if (version) std::sscanf(version, "%d.%d", &cached_major, &cached_minor);
+    }
+    major = cached_major;
+    minor = cached_minor;
+}
+
+bool GLCaps::hasVersion(int major, int minor) {
+    int have_major, have_minor;
+    query_version(have_major, have_minor);
+    return have_major > major || (have_major == major && have_minor >= minor);
+}
+
+bool GLCaps::hasExtension(const char* name) {
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (!extensions) return false;
+
+    // Match whole, space-separated names only.
+    const std::size_t length = std::strlen(name);
+    for (const char* p = std::strstr(extensions, name); p; p = std::strstr(p + length, name)) {
+        bool starts = p == extensions || p[-1] == ' ';
+        bool ends = p[length] == ' ' || p[length] == '\0';
+        if (starts && ends) return true;
+    }
+    return false;
+}
+
+bool GLCaps::bufferObjects() {
+    static int supported = -1;
+    if (supported < 0) supported = hasVersion(1, 5) ? 1 : 0;
+    return supported == 1;
+}
+
+bool GLCaps::vertexArrayObjects() {
+    static int supported = -1;
+    if (supported < 0) {
+#if defined(__APPLE__) && defined(__MACH__)
+        supported = hasExtension("GL_APPLE_vertex_array_object") ? 1 : 0;
+#else
+        supported = (hasVersion(3, 0) || hasExtension("GL_ARB_vertex_array_object")) ? 1 : 0;
+#endif
+    }
+    return supported == 1;
+}
+
+bool GLCaps::shaders() {
+    static int supported = -1;
+    if (supported < 0) supported = hasVersion(2, 0) ? 1 : 0;
+    return supported == 1;
+}
+
+bool GLCaps::instancing() {
+    static int supported = -1;
+    if (supported < 0) {
+        bool divisor = hasVersion(3, 3) || hasExtension("GL_ARB_instanced_arrays");
+        bool draws = hasVersion(3, 1) || hasExtension("GL_ARB_draw_instanced");
+        supported = (shaders() && divisor && draws) ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+bool GLCaps::framebufferObjects() {
+    static int supported = -1;
+    if (supported < 0) {
+#if defined(__APPLE__) && defined(__MACH__)
+        supported = hasExtension("GL_EXT_framebuffer_object") ? 1 : 0;
+#else
+        supported = (hasVersion(3, 0) || hasExtension("GL_ARB_framebuffer_object")) ? 1 : 0;
+#endif
+    }
+    return supported == 1;
+}
+
+bool GLCaps::pixelBufferObjects() {
+    static int supported = -1;
+    if (supported < 0) {
+        supported = (hasVersion(2, 1) || hasExtension("GL_ARB_pixel_buffer_object")) ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+bool GLCaps::timerQueries() {
+    static int supported = -1;
+    if (supported < 0) {
+#if defined(__APPLE__) && defined(__MACH__)
+        supported = 0;
+#else
+        supported = (hasVersion(3, 3) || hasExtension("GL_ARB_timer_query")) ? 1 : 0;
+#endif
+    }
+    return supported == 1;
+}
+
+#if defined(__APPLE__) && defined(__MACH__)
+
+void GLCaps::genVertexArrays(GLsizei n, GLuint* arrays) { glGenVertexArraysAPPLE(n, arrays); }
+void GLCaps::bindVertexArray(GLuint array) { glBindVertexArrayAPPLE(array); }
+void GLCaps::deleteVertexArrays(GLsizei n, const GLuint* arrays) { glDeleteVertexArraysAPPLE(n, arrays); }
+
+void GLCaps::vertexAttribDivisor(GLuint index, GLuint divisor) { glVertexAttribDivisorARB(index, divisor); }
+void GLCaps::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    glDrawArraysInstancedARB(mode, first, count, instances);
+}
+void GLCaps::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+                                   GLsizei instances) {
+    glDrawElementsInstancedARB(mode, count, type, indices, instances);
+}
+
+void GLCaps::genFramebuffers(GLsizei n, GLuint* framebuffers) { glGenFramebuffersEXT(n, framebuffers); }
+void GLCaps::bindFramebuffer(GLuint framebuffer) { glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, framebuffer); }
+void GLCaps::deleteFramebuffers(GLsizei n, const GLuint* framebuffers) { glDeleteFramebuffersEXT(n, framebuffers); }
+void GLCaps::genRenderbuffers(GLsizei n, GLuint* renderbuffers) { glGenRenderbuffersEXT(n, renderbuffers); }
+void GLCaps::deleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) {
+    glDeleteRenderbuffersEXT(n, renderbuffers);
+}
+void GLCaps::attachRenderbuffer(GLuint renderbuffer, GLenum attachment, GLenum format, GLsizei width,
+                                GLsizei height) {
+    glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, renderbuffer);
+    glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, format, width, height);
+    glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, attachment, GL_RENDERBUFFER_EXT, renderbuffer);
+    glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, 0);
+}
+bool GLCaps::framebufferComplete() {
+    return glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) == GL_FRAMEBUFFER_COMPLETE_EXT;
+}
+
+void GLCaps::queryTimestamp(GLuint) {}
+bool GLCaps::queryAvailable(GLuint) { return false; }
+GLuint64 GLCaps::queryResult(GLuint) { return 0; }
+
+#else
+
+void GLCaps::genVertexArrays(GLsizei n, GLuint* arrays) { glGenVertexArrays(n, arrays); }
+void GLCaps::bindVertexArray(GLuint array) { glBindVertexArray(array); }
+void GLCaps::deleteVertexArrays(GLsizei n, const GLuint* arrays) { glDeleteVertexArrays(n, arrays); }
+
+void GLCaps::vertexAttribDivisor(GLuint index, GLuint divisor) { glVertexAttribDivisor(index, divisor); }
+void GLCaps::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    glDrawArraysInstanced(mode, first, count, instances);
+}
+void GLCaps::drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+                                   GLsizei instances) {
+    glDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+void GLCaps::genFramebuffers(GLsizei n, GLuint* framebuffers) { glGenFramebuffers(n, framebuffers); }
+void GLCaps::bindFramebuffer(GLuint framebuffer) { glBindFramebuffer(GL_FRAMEBUFFER, framebuffer); }
+void GLCaps::deleteFramebuffers(GLsizei n, const GLuint* framebuffers) { glDeleteFramebuffers(n, framebuffers); }
+void GLCaps::genRenderbuffers(GLsizei n, GLuint* renderbuffers) { glGenRenderbuffers(n, renderbuffers); }
+void GLCaps::deleteRenderbuffers(GLsizei n, const GLuint* renderbuffers) { glDeleteRenderbuffers(n, renderbuffers); }
+void GLCaps::attachRenderbuffer(GLuint renderbuffer, GLenum attachment, GLenum format, GLsizei width,
+                                GLsizei height) {
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, attachment, GL_RENDERBUFFER, renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+bool GLCaps::framebufferComplete() {
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void GLCaps::queryTimestamp(GLuint query) { glQueryCounter(query, GL_TIMESTAMP); }
+bool GLCaps::queryAvailable(GLuint query) {
+    GLuint available = 0;
+    glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    return available != 0;
+}
+GLuint64 GLCaps::queryResult(GLuint query) {
+    GLuint64 time = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &time);
+    return time;
+}
+
+#endif
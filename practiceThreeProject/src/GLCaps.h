@@ -0,0 +1,66 @@
+#ifndef GL_CAPS_H
+#define GL_CAPS_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#include <OpenGL/glext.h>
+#else
+#include <GL/glut.h>
+#include <GL/glext.h>
+#endif
+
+// Runtime queries for the optional GL features used by the renderer. The
+// answers are read from the current context on first use and cached, so they
+// must only be asked once a context exists.
+class GLCaps {
+public:
+    static bool hasVersion(int major, int minor);
+    static bool hasExtension(const char* name);
+
+    // Vertex/index buffer objects (GL 1.5)
+    static bool bufferObjects();
+    // Vertex array objects (GL 3.0, ARB or APPLE extension)
+    static bool vertexArrayObjects();
+    // GLSL vertex and fragment shaders (GL 2.0)
+    static bool shaders();
+    // Per-instance attributes and instanced draws (GL 3.3 or the ARB pair)
+    static bool instancing();
+    // Offscreen framebuffers with renderbuffer attachments (GL 3.0, ARB or EXT)
+    static bool framebufferObjects();
+    // Reading pixels into a buffer object without waiting (GL 2.1 or ARB)
+    static bool pixelBufferObjects();
+    // GPU timestamp queries (GL 3.3 or ARB; legacy macOS only has elapsed-time
+    // queries, which cannot nest, so it reports none)
+    static bool timerQueries();
+
+    // Vertex array objects have different entry points on legacy macOS.
+    static void genVertexArrays(GLsizei n, GLuint* arrays);
+    static void bindVertexArray(GLuint array);
+    static void deleteVertexArrays(GLsizei n, const GLuint* arrays);
+
+    // Instancing is only available through the ARB entry points there too.
+    static void vertexAttribDivisor(GLuint index, GLuint divisor);
+    static void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+    static void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices,
+                                      GLsizei instances);
+
+    // Framebuffer objects are only there as the EXT extension on legacy
+    // macOS. attachRenderbuffer allocates the storage and attaches it to the
+    // bound framebuffer.
+    static void genFramebuffers(GLsizei n, GLuint* framebuffers);
+    static void bindFramebuffer(GLuint framebuffer);
+    static void deleteFramebuffers(GLsizei n, const GLuint* framebuffers);
+    static void genRenderbuffers(GLsizei n, GLuint* renderbuffers);
+    static void deleteRenderbuffers(GLsizei n, const GLuint* renderbuffers);
+    static void attachRenderbuffer(GLuint renderbuffer, GLenum attachment, GLenum format, GLsizei width,
+                                   GLsizei height);
+    static bool framebufferComplete();
+
+    // Timestamp queries, for when timerQueries() is true. Results are in
+    // nanoseconds.
+    static void queryTimestamp(GLuint query);
+    static bool queryAvailable(GLuint query);
+    static GLuint64 queryResult(GLuint query);
+};
+
+#endif // GL_CAPS_H
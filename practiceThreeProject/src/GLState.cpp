@@ -0,0 +1,189 @@
+#include "GLState.h"
+#include <cstring>
+
+GLState::Counts GLState::counts;
+
+// One shadowed parameter; tag tells apart values that are equal but mean
+// different things (a light position under another view).
+struct ShadowSlot {
+    GLfloat value[4];
+    unsigned tag;
+    bool known;
+};
+
+// Stores value in the slot and returns true when it differs from what the
+// slot held.
+static bool update(ShadowSlot& slot, const GLfloat* value, int size, unsigned tag = 0) {
+    if (slot.known && slot.tag == tag && std::memcmp(slot.value, value, size * sizeof(GLfloat)) == 0) return false;
+    std::memcpy(slot.value, value, size * sizeof(GLfloat));
+    slot.tag = tag;
+    slot.known = true;
+    return true;
+}
+
+static const int LIGHT_COUNT = 8;
+static const int CAPABILITY_COUNT = 8 + LIGHT_COUNT;
+enum { MATERIAL_AMBIENT, MATERIAL_DIFFUSE, MATERIAL_SPECULAR, MATERIAL_SHININESS, MATERIAL_COUNT };
+enum { LIGHT_AMBIENT, LIGHT_DIFFUSE, LIGHT_SPECULAR, LIGHT_POSITION, LIGHT_SPOT_DIRECTION, LIGHT_SPOT_CUTOFF,
+       LIGHT_SPOT_EXPONENT, LIGHT_PARAMETER_COUNT };
+
+// 0 unknown, 1 disabled, 2 enabled.
+static unsigned char enables[CAPABILITY_COUNT];
+static ShadowSlot materials[MATERIAL_COUNT];
+static ShadowSlot lights[LIGHT_COUNT][LIGHT_PARAMETER_COUNT];
+static ShadowSlot light_model_ambient;
+static ShadowSlot line_width;
+static GLenum shade_mode;
+static bool shade_known;
+static GLuint bound_texture;
+static bool texture_known;
+
+static int capability_slot(GLenum capability) {
+    if (capability >= GL_LIGHT0 && capability < GL_LIGHT0 + LIGHT_COUNT) return 8 + (capability - GL_LIGHT0);
+    switch (capability) {
+        case GL_LIGHTING: return 0;
+        case GL_TEXTURE_2D: return 1;
+        case GL_DEPTH_TEST: return 2;
+        case GL_COLOR_MATERIAL: return 3;
+        case GL_NORMALIZE: return 4;
+        case GL_BLEND: return 5;
+        case GL_CULL_FACE: return 6;
+        case GL_SCISSOR_TEST: return 7;
+        default: return -1;
+    }
+}
+
+static int material_slot(GLenum name) {
+    switch (name) {
+        case GL_AMBIENT: return MATERIAL_AMBIENT;
+        case GL_DIFFUSE: return MATERIAL_DIFFUSE;
+        case GL_SPECULAR: return MATERIAL_SPECULAR;
+        case GL_SHININESS: return MATERIAL_SHININESS;
+        default: return -1;
+    }
+}
+
+static int light_slot(GLenum name, int& size) {
+    switch (name) {
+        case GL_AMBIENT: size = 4; return LIGHT_AMBIENT;
+        case GL_DIFFUSE: size = 4; return LIGHT_DIFFUSE;
+        case GL_SPECULAR: size = 4; return LIGHT_SPECULAR;
+        case GL_POSITION: size = 4; return LIGHT_POSITION;
+        case GL_SPOT_DIRECTION: size = 3; return LIGHT_SPOT_DIRECTION;
+        case GL_SPOT_CUTOFF: size = 1; return LIGHT_SPOT_CUTOFF;
+        case GL_SPOT_EXPONENT: size = 1; return LIGHT_SPOT_EXPONENT;
+        default: size = 0; return -1;
+    }
+}
+
+// Switching colour tracking either way leaves the ambient and diffuse
+// material at whatever glColor last set, which the shadow never sees.
+static void forget_tracked_material() {
+    materials[MATERIAL_AMBIENT].known = false;
+    materials[MATERIAL_DIFFUSE].known = false;
+}
+
+void GLState::invalidate() {
+    std::memset(enables, 0, sizeof(enables));
+    for (ShadowSlot& slot : materials) slot.known = false;
+    for (auto& parameters : lights) {
+        for (ShadowSlot& slot : parameters) slot.known = false;
+    }
+    light_model_ambient.known = false;
+    line_width.known = false;
+    shade_known = false;
+    texture_known = false;
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled) {
+    int slot = capability_slot(capability);
+    unsigned char wanted = enabled ? 2 : 1;
+    if (slot >= 0) {
+        if (enables[slot] == wanted) {
+            ++counts.filtered;
+            return;
+        }
+        enables[slot] = wanted;
+    }
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+    if (capability == GL_COLOR_MATERIAL) forget_tracked_material();
+    ++counts.issued;
+}
+
+void GLState::material(GLenum name, const GLfloat* value) {
+    int slot = material_slot(name);
+    // Unless colour tracking is known to be off, the next glColor may
+    // overwrite ambient and diffuse, so those always go through.
+    const bool tracked = slot == MATERIAL_AMBIENT || slot == MATERIAL_DIFFUSE;
+    if (tracked && enables[capability_slot(GL_COLOR_MATERIAL)] != 1) {
+        slot = -1;
+        forget_tracked_material();
+    }
+    if (slot >= 0 && !update(materials[slot], value, slot == MATERIAL_SHININESS ? 1 : 4)) {
+        ++counts.filtered;
+        return;
+    }
+    if (name == GL_AMBIENT_AND_DIFFUSE) forget_tracked_material();
+    glMaterialfv(GL_FRONT, name, value);
+    ++counts.issued;
+}
+
+void GLState::light(GLenum light, GLenum name, const GLfloat* value, unsigned viewVersion) {
+    int index = static_cast<int>(light) - GL_LIGHT0;
+    int size;
+    int slot = light_slot(name, size);
+    if (index >= 0 && index < LIGHT_COUNT && slot >= 0) {
+        bool transformed = slot == LIGHT_POSITION || slot == LIGHT_SPOT_DIRECTION;
+        if (!update(lights[index][slot], value, size, transformed ? viewVersion : 0)) {
+            ++counts.filtered;
+            return;
+        }
+    }
+    glLightfv(light, name, value);
+    ++counts.issued;
+}
+
+void GLState::lightModelAmbient(const GLfloat* value) {
+    if (!update(light_model_ambient, value, 4)) {
+        ++counts.filtered;
+        return;
+    }
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, value);
+    ++counts.issued;
+}
+
+void GLState::shadeModel(GLenum mode) {
+    if (shade_known && shade_mode == mode) {
+        ++counts.filtered;
+        return;
+    }
+    shade_mode = mode;
+    shade_known = true;
+    glShadeModel(mode);
+    ++counts.issued;
+}
+
+void GLState::bindTexture2D(GLuint texture) {
+    if (texture_known && bound_texture == texture) {
+        ++counts.filtered;
+        return;
+    }
+    bound_texture = texture;
+    texture_known = true;
+    glBindTexture(GL_TEXTURE_2D, texture);
+    ++counts.issued;
+}
+
+void GLState::textureDeleted(GLuint texture) {
+    if (texture_known && bound_texture == texture) bound_texture = 0;
+}
+
+void GLState::lineWidth(GLfloat width) {
+    if (!update(line_width, &width, 1)) {
+        ++counts.filtered;
+        return;
+    }
+    glLineWidth(width);
+    ++counts.issued;
+}
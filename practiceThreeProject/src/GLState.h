@@ -0,0 +1,68 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+// Shadow copy of the fixed-function state this project sets: enables,
+// front material, the eight lights, the light model ambient, the shade
+// model, the 2D texture binding and the line width. Setting a value the
+// shadow already holds does not reach GL, which under a software GL saves
+// real work per call.
+//
+// The shadow is only right while every change goes through here. Code that
+// calls GL directly either restores what it changed itself (glPushAttrib /
+// glPopAttrib) or calls invalidate() afterwards.
+//
+// With GL_COLOR_MATERIAL on, glColor rewrites the ambient and diffuse
+// material, so those two are only filtered while it is known to be off.
+//
+// Light positions and spot directions are transformed by the modelview
+// current when they are set, so those two are only filtered when set under
+// the same view (SceneNode's view version) as before.
+class GLState {
+public:
+    // Calls asked for, split into those that reached GL and those dropped.
+    struct Counts {
+        unsigned issued = 0;
+        unsigned filtered = 0;
+        unsigned requested() const { return issued + filtered; }
+    };
+
+    // Forgets everything: the next call of each kind goes to GL.
+    static void invalidate();
+
+    static void enable(GLenum capability) { setEnabled(capability, true); }
+    static void disable(GLenum capability) { setEnabled(capability, false); }
+    static void setEnabled(GLenum capability, bool enabled);
+
+    // GL_FRONT material: GL_AMBIENT, GL_DIFFUSE, GL_SPECULAR (4 values) or
+    // GL_SHININESS.
+    static void material(GLenum name, const GLfloat* value);
+    static void material(GLenum name, GLfloat value) { material(name, &value); }
+
+    // GL_AMBIENT, GL_DIFFUSE, GL_SPECULAR, GL_POSITION, GL_SPOT_DIRECTION,
+    // GL_SPOT_CUTOFF or GL_SPOT_EXPONENT of GL_LIGHT0 + n. viewVersion is
+    // the view the modelview holds, for the two transformed parameters.
+    static void light(GLenum light, GLenum name, const GLfloat* value, unsigned viewVersion = 0);
+    static void light(GLenum light, GLenum name, GLfloat value) { GLState::light(light, name, &value); }
+
+    static void lightModelAmbient(const GLfloat* value);
+    static void shadeModel(GLenum mode);
+    static void bindTexture2D(GLuint texture);
+    // Deleting the bound texture binds 0; GL may hand the name out again.
+    static void textureDeleted(GLuint texture);
+    static void lineWidth(GLfloat width);
+
+    // Running totals since the last reset.
+    static const Counts& getCounts() { return counts; }
+    static void resetCounts() { counts = Counts(); }
+
+private:
+    static Counts counts;
+};
+
+#endif // GL_STATE_H
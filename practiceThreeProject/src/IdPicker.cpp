@@ -0,0 +1,161 @@
+#include "IdPicker.h"
+#include "Object3D.h"
+#include <algorithm>
+#include <iostream>
+
+Object3D* IdPickResult::object(GLuint id) const {
+    int k = IdPicker::objectOf(id);
+    return k >= 0 && k < static_cast<int>(objects.size()) ? objects[k] : nullptr;
+}
+
+IdPicker::~IdPicker() {
+    releaseFramebuffer();
+    if (pixelBuffer) glDeleteBuffers(1, &pixelBuffer);
+}
+
+bool IdPicker::isSupported() {
+    return GLCaps::framebufferObjects() && GLCaps::pixelBufferObjects();
+}
+
+void IdPicker::setColor(GLuint id) {
+    glColor4ub(static_cast<GLubyte>(id >> 24), static_cast<GLubyte>(id >> 16), static_cast<GLubyte>(id >> 8),
+               static_cast<GLubyte>(id));
+}
+
+void IdPicker::request(int x, int y, int width, int height) {
+    pending.x = x;
+    pending.y = y;
+    pending.width = width;
+    pending.height = height;
+    queued = true;
+}
+
+bool IdPicker::ensureFramebuffer(int width, int height) {
+    if (framebuffer && width == framebufferWidth && height == framebufferHeight) return true;
+    releaseFramebuffer();
+
+    // RGBA8 so all four ID bytes survive; the window may have no alpha.
+    GLCaps::genFramebuffers(1, &framebuffer);
+    GLCaps::genRenderbuffers(1, &colorBuffer);
+    GLCaps::genRenderbuffers(1, &depthBuffer);
+    GLCaps::bindFramebuffer(framebuffer);
+    GLCaps::attachRenderbuffer(colorBuffer, GL_COLOR_ATTACHMENT0, GL_RGBA8, width, height);
+    GLCaps::attachRenderbuffer(depthBuffer, GL_DEPTH_ATTACHMENT, GL_DEPTH_COMPONENT24, width, height);
+    bool complete = GLCaps::framebufferComplete();
+    GLCaps::bindFramebuffer(0);
+    if (!complete) {
+        std::cerr << "ID picking framebuffer is incomplete" << std::endl;
+        releaseFramebuffer();
+        return false;
+    }
+    framebufferWidth = width;
+    framebufferHeight = height;
+    return true;
+}
+
+void IdPicker::releaseFramebuffer() {
+    if (framebuffer) GLCaps::deleteFramebuffers(1, &framebuffer);
+    if (colorBuffer) GLCaps::deleteRenderbuffers(1, &colorBuffer);
+    if (depthBuffer) GLCaps::deleteRenderbuffers(1, &depthBuffer);
+    framebuffer = colorBuffer = depthBuffer = 0;
+    framebufferWidth = framebufferHeight = 0;
+}
+
+void IdPicker::render(const std::vector<Object3D*>& objects, int windowWidth, int windowHeight) {
+    if (!queued || inFlight || !isSupported()) return;
+    queued = false;
+
+    int x0 = std::max(0, pending.x), x1 = std::min(windowWidth, pending.x + pending.width);
+    int y0 = std::max(0, pending.y), y1 = std::min(windowHeight, pending.y + pending.height);
+    if (x1 <= x0 || y1 <= y0) return; // nothing of it inside the window
+    if (!ensureFramebuffer(windowWidth, windowHeight)) return;
+
+    readback.x = x0;
+    readback.y = y0;
+    readback.width = x1 - x0;
+    readback.height = y1 - y0;
+    readback.objects = objects;
+    const int glY = windowHeight - y1; // GL rows start at the bottom
+
+    GLCaps::bindFramebuffer(framebuffer);
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_SCISSOR_BIT | GL_LIGHTING_BIT |
+                 GL_CURRENT_BIT);
+    // Anything that could change a colour byte is off; only the rectangle
+    // is cleared and rasterised. These bypass GLState on purpose: the pop
+    // below puts back exactly what its shadow holds, so drawIds() must not
+    // go through it either.
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_BLEND);
+    glDisable(GL_DITHER);
+    glDisable(GL_FOG);
+    glDisable(GL_ALPHA_TEST);
+    glShadeModel(GL_FLAT);
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x0, glY, readback.width, readback.height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    for (std::size_t k = 0; k < objects.size(); ++k) objects[k]->drawIds(objectBits(static_cast<int>(k)));
+
+    // Into the pixel buffer: glReadPixels only queues the copy.
+    std::size_t size = static_cast<std::size_t>(readback.width) * readback.height * 4;
+    if (!pixelBuffer) glGenBuffers(1, &pixelBuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+    if (size > pixelBufferSize) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        pixelBufferSize = size;
+    }
+    glReadPixels(x0, glY, readback.width, readback.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glPopAttrib();
+    GLCaps::bindFramebuffer(0);
+    inFlight = true;
+}
+
+bool IdPicker::collect(IdPickResult& result) {
+    if (!inFlight) return false;
+    inFlight = false;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+    const GLubyte* bytes = static_cast<const GLubyte*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    if (!bytes) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return false;
+    }
+
+    result.x = readback.x;
+    result.y = readback.y;
+    result.width = readback.width;
+    result.height = readback.height;
+    result.objects = readback.objects;
+    result.pixels.resize(static_cast<std::size_t>(result.width) * result.height);
+    for (int row = 0; row < result.height; ++row) {
+        // The buffer's first row is the bottom one.
+        const GLubyte* p = bytes + static_cast<std::size_t>(result.height - 1 - row) * result.width * 4;
+        GLuint* out = &result.pixels[static_cast<std::size_t>(row) * result.width];
+        for (int col = 0; col < result.width; ++col, p += 4) {
+            out[col] = (GLuint(p[0]) << 24) | (GLuint(p[1]) << 16) | (GLuint(p[2]) << 8) | GLuint(p[3]);
+        }
+    }
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::vector<GLuint> sorted(result.pixels);
+    std::sort(sorted.begin(), sorted.end());
+    result.coverage.clear();
+    for (std::size_t i = 0; i < sorted.size();) {
+        std::size_t j = i;
+        while (j < sorted.size() && sorted[j] == sorted[i]) ++j;
+        if (sorted[i] != 0) result.coverage.emplace_back(sorted[i], static_cast<unsigned>(j - i));
+        i = j;
+    }
+    std::stable_sort(result.coverage.begin(), result.coverage.end(),
+                     [](const std::pair<GLuint, unsigned>& a, const std::pair<GLuint, unsigned>& b) {
+                         return a.second > b.second;
+                     });
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef ID_PICKER_H
+#define ID_PICKER_H
+
+#include <utility>
+#include <vector>
+#include "GLCaps.h"
+
+class Object3D;
+
+// Pixels of a picked window rectangle and what they showed.
+struct IdPickResult {
+    int x = 0, y = 0, width = 0, height = 0; // window rectangle, y down
+    std::vector<GLuint> pixels;               // IDs, row by row from the top
+    std::vector<Object3D*> objects;           // the list the IDs index
+    // Every ID seen and on how many pixels, most covered first.
+    std::vector<std::pair<GLuint, unsigned>> coverage;
+
+    GLuint at(int px, int py) const { return pixels[py * width + px]; }
+    Object3D* object(GLuint id) const;
+};
+
+// Picking on the GPU: every object draws itself in flat ID colours into an
+// offscreen framebuffer, and the requested rectangle is read back through
+// a pixel buffer object. The readback is only mapped on the next frame, by
+// which time the GPU has long finished it, so picking never waits for the
+// pipeline to drain the way glReadPixels into client memory does.
+//
+// An ID is 32 bits: the object's index in the list plus one in the top
+// byte, and the part or triangle that was hit in the other 24. 0 is the
+// background.
+class IdPicker {
+public:
+    IdPicker() = default;
+    ~IdPicker();
+
+    IdPicker(const IdPicker&) = delete;
+    IdPicker& operator=(const IdPicker&) = delete;
+
+    // Needs a context with framebuffer and pixel buffer objects.
+    static bool isSupported();
+
+    static GLuint objectBits(int object) { return static_cast<GLuint>(object + 1) << 24; }
+    static int objectOf(GLuint id) { return static_cast<int>(id >> 24) - 1; }
+    static int primitiveOf(GLuint id) { return static_cast<int>(id & 0xffffff); }
+    // Sets the current colour to the ID's four bytes, for the ID pass.
+    static void setColor(GLuint id);
+
+    // Asks for the window rectangle (y down, as GLUT reports it) to be
+    // picked by the next render(). Replaces a request not rendered yet.
+    void request(int x, int y, int width = 1, int height = 1);
+    bool isPending() const { return queued || inFlight; }
+
+    // With the camera matrices set, draws the objects' IDs into the
+    // requested rectangle and starts its readback. Does nothing without a
+    // request or while the previous readback has not been collected.
+    void render(const std::vector<Object3D*>& objects, int windowWidth, int windowHeight);
+
+    // Maps the readback started by the last render() and fills result.
+    // Returns false if there is none.
+    bool collect(IdPickResult& result);
+
+private:
+    GLuint framebuffer = 0, colorBuffer = 0, depthBuffer = 0;
+    int framebufferWidth = 0, framebufferHeight = 0;
+    GLuint pixelBuffer = 0;
+    std::size_t pixelBufferSize = 0;
+
+    IdPickResult pending;  // rectangle of the queued request
+    IdPickResult readback; // rectangle and objects of the one in flight
+    bool queued = false;
+    bool inFlight = false;
+
+    bool ensureFramebuffer(int width, int height);
+    void releaseFramebuffer();
+};
+
+#endif // ID_PICKER_H
@@ -0,0 +1,88 @@
+#include "InputLog.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+
+static const char LOG_MAGIC[8] = {'C', 'G', 'V', 'I', 'N', 'P', 'U', 'T'};
+static const std::uint32_t LOG_VERSION = 1;
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct LogHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::int32_t window_width;
+    std::int32_t window_height;
+};
+
+static_assert(sizeof(InputEvent) == 16, "InputEvent must be a packed 16-byte record");
+
+bool InputRecorder::start(const std::string& path, int windowWidth, int windowHeight, double nowMs) {
+    stop();
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    LogHeader header;
+    std::memcpy(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC));
+    header.version = LOG_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.window_width = windowWidth;
+    header.window_height = windowHeight;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.flush();
+    startMs = nowMs;
+    count = 0;
+    return static_cast<bool>(out);
+}
+
+void InputRecorder::stop() {
+    if (out.is_open()) out.close();
+}
+
+void InputRecorder::record(InputEvent event, double nowMs) {
+    if (!out.is_open()) return;
+    event.time = static_cast<std::uint32_t>(std::max(0.0, nowMs - startMs));
+    event.padding = 0;
+    out.write(reinterpret_cast<const char*>(&event), sizeof(event));
+    out.flush();
+    ++count;
+}
+
+bool InputReplay::load(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(LogHeader)) return false;
+
+    LogHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, LOG_MAGIC, sizeof(LOG_MAGIC)) != 0 || header.version != LOG_VERSION ||
+        header.byte_order != BYTE_ORDER_MARK) {
+        return false;
+    }
+    // A log cut short by a crash keeps its whole events.
+    const std::size_t count = (file.size() - sizeof(LogHeader)) / sizeof(InputEvent);
+    events.resize(count);
+    if (count) std::memcpy(events.data(), file.data() + sizeof(LogHeader), count * sizeof(InputEvent));
+    for (std::size_t e = 0; e < events.size(); ++e) {
+        if (events[e].type > InputEvent::MENU || (e > 0 && events[e].time < events[e - 1].time)) return false;
+    }
+    windowWidth = header.window_width;
+    windowHeight = header.window_height;
+    position = 0;
+    return true;
+}
+
+bool InputReplay::next(double nowMs, InputEvent& event) {
+    if (position == events.size() || events[position].time > nowMs) return false;
+    event = events[position++];
+    return true;
+}
+
+void InputReplay::getMaxWindowSize(int& width, int& height) const {
+    width = windowWidth;
+    height = windowHeight;
+    for (const InputEvent& event : events) {
+        if (event.type != InputEvent::RESHAPE) continue;
+        width = std::max<int>(width, event.x);
+        height = std::max<int>(height, event.y);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// One GLUT input callback, or menu selection, as igvInterface received it.
+// time is in milliseconds since the recording started; modifiers are the
+// GLUT_ACTIVE_* bits for key and mouse events (GLUT cannot report them during
+// motion).
+struct InputEvent {
+    enum Type : std::uint8_t { KEY, SPECIAL_KEY, MOUSE, MOTION, PASSIVE_MOTION, ENTRY, RESHAPE, MENU };
+
+    std::uint32_t time;
+    std::uint8_t type;
+    std::uint8_t modifiers;
+    std::uint16_t code;  // key, special key, mouse button or menu
+    std::int16_t state;  // mouse button or entry state, or menu option
+    std::int16_t x, y;   // or width and height for RESHAPE
+    std::uint16_t padding;
+};
+
+// Appends events to a session log (.cgvinput): a small header with the window
+// size, then the events as 16-byte records. Each event is flushed as it is
+// written, so the log survives the program exiting from inside GLUT.
+//
+// Times are taken from the caller's clock, relative to the start() call.
+class InputRecorder {
+public:
+    bool start(const std::string& path, int windowWidth, int windowHeight, double nowMs);
+    void stop();
+    bool isRecording() const { return out.is_open(); }
+
+    void record(InputEvent event, double nowMs);
+
+    std::size_t getCount() const { return count; }
+
+private:
+    std::ofstream out;
+    double startMs = 0.0;
+    std::size_t count = 0;
+};
+
+// A session log read back, handing out its events in order as the replay
+// clock reaches them.
+class InputReplay {
+public:
+    bool load(const std::string& path);
+
+    // The next event due at or before nowMs, if any.
+    bool next(double nowMs, InputEvent& event);
+    bool isFinished() const { return position == events.size(); }
+    void rewind() { position = 0; }
+
+    int getWindowWidth() const { return windowWidth; }
+    int getWindowHeight() const { return windowHeight; }
+    // The largest the window got, counting reshapes.
+    void getMaxWindowSize(int& width, int& height) const;
+    double getDurationMs() const { return events.empty() ? 0.0 : events.back().time; }
+    std::size_t getCount() const { return events.size(); }
+
+private:
+    std::vector<InputEvent> events;
+    std::size_t position = 0;
+    int windowWidth = 0, windowHeight = 0;
+};
+
+#endif // INPUT_LOG_H
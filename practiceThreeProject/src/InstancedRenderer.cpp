@@ -0,0 +1,264 @@
+#include "InstancedRenderer.h"
+#include "GLCaps.h"
+#include "Profiler.h"
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+// Generic attribute slots for the per-instance data, clear of the ones some
+// drivers alias to gl_Vertex, gl_Normal and gl_Color.
+static const GLuint MODEL_ATTRIBUTE = 10; // four consecutive slots, one per column
+static const GLuint COLOR_ATTRIBUTE = 14;
+
+static const unsigned MAX_LIGHTS = 8;
+static const unsigned UNLIT = 1u << MAX_LIGHTS; // program key with GL_LIGHTING off
+
+static_assert(sizeof(InstanceBatch::Instance) == 20 * sizeof(GLfloat), "instance data must be tightly packed");
+
+// Per-vertex lighting equivalent to the fixed-function pipeline with
+// GL_COLOR_MATERIAL on ambient and diffuse, and no specular term. LIGHTS is
+// replaced by one APPLY_LIGHT per enabled light, so every program only pays
+// for the lights it uses, with constant indices into gl_LightSource.
+static const char* VERTEX_SHADER = R"(#version 120
+attribute vec4 instanceModel0;
+attribute vec4 instanceModel1;
+attribute vec4 instanceModel2;
+attribute vec4 instanceModel3;
+attribute vec4 instanceColor;
+
+#define APPLY_LIGHT(i) { \
+    vec3 toLight; \
+    float attenuation = 1.0; \
+    if (gl_LightSource[i].position.w == 0.0) { \
+        toLight = normalize(gl_LightSource[i].position.xyz); \
+    } else { \
+        vec3 offset = gl_LightSource[i].position.xyz - eye.xyz; \
+        float distance = length(offset); \
+        toLight = offset / distance; \
+        attenuation = 1.0 / (gl_LightSource[i].constantAttenuation \
+                             + gl_LightSource[i].linearAttenuation * distance \
+                             + gl_LightSource[i].quadraticAttenuation * distance * distance); \
+        if (gl_LightSource[i].spotCutoff <= 90.0) { \
+            float spot = dot(-toLight, normalize(gl_LightSource[i].spotDirection)); \
+            attenuation *= spot < gl_LightSource[i].spotCosCutoff \
+                ? 0.0 : pow(max(spot, 0.0), gl_LightSource[i].spotExponent); \
+        } \
+    } \
+    float diffuse = max(dot(normal, toLight), 0.0); \
+    color += attenuation * (gl_LightSource[i].ambient + diffuse * gl_LightSource[i].diffuse) * instanceColor; \
+}
+
+void main() {
+    mat4 model = mat4(instanceModel0, instanceModel1, instanceModel2, instanceModel3);
+    vec4 eye = gl_ModelViewMatrix * (model * gl_Vertex);
+    vec3 normal = normalize(gl_NormalMatrix * (mat3(model) * gl_Normal));
+
+    vec4 color = gl_LightModel.ambient * instanceColor;
+LIGHTS
+    gl_FrontColor = vec4(color.rgb, instanceColor.a);
+    gl_Position = gl_ProjectionMatrix * eye;
+}
+)";
+
+static const char* FRAGMENT_SHADER = R"(#version 120
+void main() {
+    gl_FragColor = gl_Color;
+}
+)";
+
+static GLuint compile_shader(GLenum type, const char* source) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Instancing shader failed to compile: " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+InstanceBatch::~InstanceBatch() {
+    release();
+}
+
+void InstanceBatch::bind() {
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (dirty) {
+        const std::size_t bytes = instances.size() * sizeof(Instance);
+        if (instances.size() != uploaded_count) {
+            glBufferData(GL_ARRAY_BUFFER, bytes, instances.data(), GL_DYNAMIC_DRAW);
+            uploaded_count = instances.size();
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+        }
+        dirty = false;
+    }
+}
+
+void InstanceBatch::release() {
+    if (buffer != 0) glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    uploaded_count = 0;
+    dirty = true;
+}
+
+InstancedRenderer::~InstancedRenderer() {
+    for (auto const& [mask, program] : programs) {
+        if (program != 0) glDeleteProgram(program);
+    }
+}
+
+bool InstancedRenderer::init() {
+    if (available) return true;
+    if (!GLCaps::instancing() || !GLCaps::bufferObjects()) {
+        std::cerr << "Instanced drawing not supported, drawing instances one by one" << std::endl;
+        return false;
+    }
+    // Build the unlit variant now so a broken driver shows up at start-up.
+    available = programFor(UNLIT) != 0;
+    return available;
+}
+
+GLuint InstancedRenderer::programFor(unsigned lightMask) {
+    auto it = programs.find(lightMask);
+    if (it != programs.end()) return it->second;
+
+    std::string lights;
+    if (lightMask == UNLIT) {
+        lights = "    color = instanceColor;\n";
+    } else {
+        for (unsigned i = 0; i < MAX_LIGHTS; ++i) {
+            if (lightMask & (1u << i)) lights += "    APPLY_LIGHT(" + std::to_string(i) + ")\n";
+        }
+    }
+    std::string source = VERTEX_SHADER;
+    source.replace(source.find("LIGHTS"), 6, lights);
+
+    GLuint program = 0;
+    GLuint vertex = compile_shader(GL_VERTEX_SHADER, source.c_str());
+    GLuint fragment = compile_shader(GL_FRAGMENT_SHADER, FRAGMENT_SHADER);
+    if (vertex != 0 && fragment != 0) {
+        program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glBindAttribLocation(program, MODEL_ATTRIBUTE + 0, "instanceModel0");
+        glBindAttribLocation(program, MODEL_ATTRIBUTE + 1, "instanceModel1");
+        glBindAttribLocation(program, MODEL_ATTRIBUTE + 2, "instanceModel2");
+        glBindAttribLocation(program, MODEL_ATTRIBUTE + 3, "instanceModel3");
+        glBindAttribLocation(program, COLOR_ATTRIBUTE, "instanceColor");
+        glLinkProgram(program);
+
+        GLint ok = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            char log[1024];
+            glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+            std::cerr << "Instancing shader failed to link: " << log << std::endl;
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+    if (vertex != 0) glDeleteShader(vertex);
+    if (fragment != 0) glDeleteShader(fragment);
+
+    // Failures are remembered too, so they are not retried every frame.
+    programs[lightMask] = program;
+    return program;
+}
+
+bool InstancedRenderer::begin(InstanceBatch& batch) {
+    // The shader cannot see which lights are switched on, so each
+    // combination gets its own program.
+    unsigned lightMask = 0;
+    if (glIsEnabled(GL_LIGHTING)) {
+        for (unsigned i = 0; i < MAX_LIGHTS; ++i) {
+            if (glIsEnabled(GL_LIGHT0 + i)) lightMask |= 1u << i;
+        }
+    } else {
+        lightMask = UNLIT;
+    }
+    GLuint program = programFor(lightMask);
+    if (program == 0) return false;
+    glUseProgram(program);
+
+    batch.bind();
+    const GLsizei stride = sizeof(InstanceBatch::Instance);
+    for (GLuint column = 0; column < 4; ++column) {
+        GLuint slot = MODEL_ATTRIBUTE + column;
+        glEnableVertexAttribArray(slot);
+        glVertexAttribPointer(slot, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const GLvoid*>(column * 4 * sizeof(GLfloat)));
+        GLCaps::vertexAttribDivisor(slot, 1);
+    }
+    glEnableVertexAttribArray(COLOR_ATTRIBUTE);
+    glVertexAttribPointer(COLOR_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, stride,
+                          reinterpret_cast<const GLvoid*>(offsetof(InstanceBatch::Instance, color)));
+    GLCaps::vertexAttribDivisor(COLOR_ATTRIBUTE, 1);
+    return true;
+}
+
+void InstancedRenderer::end() {
+    // The mesh's vertex array object records these, so undo them before it
+    // is used again by the fixed-function path.
+    for (GLuint slot = MODEL_ATTRIBUTE; slot <= COLOR_ATTRIBUTE; ++slot) {
+        GLCaps::vertexAttribDivisor(slot, 0);
+        glDisableVertexAttribArray(slot);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glUseProgram(0);
+}
+
+void InstancedRenderer::drawMesh(cgvTriangleMesh& mesh, InstanceBatch& batch, std::size_t level) {
+    if (batch.size() == 0) return;
+    if (mesh.bind_buffers() == 0) return;
+    GLsizei count = static_cast<GLsizei>(mesh.get_lod(level).count);
+    const GLvoid* offset = mesh.lod_offset(level);
+
+    if (isInstanced() && begin(batch)) {
+        GLCaps::drawElementsInstanced(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset,
+                                      static_cast<GLsizei>(batch.size()));
+        end();
+        ++drawCalls;
+    } else {
+        for (const auto& instance : batch.get_instances()) {
+            glPushMatrix();
+            glMultMatrixf(instance.model.data());
+            glColor4fv(instance.color);
+            glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, offset);
+            glPopMatrix();
+        }
+        drawCalls += batch.size();
+    }
+    Profiler::instance().addTriangles(std::uint64_t(count / 3) * batch.size());
+    mesh.unbind_buffers();
+}
+
+void InstancedRenderer::drawPrimitive(const PrimitiveCache::Range& range, InstanceBatch& batch) {
+    if (batch.size() == 0) return;
+    PrimitiveCache& cache = PrimitiveCache::instance();
+    cache.bind();
+
+    if (isInstanced() && begin(batch)) {
+        GLCaps::drawArraysInstanced(GL_TRIANGLES, range.first, range.count, static_cast<GLsizei>(batch.size()));
+        end();
+        ++drawCalls;
+    } else {
+        for (const auto& instance : batch.get_instances()) {
+            glPushMatrix();
+            glMultMatrixf(instance.model.data());
+            glColor4fv(instance.color);
+            glDrawArrays(GL_TRIANGLES, range.first, range.count);
+            glPopMatrix();
+        }
+        drawCalls += batch.size();
+    }
+    Profiler::instance().addTriangles(std::uint64_t(range.count / 3) * batch.size());
+    cache.unbind();
+}
@@ -0,0 +1,96 @@
+#ifndef INSTANCED_RENDERER_H
+#define INSTANCED_RENDERER_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+#include <map>
+#include <vector>
+#include "cgvMatrix4.h"
+#include "cgvTriangleMesh.h"
+#include "PrimitiveCache.h"
+
+// Per-instance data of one batch: a model matrix and a colour per copy. The
+// CPU array is authoritative and is copied to a GL buffer when it changes.
+class InstanceBatch {
+public:
+    struct Instance {
+        cgvMatrix4 model;
+        GLfloat color[4];
+    };
+
+    InstanceBatch() = default;
+    ~InstanceBatch();
+
+    InstanceBatch(const InstanceBatch&) = delete;
+    InstanceBatch& operator=(const InstanceBatch&) = delete;
+
+    std::vector<Instance>& get_instances() { dirty = true; return instances; }
+    const std::vector<Instance>& get_instances() const { return instances; }
+    std::size_t size() const { return instances.size(); }
+
+    // Binds the instance buffer, uploading the array first if it changed.
+    void bind();
+    void release();
+
+private:
+    std::vector<Instance> instances;
+    GLuint buffer = 0;
+    std::size_t uploaded_count = 0;
+    bool dirty = true;
+};
+
+// Draws every instance of a batch with one instanced draw call. The vertex
+// shader reads the model matrix and colour from per-instance attributes and
+// reproduces the fixed-function lighting of the rest of the scene, so the
+// crowd looks like objects drawn one by one.
+//
+// Without instancing support, or with it switched off, each instance is drawn
+// with its own glMultMatrixf and draw call, which is also the baseline the
+// instanced path is measured against. It is off by default: on the only
+// driver measured so far (Mesa llvmpipe) the per-vertex matrix work in the
+// shader makes it 15-30% slower than one call per instance. Turn it on with
+// 'v', or with --instanced in the benchmark, to compare on another driver.
+class InstancedRenderer {
+public:
+    InstancedRenderer() = default;
+    ~InstancedRenderer();
+
+    InstancedRenderer(const InstancedRenderer&) = delete;
+    InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+
+    // Compiles the shader. Needs a current context; false if instancing is
+    // unavailable, in which case draws fall back to one call per instance.
+    bool init();
+
+    bool isInstanced() const { return enabled && available; }
+    bool isEnabled() const { return enabled; } // requested, whether or not available
+    bool isAvailable() const { return available; }
+    void setEnabled(bool _enabled) { enabled = _enabled; }
+
+    // Draw calls issued by the last frame, reset by beginFrame().
+    void beginFrame() { drawCalls = 0; }
+    unsigned getDrawCalls() const { return drawCalls; }
+
+    // The modelview matrix must hold the camera view when these are called.
+    // drawMesh draws the given level of detail of the mesh.
+    void drawMesh(cgvTriangleMesh& mesh, InstanceBatch& batch, std::size_t level = 0);
+    void drawPrimitive(const PrimitiveCache::Range& range, InstanceBatch& batch);
+
+private:
+    std::map<unsigned, GLuint> programs; // by mask of enabled lights
+    bool available = false;
+    bool enabled = false;
+    unsigned drawCalls = 0;
+
+    GLuint programFor(unsigned lightMask);
+    // Selects the program and binds the instance attributes; false if the
+    // program could not be built, in which case nothing was changed.
+    bool begin(InstanceBatch& batch);
+    void end();
+};
+
+#endif // INSTANCED_RENDERER_H
@@ -0,0 +1,258 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+
+// The pool a thread works for and its index there; -1 outside any pool.
+static thread_local const JobSystem* current_system = nullptr;
+static thread_local int current_worker = -1;
+// The batch of the job the thread is running; null between jobs.
+static thread_local const JobCounter* current_batch = nullptr;
+
+// The batch a job queued now belongs to: that of the job queuing it, or for
+// a job queued from outside any job, the counter it is queued with.
+static const JobCounter* batch_for(const JobCounter* counter) {
+    return current_batch ? current_batch : counter;
+}
+
+static unsigned default_workers = 0; // 0: from the hardware
+
+// A waiting thread with nothing to run yields this many times before it
+// starts sleeping between checks.
+static const int WAIT_SPINS = 64;
+static const std::chrono::microseconds WAIT_SLEEP(100);
+
+JobSystem& JobSystem::instance() {
+    static JobSystem* system =
+        new JobSystem(default_workers ? default_workers : std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return *system;
+}
+
+void JobSystem::set_worker_count(unsigned count) {
+    default_workers = count;
+}
+
+JobSystem::JobSystem(unsigned worker_count) {
+    worker_count = std::max(1u, worker_count);
+    active_workers = worker_count;
+    for (unsigned i = 0; i < worker_count; ++i) workers.push_back(std::make_unique<Worker>());
+    for (unsigned i = 0; i < worker_count; ++i) workers[i]->thread = std::thread(&JobSystem::worker_loop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    limit_wake.notify_all();
+    for (auto& worker : workers) worker->thread.join();
+}
+
+unsigned JobSystem::thread_count() const {
+    return active_workers + 1;
+}
+
+void JobSystem::set_thread_limit(unsigned limit) {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        active_workers = limit == 0 ? worker_count() : std::min(worker_count(), std::max(1u, limit) - 1);
+    }
+    wake.notify_all();
+    limit_wake.notify_all();
+}
+
+void JobSystem::run(Job job, JobCounter* counter) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    push({std::move(job), counter, batch_for(counter)});
+}
+
+void JobSystem::run_after(JobCounter& dependency, Job job, JobCounter* counter) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    const JobCounter* batch = batch_for(counter);
+    {
+        // finish() takes the continuations under the same lock after the
+        // count reaches zero, so a job is either added before that or run now.
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (!dependency.done()) {
+            dependency.continuations.push_back([this, job = std::move(job), counter, batch]() mutable {
+                push({std::move(job), counter, batch});
+            });
+            return;
+        }
+    }
+    push({std::move(job), counter, batch});
+}
+
+void JobSystem::run_background(Job job, JobCounter* counter) {
+    if (counter) counter->pending.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        background.push_back({std::move(job), counter, batch_for(counter)});
+    }
+    ++background_queued;
+    notify();
+}
+
+void JobSystem::push(Task task) {
+    if (current_system == this) {
+        Worker& worker = *workers[current_worker];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        injected.push_back(std::move(task));
+    }
+    ++queued;
+    notify();
+}
+
+void JobSystem::notify() {
+    // A worker counts itself as a sleeper before it checks the queue counts,
+    // and the counts went up before this check, so either it sees the new
+    // job or we see it. Most pushes find every worker busy and skip the lock.
+    if (sleepers.load() == 0) return;
+    { std::lock_guard<std::mutex> lock(sleep_mutex); }
+    wake.notify_one();
+}
+
+// Takes the first task of tasks that belongs to batch, or the front one if
+// batch is null.
+bool JobSystem::take_front(std::deque<Task>& tasks, const JobCounter* batch, Task& task) {
+    for (auto it = tasks.begin(); it != tasks.end(); ++it) {
+        if (batch && it->batch != batch) continue;
+        task = std::move(*it);
+        tasks.erase(it);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::pop(int self, bool take_background, const JobCounter* batch, Task& task) {
+    if (self >= 0) {
+        Worker& own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --queued;
+            return true;
+        }
+    }
+    if (queued > 0) {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            if (take_front(injected, batch, task)) {
+                --queued;
+                return true;
+            }
+        }
+        // Steal the oldest job of the next worker that has one, starting
+        // after our own so thieves spread out.
+        const std::size_t count = workers.size();
+        const std::size_t start = self >= 0 ? self + 1 : 0;
+        for (std::size_t k = 0; k < count; ++k) {
+            Worker& victim = *workers[(start + k) % count];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (take_front(victim.tasks, batch, task)) {
+                --queued;
+                return true;
+            }
+        }
+    }
+    if (take_background && background_queued > 0) {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (!background.empty()) {
+            task = std::move(background.front());
+            background.pop_front();
+            --background_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::execute(Task& task) {
+    const JobCounter* outer = current_batch; // a waiting thread may be inside a job already
+    current_batch = task.batch;
+    task.job();
+    current_batch = outer;
+    task.job = nullptr; // release its captures before the counter says done
+    finish(task.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (!counter || counter->pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    std::vector<std::function<void()>> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        continuations.swap(counter->continuations);
+    }
+    for (auto& queue_job : continuations) queue_job();
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const int self = current_system == this ? current_worker : -1;
+    // Workers help with anything. Any other thread, the render thread above
+    // all, only helps with its own batch, so that a parallel_for there never
+    // ends up running a slice of an asset load.
+    const JobCounter* batch = self >= 0 ? nullptr : batch_for(&counter);
+    int idle = 0;
+    while (!counter.done()) {
+        Task task;
+        if (pop(self, false, batch, task)) {
+            execute(task);
+            idle = 0;
+        } else if (++idle < WAIT_SPINS) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(WAIT_SLEEP);
+        }
+    }
+}
+
+void JobSystem::parallel_for(std::size_t count, std::size_t grain,
+                             const std::function<void(std::size_t, std::size_t)>& fn) {
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t ranges = (count + grain - 1) / grain;
+    if (ranges <= 1 || thread_count() == 1) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+    JobCounter counter;
+    // The caller runs the first range itself; the others are there to steal.
+    for (std::size_t r = 1; r < ranges; ++r) {
+        const std::size_t begin = r * grain;
+        run([&fn, begin, end = std::min(count, begin + grain)] { fn(begin, end); }, &counter);
+    }
+    fn(0, std::min(count, grain));
+    wait(counter);
+}
+
+void JobSystem::for_each(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    parallel_for(count, 1, [&fn](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) fn(i);
+    });
+}
+
+void JobSystem::worker_loop(unsigned index) {
+    current_system = this;
+    current_worker = static_cast<int>(index);
+    for (;;) {
+        Task task;
+        if (index < active_workers && pop(static_cast<int>(index), true, nullptr, task)) {
+            execute(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        if (index >= active_workers) {
+            limit_wake.wait(lock, [&] { return stopping || index < active_workers; });
+        } else {
+            ++sleepers;
+            wake.wait(lock, [&] {
+                return stopping || index >= active_workers || queued > 0 || background_queued > 0;
+            });
+            --sleepers;
+        }
+        if (stopping) return;
+    }
+}
@@ -0,0 +1,131 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts the unfinished jobs of a batch. Jobs run with a counter increment it
+// when queued and decrement it when done; wait() on it, or run more jobs
+// after it with run_after(). A counter may be reused once it reaches zero.
+class JobCounter {
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+    std::atomic<int> pending{0};
+    std::mutex mutex; // continuations
+    std::vector<std::function<void()>> continuations;
+};
+
+// The one pool of threads everything parallel runs on: the loaders, mesh
+// processing, the simulation and the asset loads.
+//
+// Every worker keeps a deque of jobs. It takes its newest job first and, when
+// its own deque is empty, steals the oldest job of another worker, so work
+// spawned from a job stays on the thread that spawned it until someone is
+// idle. Threads outside the pool queue their jobs in a shared queue instead.
+// wait() does not block while there is work: the waiting thread runs queued
+// jobs itself, so nested parallel_for calls from inside jobs cannot deadlock
+// and the main thread helps rather than sleeps.
+//
+// Every job belongs to a batch: the counter of the job that was queued from
+// outside any job, which the jobs it queues, and theirs, inherit. A worker
+// waiting runs any job, but a thread outside the pool only runs jobs of the
+// batch it waits on, so the render thread never picks up part of someone
+// else's work.
+//
+// Background jobs (asset loads, which run for seconds) have a queue of their
+// own that only the workers take from, so a thread waiting on a short batch
+// never picks one up.
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+
+    // The shared pool, started on first use with one worker per hardware
+    // thread but one (the caller's), and at least one. Never destroyed: a
+    // job may still be loading an asset when the program exits.
+    static JobSystem& instance();
+    // Sets the shared pool's worker count. Only before its first use.
+    static void set_worker_count(unsigned count);
+
+    explicit JobSystem(unsigned worker_count);
+    ~JobSystem(); // drops the jobs still queued and joins the workers
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads that run jobs in a parallel_for: the workers in use and the
+    // caller.
+    unsigned thread_count() const;
+    unsigned worker_count() const { return static_cast<unsigned>(workers.size()); }
+    // Leaves only the first limit - 1 workers running jobs (0 for all), to
+    // measure how the work scales.
+    void set_thread_limit(unsigned limit);
+
+    void run(Job job, JobCounter* counter = nullptr);
+    // Queues job once dependency has reached zero; counter counts it from now.
+    void run_after(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+    void run_background(Job job, JobCounter* counter = nullptr);
+
+    // Returns once counter reaches zero, running other jobs meanwhile.
+    void wait(JobCounter& counter);
+
+    // Calls fn(begin, end) over [0, count) in ranges of about grain indices,
+    // and returns once all have finished.
+    void parallel_for(std::size_t count, std::size_t grain, const std::function<void(std::size_t, std::size_t)>& fn);
+    // Calls fn(i) for every i in [0, count), one index per job.
+    void for_each(std::size_t count, const std::function<void(std::size_t)>& fn);
+
+private:
+    struct Task {
+        Job job;
+        JobCounter* counter;
+        const JobCounter* batch; // identifies the batch only; may be gone
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks; // the owner works at the back, thieves at the front
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex queue_mutex; // the two shared queues
+    std::deque<Task> injected;
+    std::deque<Task> background;
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake;        // idle workers in use
+    std::condition_variable limit_wake;  // workers beyond the thread limit
+    std::atomic<int> sleepers{0};        // waiting on wake
+    // Tasks in the deques and the injection queue, and in the background
+    // queue. Signed: a pop may briefly run ahead of the push it takes.
+    std::atomic<int> queued{0};
+    std::atomic<int> background_queued{0};
+    std::atomic<unsigned> active_workers;
+    bool stopping = false;
+
+    void push(Task task);
+    // A null batch takes any job.
+    bool pop(int self, bool take_background, const JobCounter* batch, Task& task);
+    static bool take_front(std::deque<Task>& tasks, const JobCounter* batch, Task& task);
+    void execute(Task& task);
+    void finish(JobCounter* counter);
+    void worker_loop(unsigned index);
+    void notify();
+};
+
+#endif // JOB_SYSTEM_H
@@ -1,6 +1,11 @@
 #include "Light.h"
+#include "PrimitiveCache.h"
+#include "IdPicker.h"
+#include "GLState.h"
 #include <cstring>
 
+static const GLfloat GIZMO_RADIUS = 0.2f;
+
 Light::Light(LightType t, int gl_light_num) : type(t), gl_light(gl_light_num), enabled(true), cutoff(45.0f), exponent(0.0f) {
     GLfloat def_amb[] = {0.0f, 0.0f, 0.0f, 1.0f};
     GLfloat def_diff[] = {1.0f, 1.0f, 1.0f, 1.0f};
@@ -12,6 +17,8 @@ Light::Light(LightType t, int gl_light_num) : type(t), gl_light(gl_light_num), e
     
     setPosition(0, 5, 5);
     w_coord = 1.0f;
+    BoundingSphere gizmo{vec3(), GIZMO_RADIUS};
+    setLocalBounds(BoundingBox(gizmo), gizmo);
 
     if (type == AMBIENT) {
         GLfloat amb[] = {0.2f, 0.2f, 0.2f, 1.0f};
@@ -29,40 +36,71 @@ void Light::toggle() {
 
 void Light::apply() {
     if (enabled) {
-        glEnable(gl_light);
-        glLightfv(gl_light, GL_AMBIENT, ambient);
-        glLightfv(gl_light, GL_DIFFUSE, diffuse);
-        glLightfv(gl_light, GL_SPECULAR, specular);
+        GLState::enable(gl_light);
+        GLState::light(gl_light, GL_AMBIENT, ambient);
+        GLState::light(gl_light, GL_DIFFUSE, diffuse);
+        GLState::light(gl_light, GL_SPECULAR, specular);
 
+        // Called with the view on the modelview, which GL applies to these
+        // two; unchanged values under an unchanged view are filtered out.
+        const unsigned view = SceneNode::getViewVersion();
         float x, y, z;
         getPosition(x, y, z);
         GLfloat current_pos[4] = { x, y, z, w_coord };
-        glLightfv(gl_light, GL_POSITION, current_pos);
+        GLState::light(gl_light, GL_POSITION, current_pos, view);
 
         if (type == SPOTLIGHT) {
-            glLightfv(gl_light, GL_SPOT_DIRECTION, direction);
-            glLightf(gl_light, GL_SPOT_CUTOFF, cutoff);
-            glLightf(gl_light, GL_SPOT_EXPONENT, exponent);
+            GLState::light(gl_light, GL_SPOT_DIRECTION, direction, view);
+            GLState::light(gl_light, GL_SPOT_CUTOFF, cutoff);
+            GLState::light(gl_light, GL_SPOT_EXPONENT, exponent);
         } else {
-            glLightf(gl_light, GL_SPOT_CUTOFF, 180.0f);
+            GLState::light(gl_light, GL_SPOT_CUTOFF, 180.0f);
         }
     } else {
-        glDisable(gl_light);
+        GLState::disable(gl_light);
     }
 }
 
 void Light::draw() { // Removed const
     if (enabled && (type == POINT_LIGHT || type == SPOTLIGHT)) {
         glPushMatrix();
-        applyTransformations();
+        GLState::disable(GL_LIGHTING);
+        drawPacket(0);
+        GLState::enable(GL_LIGHTING);
+        glPopMatrix();
+    }
+}
+
+void Light::submit(RenderQueue& queue) {
+    if (!enabled || (type != POINT_LIGHT && type != SPOTLIGHT)) return;
+    DrawState state;
+    state.pass = PASS_UNLIT;
+    queue.add(this, 0, state, viewDepth());
+}
 
-        glDisable(GL_LIGHTING);
-        glColor3f(1.0f, 1.0f, 0.0f); // Yellow sphere
-        glutSolidSphere(0.2, 16, 16);
-        glEnable(GL_LIGHTING);
+void Light::drawPacket(int) {
+    applyTransformations();
+    glColor3f(1.0f, 1.0f, 0.0f); // Yellow sphere
+    PrimitiveCache::instance().drawSphere(GIZMO_RADIUS, 16, 16);
+}
 
-        glPopMatrix();
+bool Light::intersect(const Ray& ray, RayHit& hit) {
+    // Only the gizmo draw() shows can be hit.
+    if (!enabled || (type != POINT_LIGHT && type != SPOTLIGHT)) return false;
+    GLfloat t;
+    if (!RayTests::sphere(ray.transformed(getWorldMatrix().inverse()), vec3(), GIZMO_RADIUS, hit.distance, t)) {
+        return false;
     }
+    hit.distance = t;
+    hit.part = hit.triangle = -1;
+    return true;
+}
+
+void Light::drawIds(GLuint objectBits) {
+    if (!enabled || (type != POINT_LIGHT && type != SPOTLIGHT)) return;
+    loadModelView();
+    IdPicker::setColor(objectBits);
+    PrimitiveCache::instance().drawSphere(GIZMO_RADIUS, 16, 16);
 }
 
 void Light::setAmbient(const GLfloat* amb) { memcpy(ambient, amb, sizeof(ambient)); }
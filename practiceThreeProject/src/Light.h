@@ -19,6 +19,10 @@ public:
     void toggle();
     bool isEnabled() const { return enabled; }
     void draw() override; // Removed const, for visualization
+    void submit(RenderQueue& queue) override; // the gizmo, unlit
+    void drawPacket(int part) override;
+    bool intersect(const Ray& ray, RayHit& hit) override;
+    void drawIds(GLuint objectBits) override;
 
     void setAmbient(const GLfloat* amb);
     void setDiffuse(const GLfloat* diff);
@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. The contents stay valid until
+// the object is closed or destroyed.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool is_open() const { return _data != nullptr || _open_empty; }
+
+private:
+    const char* _data = nullptr;
+    std::size_t _size = 0;
+    bool _open_empty = false;
+
+#ifdef _WIN32
+    void* _file = nullptr;
+    void* _mapping = nullptr;
+#endif
+};
+
+#endif // MAPPED_FILE_H
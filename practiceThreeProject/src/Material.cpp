@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "GLState.h"
 #include <cstring>
 
 Material::Material() {
@@ -19,8 +20,15 @@ Material::Material(const GLfloat* amb, const GLfloat* diff, const GLfloat* spec,
 }
 
 void Material::apply() const {
-    glMaterialfv(GL_FRONT, GL_AMBIENT, ambient);
-    glMaterialfv(GL_FRONT, GL_DIFFUSE, diffuse);
-    glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
+    GLState::material(GL_AMBIENT, ambient);
+    GLState::material(GL_DIFFUSE, diffuse);
+    GLState::material(GL_SPECULAR, specular);
+    GLState::material(GL_SHININESS, shininess);
+}
+
+void Material::setSpecular(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+    specular[0] = r;
+    specular[1] = g;
+    specular[2] = b;
+    specular[3] = a;
 }
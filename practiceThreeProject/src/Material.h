@@ -14,6 +14,14 @@ public:
 
     void apply() const;
 
+    const GLfloat* getAmbient() const { return ambient; }
+    const GLfloat* getDiffuse() const { return diffuse; }
+    const GLfloat* getSpecular() const { return specular; }
+    GLfloat getShininess() const { return shininess; }
+
+    void setSpecular(GLfloat r, GLfloat g, GLfloat b, GLfloat a = 1.0f);
+    void setShininess(GLfloat shin) { shininess = shin; }
+
 private:
     GLfloat ambient[4];
     GLfloat diffuse[4];
@@ -0,0 +1,301 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char CACHE_MAGIC[8] = {'C', 'G', 'V', 'M', 'E', 'S', 'H', '\0'};
+static const std::uint32_t CACHE_VERSION = 3;
+static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct CacheHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t source_size;
+    std::int64_t source_mtime;
+    std::uint64_t source_hash;
+    std::uint64_t vertex_count;
+    std::uint64_t normal_count;
+    std::uint64_t triangle_count;
+};
+
+static const char LOD_MAGIC[8] = {'C', 'G', 'V', 'L', 'O', 'D', '\0', '\0'};
+static const std::uint32_t LOD_VERSION = 1;
+
+struct LodHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t geometry_hash;
+    std::uint64_t level_count;
+    std::uint64_t triangle_count;
+};
+
+struct LodRecord {
+    std::uint64_t first;
+    std::uint64_t count;
+    float error;
+    std::uint32_t padding;
+};
+
+static_assert(sizeof(cgvPoint3D) == 3 * sizeof(float), "cgvPoint3D must be three packed floats");
+static_assert(sizeof(cgvTriangle) == 3 * sizeof(std::uint32_t), "cgvTriangle must be three packed indices");
+
+// Content hash of the source file. Works on 8-byte words in four independent
+// lanes, so it runs at memory speed rather than byte-at-a-time.
+static std::uint64_t hash_bytes(const char* data, std::size_t size) {
+    const std::uint64_t prime = 0x9e3779b97f4a7c15ULL;
+    std::uint64_t lanes[4] = {prime, prime ^ 1, prime ^ 2, prime ^ 3};
+
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int l = 0; l < 4; ++l) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i + l * 8, 8);
+            lanes[l] = (lanes[l] ^ word) * 0xff51afd7ed558ccdULL;
+            lanes[l] ^= lanes[l] >> 29;
+        }
+    }
+    std::uint64_t h = size;
+    for (std::uint64_t lane : lanes) h = (h ^ lane) * prime;
+    for (; i < size; ++i) h = (h ^ static_cast<unsigned char>(data[i])) * 0x100000001b3ULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Sources up to SOURCE_WHOLE bytes are hashed whole, a couple of
+// milliseconds. Larger ones are sampled: SOURCE_SAMPLE bytes at each end and
+// SOURCE_PAGES pages spread evenly between. Reading all of a large OBJ on
+// every warm load would cost a good part of what the sidecar saves, and size
+// and mtime already catch nearly every edit. The sample catches a file
+// swapped for another of the same size and most edits that keep size and
+// mtime, but not one that falls wholly between the sampled pages.
+static const std::size_t SOURCE_WHOLE = 8 * 1024 * 1024;
+static const std::size_t SOURCE_SAMPLE = 64 * 1024;
+static const std::size_t SOURCE_PAGES = 256;
+static const std::size_t SOURCE_PAGE = 4096;
+
+static std::uint64_t hash_source(const char* data, std::size_t size) {
+    if (size <= SOURCE_WHOLE) return hash_bytes(data, size);
+    const std::uint64_t prime = 0x9e3779b97f4a7c15ULL;
+    std::uint64_t h = hash_bytes(data, SOURCE_SAMPLE);
+    h = (h ^ hash_bytes(data + size - SOURCE_SAMPLE, SOURCE_SAMPLE)) * prime;
+    // Page-aligned, so each sample touches a single page of the mapping.
+    const std::size_t middle = size - 2 * SOURCE_SAMPLE - SOURCE_PAGE;
+    for (std::size_t k = 0; k < SOURCE_PAGES; ++k) {
+        const std::size_t offset = SOURCE_SAMPLE + middle / (SOURCE_PAGES - 1) * k / SOURCE_PAGE * SOURCE_PAGE;
+        h = (h ^ hash_bytes(data + offset, SOURCE_PAGE)) * prime;
+    }
+    return h;
+}
+
+// True when count elements of element_size fit in available bytes; checked
+// before any count * size product so that a corrupt count cannot overflow it.
+static bool fits(std::uint64_t count, std::size_t element_size, std::uint64_t available) {
+    return count <= available / element_size;
+}
+
+static bool source_stamp(const std::string& path, std::uint64_t& size, std::int64_t& mtime) {
+    std::error_code ec;
+    auto file_size = fs::file_size(path, ec);
+    if (ec) return false;
+    auto write_time = fs::last_write_time(path, ec);
+    if (ec) return false;
+    size = file_size;
+    mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(write_time.time_since_epoch()).count();
+    return true;
+}
+
+static void copy_block(void* dst, const char* src, std::size_t bytes) {
+    if (bytes) std::memcpy(dst, src, bytes);
+}
+
+// Writes to a private temporary name and renames it into place, so readers
+// running in parallel never see a partially written sidecar.
+template <typename Writer>
+static bool write_atomically(const std::string& final_path, Writer write_contents) {
+    const std::string temp_path = final_path + ".tmp" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        write_contents(out);
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            fs::remove(temp_path, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(temp_path, final_path, ec);
+    if (ec) {
+        fs::remove(temp_path, ec);
+        return false;
+    }
+    return true;
+}
+
+// Identifies the geometry the levels index into: the vertices and the full
+// triangle list as the loader leaves them.
+static std::uint64_t geometry_hash(const cgvTriangleMesh& mesh) {
+    const auto& vertices = mesh.get_vertices();
+    const auto& triangles = mesh.get_triangles();
+    std::uint64_t h = hash_bytes(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(cgvPoint3D));
+    return h ^ (hash_bytes(reinterpret_cast<const char*>(triangles.data()), triangles.size() * sizeof(cgvTriangle)) *
+                0x9e3779b97f4a7c15ULL);
+}
+
+std::string MeshCache::cache_path(const std::string& source_path) {
+    return source_path + ".cgvmesh";
+}
+
+bool MeshCache::read(const std::string& source_path, cgvTriangleMesh& mesh) {
+    std::uint64_t source_size;
+    std::int64_t source_mtime;
+    if (!source_stamp(source_path, source_size, source_mtime)) return false;
+
+    MappedFile cache;
+    if (!cache.open(cache_path(source_path)) || cache.size() < sizeof(CacheHeader)) return false;
+
+    CacheHeader header;
+    std::memcpy(&header, cache.data(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION || header.byte_order != BYTE_ORDER_MARK ||
+        header.source_size != source_size || header.source_mtime != source_mtime) {
+        return false;
+    }
+
+    const std::uint64_t body_size = cache.size() - sizeof(CacheHeader);
+    if (!fits(header.vertex_count, sizeof(cgvPoint3D), body_size) ||
+        !fits(header.normal_count, sizeof(cgvPoint3D), body_size) ||
+        !fits(header.triangle_count, sizeof(cgvTriangle), body_size)) {
+        return false;
+    }
+    if (header.normal_count != 0 && header.normal_count != header.vertex_count) return false;
+    const std::uint64_t vertex_bytes = header.vertex_count * sizeof(cgvPoint3D);
+    const std::uint64_t normal_bytes = header.normal_count * sizeof(cgvPoint3D);
+    const std::uint64_t triangle_bytes = header.triangle_count * sizeof(cgvTriangle);
+    if (body_size != vertex_bytes + normal_bytes + triangle_bytes) return false;
+
+    // Size and mtime match; the sampled hash catches a same-sized file
+    // swapped in, or edited, with its timestamp kept.
+    MappedFile source;
+    if (!source.open(source_path) || source.size() != source_size) return false;
+    if (hash_source(source.data(), source.size()) != header.source_hash) return false;
+
+    const char* p = cache.data() + sizeof(CacheHeader);
+    std::vector<cgvPoint3D> vertices(header.vertex_count);
+    copy_block(vertices.data(), p, vertex_bytes);
+    p += vertex_bytes;
+    std::vector<cgvPoint3D> normals(header.normal_count);
+    copy_block(normals.data(), p, normal_bytes);
+    p += normal_bytes;
+    std::vector<cgvTriangle> triangles(header.triangle_count);
+    copy_block(triangles.data(), p, triangle_bytes);
+
+    const std::uint64_t vertex_count = header.vertex_count;
+    for (const cgvTriangle& t : triangles) {
+        if (t.v[0] >= vertex_count || t.v[1] >= vertex_count || t.v[2] >= vertex_count) return false;
+    }
+    mesh.get_vertices() = std::move(vertices);
+    mesh.get_normals() = std::move(normals);
+    mesh.get_triangles() = std::move(triangles);
+    return true;
+}
+
+bool MeshCache::write(const std::string& source_path, const char* source_data, std::size_t source_size,
+                      const cgvTriangleMesh& mesh) {
+    CacheHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    if (!source_stamp(source_path, header.source_size, header.source_mtime)) return false;
+    if (header.source_size != source_size) return false;
+    header.source_hash = hash_source(source_data, source_size);
+    header.vertex_count = mesh.get_vertices().size();
+    header.normal_count = mesh.get_normals().size();
+    header.triangle_count = mesh.get_triangles().size();
+
+    return write_atomically(cache_path(source_path), [&](std::ofstream& out) {
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(mesh.get_vertices().data()), header.vertex_count * sizeof(cgvPoint3D));
+        out.write(reinterpret_cast<const char*>(mesh.get_normals().data()), header.normal_count * sizeof(cgvPoint3D));
+        out.write(reinterpret_cast<const char*>(mesh.get_triangles().data()), header.triangle_count * sizeof(cgvTriangle));
+    });
+}
+
+std::string MeshCache::lod_path(const std::string& source_path) {
+    return source_path + ".cgvlod";
+}
+
+bool MeshCache::read_lods(const std::string& source_path, cgvTriangleMesh& mesh) {
+    MappedFile cache;
+    if (!cache.open(lod_path(source_path)) || cache.size() < sizeof(LodHeader)) return false;
+
+    LodHeader header;
+    std::memcpy(&header, cache.data(), sizeof(header));
+    if (std::memcmp(header.magic, LOD_MAGIC, sizeof(LOD_MAGIC)) != 0 || header.version != LOD_VERSION ||
+        header.byte_order != BYTE_ORDER_MARK) {
+        return false;
+    }
+    const std::uint64_t body_size = cache.size() - sizeof(LodHeader);
+    if (!fits(header.level_count, sizeof(LodRecord), body_size) ||
+        !fits(header.triangle_count, sizeof(cgvTriangle), body_size)) {
+        return false;
+    }
+    const std::uint64_t record_bytes = header.level_count * sizeof(LodRecord);
+    const std::uint64_t triangle_bytes = header.triangle_count * sizeof(cgvTriangle);
+    if (body_size != record_bytes + triangle_bytes) return false;
+    if (header.geometry_hash != geometry_hash(mesh)) return false;
+
+    const char* p = cache.data() + sizeof(LodHeader);
+    std::vector<LodLevel> levels(header.level_count);
+    for (LodLevel& level : levels) {
+        LodRecord record;
+        std::memcpy(&record, p, sizeof(record));
+        p += sizeof(record);
+        if (record.first > header.triangle_count * 3 || record.count > header.triangle_count * 3 - record.first) {
+            return false;
+        }
+        level = {static_cast<std::size_t>(record.first), static_cast<std::size_t>(record.count), record.error};
+    }
+    std::vector<cgvTriangle> triangles(header.triangle_count);
+    copy_block(triangles.data(), p, triangle_bytes);
+
+    const std::size_t vertex_count = static_cast<const cgvTriangleMesh&>(mesh).get_vertices().size();
+    for (const cgvTriangle& t : triangles) {
+        if (t.v[0] >= vertex_count || t.v[1] >= vertex_count || t.v[2] >= vertex_count) return false;
+    }
+    mesh.set_lods(std::move(triangles), std::move(levels));
+    return true;
+}
+
+bool MeshCache::write_lods(const std::string& source_path, const cgvTriangleMesh& mesh) {
+    LodHeader header;
+    std::memcpy(header.magic, LOD_MAGIC, sizeof(LOD_MAGIC));
+    header.version = LOD_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.geometry_hash = geometry_hash(mesh);
+    header.level_count = mesh.get_lod_levels().size();
+    header.triangle_count = mesh.get_lod_triangles().size();
+
+    return write_atomically(lod_path(source_path), [&](std::ofstream& out) {
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const LodLevel& level : mesh.get_lod_levels()) {
+            LodRecord record = {level.first, level.count, level.error, 0};
+            out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        out.write(reinterpret_cast<const char*>(mesh.get_lod_triangles().data()),
+                  header.triangle_count * sizeof(cgvTriangle));
+    });
+}
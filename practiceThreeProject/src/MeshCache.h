@@ -0,0 +1,40 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <string>
+#include "cgvTriangleMesh.h"
+
+// Binary sidecar (<source>.cgvmesh) holding the vertices, normals and
+// triangles produced from an OBJ file, so later runs can skip the text parse.
+// The sidecar records the size, modification time and a hash of its source
+// and is ignored as soon as any of them changes. Sources over 8 MiB are
+// hashed by sample (both ends and pages spread between), so there an edit
+// that keeps size and mtime and misses every sampled page goes unnoticed.
+// Its counts and indices are checked before the mesh is touched.
+//
+// A second sidecar (<source>.cgvlod) holds the simplified levels of detail.
+// They index into the mesh as the loader leaves it, so that sidecar is keyed
+// on a hash of the vertices and triangles instead of on the source file.
+class MeshCache {
+public:
+    static std::string cache_path(const std::string& source_path);
+
+    // Fills mesh from the sidecar of source_path. Returns false, leaving mesh
+    // untouched, when the sidecar is missing, stale or malformed.
+    static bool read(const std::string& source_path, cgvTriangleMesh& mesh);
+
+    // Writes the sidecar for source_path, whose contents are given in
+    // [source_data, source_data + source_size).
+    static bool write(const std::string& source_path, const char* source_data, std::size_t source_size,
+                      const cgvTriangleMesh& mesh);
+
+    static std::string lod_path(const std::string& source_path);
+
+    // Gives mesh the levels stored for it, if they were built from exactly
+    // its current geometry.
+    static bool read_lods(const std::string& source_path, cgvTriangleMesh& mesh);
+    static bool write_lods(const std::string& source_path, const cgvTriangleMesh& mesh);
+};
+
+#endif // MESH_CACHE_H
@@ -0,0 +1,300 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Simulated cache size used while ordering. Forsyth's scoring is tuned for 32
+// entries and degrades gracefully on smaller hardware caches.
+static const int FORSYTH_CACHE_SIZE = 32;
+
+static const unsigned FORSYTH_VALENCE_TABLE_SIZE = 32;
+
+struct ForsythTables {
+    float cache[FORSYTH_CACHE_SIZE];
+    float valence[FORSYTH_VALENCE_TABLE_SIZE];
+
+    ForsythTables() {
+        for (int i = 0; i < FORSYTH_CACHE_SIZE; ++i) {
+            // Vertices of the triangle just drawn get a fixed score so the
+            // next triangle does not simply reuse the same edge forever.
+            cache[i] = i < 3 ? 0.75f : std::pow(1.0f - (i - 3) / float(FORSYTH_CACHE_SIZE - 3), 1.5f);
+        }
+        valence[0] = 0.0f;
+        for (unsigned i = 1; i < FORSYTH_VALENCE_TABLE_SIZE; ++i) {
+            valence[i] = 2.0f / std::sqrt(static_cast<float>(i));
+        }
+    }
+};
+
+static float forsyth_vertex_score(const ForsythTables& tables, int cache_position, unsigned remaining_triangles) {
+    if (remaining_triangles == 0) return -1.0f; // nothing left to draw with it
+
+    float score = cache_position >= 0 ? tables.cache[cache_position] : 0.0f;
+    // Boost vertices with few triangles left, so they get finished off.
+    score += remaining_triangles < FORSYTH_VALENCE_TABLE_SIZE
+                 ? tables.valence[remaining_triangles]
+                 : 2.0f / std::sqrt(static_cast<float>(remaining_triangles));
+    return score;
+}
+
+// Simulates a FIFO cache over the index stream; calls on_miss(triangle) for
+// every miss and returns the total number of misses.
+template <typename MissFn>
+static std::size_t simulate_fifo(const std::vector<cgvTriangle>& triangles, std::size_t vertex_count,
+                                 unsigned cache_size, MissFn on_miss) {
+    // timestamps[v] is the miss counter value when v entered the cache.
+    std::vector<std::size_t> timestamps(vertex_count, 0);
+    std::size_t misses = 0;
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        for (unsigned v : triangles[t].v) {
+            if (timestamps[v] == 0 || misses - timestamps[v] + 1 > cache_size) {
+                ++misses;
+                timestamps[v] = misses;
+                on_miss(t);
+            }
+        }
+    }
+    return misses;
+}
+
+VertexCacheStats MeshOptimizer::analyze(const std::vector<cgvTriangle>& triangles, std::size_t vertex_count,
+                                        unsigned cache_size) {
+    VertexCacheStats stats = {0.0f, 0.0f};
+    if (triangles.empty()) return stats;
+
+    std::vector<char> referenced(vertex_count, 0);
+    std::size_t referenced_count = 0;
+    for (const auto& tri : triangles) {
+        for (unsigned v : tri.v) {
+            if (!referenced[v]) {
+                referenced[v] = 1;
+                ++referenced_count;
+            }
+        }
+    }
+
+    std::size_t misses = simulate_fifo(triangles, vertex_count, cache_size, [](std::size_t) {});
+    stats.acmr = static_cast<float>(misses) / triangles.size();
+    stats.atvr = static_cast<float>(misses) / referenced_count;
+    return stats;
+}
+
+void MeshOptimizer::optimize_vertex_cache(std::vector<cgvTriangle>& triangles, std::size_t vertex_count) {
+    const std::size_t triangle_count = triangles.size();
+    if (triangle_count == 0) return;
+
+    // Vertex -> triangle adjacency in compressed rows. The live part of each
+    // row shrinks as triangles are emitted.
+    std::vector<unsigned> live(vertex_count, 0);
+    for (const auto& tri : triangles) {
+        for (unsigned v : tri.v) ++live[v];
+    }
+    std::vector<std::size_t> offsets(vertex_count + 1, 0);
+    for (std::size_t v = 0; v < vertex_count; ++v) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<unsigned> adjacency(offsets.back());
+    {
+        std::vector<std::size_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (std::size_t t = 0; t < triangle_count; ++t) {
+            for (unsigned v : triangles[t].v) adjacency[cursor[v]++] = static_cast<unsigned>(t);
+        }
+    }
+
+    static const ForsythTables tables;
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (std::size_t v = 0; v < vertex_count; ++v) vertex_score[v] = forsyth_vertex_score(tables, -1, live[v]);
+
+    std::vector<float> triangle_score(triangle_count);
+    for (std::size_t t = 0; t < triangle_count; ++t) {
+        const auto& tri = triangles[t];
+        triangle_score[t] = vertex_score[tri.v[0]] + vertex_score[tri.v[1]] + vertex_score[tri.v[2]];
+    }
+
+    std::vector<char> emitted(triangle_count, 0);
+    std::vector<cgvTriangle> ordered;
+    ordered.reserve(triangle_count);
+
+    unsigned cache[FORSYTH_CACHE_SIZE + 3];
+    int cache_count = 0;
+    std::size_t scan = 0;
+    long best = -1;
+
+    while (ordered.size() < triangle_count) {
+        if (best < 0) {
+            // Nothing useful in the cache: restart from the next untouched triangle.
+            while (emitted[scan]) ++scan;
+            best = static_cast<long>(scan);
+        }
+
+        const cgvTriangle tri = triangles[best];
+        emitted[best] = 1;
+        ordered.push_back(tri);
+
+        // New cache contents: the triangle's vertices, then the old entries.
+        unsigned next_cache[FORSYTH_CACHE_SIZE + 3];
+        int next_count = 0;
+        for (unsigned v : tri.v) {
+            if (std::find(next_cache, next_cache + next_count, v) == next_cache + next_count) {
+                next_cache[next_count++] = v;
+            }
+        }
+        for (int i = 0; i < cache_count; ++i) {
+            if (std::find(next_cache, next_cache + next_count, cache[i]) == next_cache + next_count) {
+                next_cache[next_count++] = cache[i];
+            }
+        }
+
+        // Drop the emitted triangle from its vertices' live adjacency.
+        for (unsigned v : tri.v) {
+            unsigned* row = &adjacency[offsets[v]];
+            unsigned* row_end = row + live[v];
+            unsigned* it = std::find(row, row_end, static_cast<unsigned>(best));
+            if (it != row_end) {
+                *it = *(row_end - 1);
+                --live[v];
+            }
+        }
+
+        // Rescore every vertex whose cache slot changed and push the delta
+        // into its remaining triangles.
+        for (int i = 0; i < next_count; ++i) {
+            unsigned v = next_cache[i];
+            cache_position[v] = i < FORSYTH_CACHE_SIZE ? i : -1;
+            float score = forsyth_vertex_score(tables, cache_position[v], live[v]);
+            float delta = score - vertex_score[v];
+            vertex_score[v] = score;
+            for (std::size_t k = offsets[v]; k < offsets[v] + live[v]; ++k) {
+                triangle_score[adjacency[k]] += delta;
+            }
+        }
+
+        cache_count = std::min(next_count, FORSYTH_CACHE_SIZE);
+        for (int i = 0; i < cache_count; ++i) cache[i] = next_cache[i];
+
+        // The best candidate is almost always adjacent to a cached vertex.
+        best = -1;
+        float best_score = -1.0f;
+        for (int i = 0; i < cache_count; ++i) {
+            unsigned v = cache[i];
+            for (std::size_t k = offsets[v]; k < offsets[v] + live[v]; ++k) {
+                unsigned t = adjacency[k];
+                if (triangle_score[t] > best_score) {
+                    best_score = triangle_score[t];
+                    best = t;
+                }
+            }
+        }
+    }
+
+    triangles.swap(ordered);
+}
+
+void MeshOptimizer::optimize_overdraw(std::vector<cgvTriangle>& triangles, const std::vector<cgvPoint3D>& vertices) {
+    if (triangles.empty()) return;
+
+    // Split the cache-ordered list into clusters at hard boundaries: the
+    // triangles where the cache had to be refilled completely. Reordering
+    // whole clusters keeps the cache efficiency of the previous step.
+    std::vector<unsigned> misses_at(triangles.size(), 0);
+    simulate_fifo(triangles, vertices.size(), STATS_CACHE_SIZE, [&](std::size_t t) { ++misses_at[t]; });
+
+    std::vector<std::size_t> cluster_start;
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        if (t == 0 || misses_at[t] == 3) cluster_start.push_back(t);
+    }
+    cluster_start.push_back(triangles.size());
+    const std::size_t cluster_count = cluster_start.size() - 1;
+    if (cluster_count < 2) return;
+
+    // Area-weighted centroid and normal of every cluster and of the mesh.
+    std::vector<cgvPoint3D> centroid(cluster_count), normal(cluster_count);
+    cgvPoint3D mesh_centroid(0, 0, 0);
+    float mesh_area = 0.0f;
+    std::vector<float> cluster_area(cluster_count, 0.0f);
+    for (std::size_t c = 0; c < cluster_count; ++c) {
+        cgvPoint3D sum(0, 0, 0), n_sum(0, 0, 0);
+        for (std::size_t t = cluster_start[c]; t < cluster_start[c + 1]; ++t) {
+            const cgvPoint3D& a = vertices[triangles[t].v[0]];
+            const cgvPoint3D& b = vertices[triangles[t].v[1]];
+            const cgvPoint3D& d = vertices[triangles[t].v[2]];
+            cgvPoint3D n = (b - a).cross(d - a);
+            float area = n.length() * 0.5f;
+            cgvPoint3D center((a[X] + b[X] + d[X]) / 3, (a[Y] + b[Y] + d[Y]) / 3, (a[Z] + b[Z] + d[Z]) / 3);
+            sum += cgvPoint3D(center[X] * area, center[Y] * area, center[Z] * area);
+            n_sum += n;
+            cluster_area[c] += area;
+        }
+        if (cluster_area[c] > 0.0f) {
+            centroid[c] = cgvPoint3D(sum[X] / cluster_area[c], sum[Y] / cluster_area[c], sum[Z] / cluster_area[c]);
+        }
+        n_sum.normalize();
+        normal[c] = n_sum;
+        mesh_centroid += sum;
+        mesh_area += cluster_area[c];
+    }
+    if (mesh_area > 0.0f) {
+        mesh_centroid = cgvPoint3D(mesh_centroid[X] / mesh_area, mesh_centroid[Y] / mesh_area, mesh_centroid[Z] / mesh_area);
+    }
+
+    // Clusters that face away from the centre sit on the silhouette and
+    // occlude the rest, so they go first.
+    std::vector<float> outwardness(cluster_count);
+    for (std::size_t c = 0; c < cluster_count; ++c) {
+        cgvPoint3D offset = centroid[c] - mesh_centroid;
+        outwardness[c] = offset[X] * normal[c][X] + offset[Y] * normal[c][Y] + offset[Z] * normal[c][Z];
+    }
+    std::vector<std::size_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return outwardness[a] > outwardness[b]; });
+
+    std::vector<cgvTriangle> sorted;
+    sorted.reserve(triangles.size());
+    for (std::size_t c : order) {
+        sorted.insert(sorted.end(), triangles.begin() + cluster_start[c], triangles.begin() + cluster_start[c + 1]);
+    }
+    triangles.swap(sorted);
+}
+
+void MeshOptimizer::optimize_vertex_fetch(cgvTriangleMesh& mesh) {
+    auto& vertices = mesh.get_vertices();
+    auto& normals = mesh.get_normals();
+    auto& triangles = mesh.get_triangles();
+    const bool remap_normals = normals.size() == vertices.size();
+
+    const unsigned unassigned = ~0u;
+    std::vector<unsigned> remap(vertices.size(), unassigned);
+    unsigned next = 0;
+    for (auto& tri : triangles) {
+        for (unsigned& v : tri.v) {
+            if (remap[v] == unassigned) remap[v] = next++;
+            v = remap[v];
+        }
+    }
+    // Unreferenced vertices keep their relative order at the end.
+    for (auto& index : remap) {
+        if (index == unassigned) index = next++;
+    }
+
+    std::vector<cgvPoint3D> reordered(vertices.size());
+    for (std::size_t v = 0; v < vertices.size(); ++v) reordered[remap[v]] = vertices[v];
+    vertices.swap(reordered);
+
+    if (remap_normals) {
+        for (std::size_t v = 0; v < normals.size(); ++v) reordered[remap[v]] = normals[v];
+        normals.swap(reordered);
+    }
+}
+
+void MeshOptimizer::optimize(cgvTriangleMesh& mesh, MeshOptimizationReport* report) {
+    auto& triangles = mesh.get_triangles();
+    const std::size_t vertex_count = mesh.get_vertices().size();
+
+    if (report) report->before = analyze(triangles, vertex_count);
+
+    optimize_vertex_cache(triangles, vertex_count);
+    optimize_overdraw(triangles, mesh.get_vertices());
+    optimize_vertex_fetch(mesh);
+
+    if (report) report->after = analyze(triangles, vertex_count);
+}
@@ -0,0 +1,340 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "cgvMath.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+// Weight of the planes through border edges, relative to the surface's.
+static const double BORDER_WEIGHT = 10.0;
+// A collapse may turn a triangle's normal by at most 60 degrees.
+static const double MIN_NORMAL_COSINE = 0.5;
+
+static const unsigned NONE = ~0u;
+
+// Sum of weighted squared distances to a set of planes: the symmetric 4x4
+// matrix of their outer products (its 10 distinct terms) and the total
+// weight, so that error() is a mean squared distance.
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+    double weight = 0;
+
+    // Plane ax + by + cz + d = 0 with (a, b, c) of unit length.
+    static Quadric plane(double a, double b, double c, double d, double w) {
+        Quadric q;
+        q.a2 = w * a * a; q.ab = w * a * b; q.ac = w * a * c; q.ad = w * a * d;
+        q.b2 = w * b * b; q.bc = w * b * c; q.bd = w * b * d;
+        q.c2 = w * c * c; q.cd = w * c * d;
+        q.d2 = w * d * d;
+        q.weight = w;
+        return q;
+    }
+
+    Quadric& operator+=(const Quadric& q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+        return *this;
+    }
+
+    double error(const vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                 + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                 + c2 * z * z + 2 * cd * z
+                 + d2;
+        return weight > 0 ? std::fabs(e) / weight : 0.0; // fabs: rounding can dip below 0
+    }
+};
+
+static Quadric sum(Quadric a, const Quadric& b) {
+    a += b;
+    return a;
+}
+
+enum VertexKind : unsigned char { MANIFOLD, BORDER, LOCKED };
+
+// Simplification state kept across levels, so each level continues from
+// the previous one with the quadrics it has accumulated.
+class Simplifier {
+public:
+    Simplifier(const std::vector<cgvPoint3D>& vertices, const std::vector<cgvTriangle>& triangles);
+
+    // Returns the largest error of any collapse so far.
+    float reduce(std::size_t target_count);
+    const std::vector<cgvTriangle>& get_triangles() const { return triangles; }
+
+private:
+    struct Collapse {
+        unsigned from, to;
+        double cost;
+    };
+
+    const std::vector<cgvPoint3D>& vertices;
+    std::vector<cgvTriangle> triangles;
+
+    // Vertices at the same position share one representative; kinds,
+    // borders and quadrics are kept for representatives only.
+    std::vector<unsigned> weld;
+    std::vector<VertexKind> kind;
+    std::vector<unsigned> border_next, border_prev;
+    std::vector<Quadric> quadrics;
+    double max_error = 0.0; // squared
+
+    // Vertex -> triangle adjacency of the current triangles.
+    std::vector<unsigned> adjacency_offsets, adjacency;
+
+    void weld_positions();
+    void classify_vertices();
+    void build_adjacency();
+    bool can_collapse(unsigned from, unsigned to) const;
+    bool flips(unsigned from, unsigned to) const;
+};
+
+Simplifier::Simplifier(const std::vector<cgvPoint3D>& vertices, const std::vector<cgvTriangle>& triangles)
+    : vertices(vertices), triangles(triangles) {
+    weld_positions();
+    classify_vertices();
+}
+
+void Simplifier::weld_positions() {
+    const std::size_t n = vertices.size();
+    std::vector<unsigned> order(n);
+    std::iota(order.begin(), order.end(), 0u);
+    auto same = [&](unsigned a, unsigned b) {
+        const cgvPoint3D& p = vertices[a];
+        const cgvPoint3D& q = vertices[b];
+        return p[X] == q[X] && p[Y] == q[Y] && p[Z] == q[Z];
+    };
+    auto less = [&](unsigned a, unsigned b) {
+        const cgvPoint3D& p = vertices[a];
+        const cgvPoint3D& q = vertices[b];
+        if (p[X] != q[X]) return p[X] < q[X];
+        if (p[Y] != q[Y]) return p[Y] < q[Y];
+        if (p[Z] != q[Z]) return p[Z] < q[Z];
+        return a < b;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    weld.resize(n);
+    kind.assign(n, MANIFOLD);
+    for (std::size_t i = 0; i < n;) {
+        std::size_t j = i + 1;
+        while (j < n && same(order[j], order[i])) ++j;
+        // The lowest index represents the group; groups of more than one
+        // are seams and stay put.
+        for (std::size_t k = i; k < j; ++k) weld[order[k]] = order[i];
+        if (j - i > 1) kind[order[i]] = LOCKED;
+        i = j;
+    }
+}
+
+void Simplifier::classify_vertices() {
+    const std::size_t n = vertices.size();
+    border_next.assign(n, NONE);
+    border_prev.assign(n, NONE);
+    quadrics.assign(n, Quadric());
+
+    // Every edge of every triangle, keyed by its welded ends in either order.
+    struct Edge {
+        std::uint64_t key;
+        unsigned from, to, triangle;
+    };
+    std::vector<Edge> edges;
+    edges.reserve(triangles.size() * 3);
+    std::vector<vec3> normals(triangles.size());
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        unsigned w[3] = {weld[triangles[t].v[0]], weld[triangles[t].v[1]], weld[triangles[t].v[2]]};
+        vec3 p0 = vertices[w[0]], p1 = vertices[w[1]], p2 = vertices[w[2]];
+        vec3 n = cross(p1 - p0, p2 - p0);
+        GLfloat doubleArea = length(n);
+        if (doubleArea > 0.0f) {
+            n = n / doubleArea;
+            Quadric q = Quadric::plane(n.x, n.y, n.z, -dot(n, p0), doubleArea * 0.5);
+            for (unsigned v : w) quadrics[v] += q;
+        }
+        normals[t] = n;
+        for (int c = 0; c < 3; ++c) {
+            unsigned a = w[c], b = w[(c + 1) % 3];
+            std::uint64_t key = (std::uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+            edges.push_back({key, a, b, static_cast<unsigned>(t)});
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) { return a.key < b.key; });
+
+    for (std::size_t i = 0; i < edges.size();) {
+        std::size_t j = i + 1;
+        while (j < edges.size() && edges[j].key == edges[i].key) ++j;
+        const Edge& e = edges[i];
+        if (j - i == 1) {
+            // A border edge: record its direction, and pull the border's
+            // quadrics towards the plane through it across the surface.
+            if (border_next[e.from] != NONE || border_prev[e.to] != NONE) {
+                kind[e.from] = kind[e.to] = LOCKED; // two borders meet here
+            }
+            border_next[e.from] = e.to;
+            border_prev[e.to] = e.from;
+
+            vec3 a = vertices[e.from], b = vertices[e.to];
+            vec3 edge = b - a;
+            vec3 m = normalize(cross(edge, normals[e.triangle]));
+            Quadric q = Quadric::plane(m.x, m.y, m.z, -dot(m, a), dot(edge, edge) * BORDER_WEIGHT);
+            quadrics[e.from] += q;
+            quadrics[e.to] += q;
+        } else if (j - i > 2 || edges[i].from == edges[i + 1].from) {
+            // Non-manifold or inconsistently wound.
+            kind[e.from] = kind[e.to] = LOCKED;
+        }
+        i = j;
+    }
+
+    for (std::size_t v = 0; v < n; ++v) {
+        if (weld[v] != v || kind[v] == LOCKED) continue;
+        bool next = border_next[v] != NONE, prev = border_prev[v] != NONE;
+        if (next && prev) kind[v] = BORDER;
+        else if (next || prev) kind[v] = LOCKED; // a border that does not go through
+    }
+}
+
+void Simplifier::build_adjacency() {
+    adjacency_offsets.assign(vertices.size() + 1, 0);
+    for (const cgvTriangle& t : triangles) {
+        for (unsigned v : t.v) ++adjacency_offsets[v + 1];
+    }
+    for (std::size_t v = 0; v < vertices.size(); ++v) adjacency_offsets[v + 1] += adjacency_offsets[v];
+    adjacency.resize(triangles.size() * 3);
+    std::vector<unsigned> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (std::size_t t = 0; t < triangles.size(); ++t) {
+        for (unsigned v : triangles[t].v) adjacency[fill[v]++] = static_cast<unsigned>(t);
+    }
+}
+
+bool Simplifier::can_collapse(unsigned from, unsigned to) const {
+    unsigned w = weld[from];
+    switch (kind[w]) {
+        case LOCKED: return false;
+        case BORDER: return weld[to] == border_next[w] || weld[to] == border_prev[w];
+        default: return true;
+    }
+}
+
+bool Simplifier::flips(unsigned from, unsigned to) const {
+    vec3 target = vertices[to];
+    for (unsigned k = adjacency_offsets[from]; k < adjacency_offsets[from + 1]; ++k) {
+        const cgvTriangle& t = triangles[adjacency[k]];
+        if (t.v[0] == to || t.v[1] == to || t.v[2] == to) continue; // goes away
+
+        vec3 p[3], moved[3];
+        for (int c = 0; c < 3; ++c) {
+            p[c] = vertices[t.v[c]];
+            moved[c] = t.v[c] == from ? target : p[c];
+        }
+        vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+        vec3 after = cross(moved[1] - moved[0], moved[2] - moved[0]);
+        GLfloat beforeLength = length(before), afterLength = length(after);
+        if (beforeLength == 0.0f) continue; // already degenerate, nothing to flip
+        // Collapsing along a straight border would leave a sliver with no area.
+        if (afterLength <= beforeLength * 1e-4f) return true;
+        if (dot(before, after) < MIN_NORMAL_COSINE * beforeLength * afterLength) return true;
+    }
+    return false;
+}
+
+float Simplifier::reduce(std::size_t target_count) {
+    std::vector<Collapse> collapses;
+    std::vector<unsigned> remap(vertices.size());
+    std::vector<unsigned char> touched(vertices.size());
+
+    // Passes of independent collapses, cheapest first, until the count is
+    // reached or no collapse is left.
+    while (triangles.size() > target_count) {
+        build_adjacency();
+
+        collapses.clear();
+        for (const cgvTriangle& t : triangles) {
+            for (int c = 0; c < 3; ++c) {
+                unsigned a = t.v[c], b = t.v[(c + 1) % 3];
+                if (can_collapse(a, b)) {
+                    collapses.push_back({a, b, sum(quadrics[weld[a]], quadrics[weld[b]]).error(vertices[b])});
+                }
+                if (can_collapse(b, a)) {
+                    collapses.push_back({b, a, sum(quadrics[weld[b]], quadrics[weld[a]]).error(vertices[a])});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // A collapse removes the two triangles on its edge, or one on a
+        // border. Vertices whose triangles a collapse reshapes wait for the
+        // next pass, so every collapse here is checked against the mesh
+        // it is applied to.
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), 0);
+        const std::size_t excess = triangles.size() - target_count;
+        std::size_t removed = 0, applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (removed >= excess) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+            if (flips(collapse.from, collapse.to)) continue;
+
+            remap[collapse.from] = collapse.to;
+            for (unsigned k = adjacency_offsets[collapse.from]; k < adjacency_offsets[collapse.from + 1]; ++k) {
+                for (unsigned v : triangles[adjacency[k]].v) touched[v] = 1;
+            }
+            removed += kind[weld[collapse.from]] == BORDER ? 1 : 2;
+            quadrics[weld[collapse.to]] += quadrics[weld[collapse.from]];
+            max_error = std::max(max_error, collapse.cost);
+            ++applied;
+        }
+        if (applied == 0) break;
+
+        std::size_t kept = 0;
+        for (const cgvTriangle& t : triangles) {
+            cgvTriangle moved(remap[t.v[0]], remap[t.v[1]], remap[t.v[2]]);
+            if (moved.v[0] == moved.v[1] || moved.v[1] == moved.v[2] || moved.v[2] == moved.v[0]) continue;
+            triangles[kept++] = moved;
+        }
+        triangles.resize(kept);
+    }
+    return static_cast<float>(std::sqrt(max_error));
+}
+
+const std::vector<float>& MeshSimplifier::default_ratios() {
+    static const std::vector<float> ratios = {0.5f, 0.25f, 0.1f};
+    return ratios;
+}
+
+float MeshSimplifier::simplify(const std::vector<cgvPoint3D>& vertices, std::vector<cgvTriangle>& triangles,
+                               std::size_t target_count) {
+    Simplifier simplifier(vertices, triangles);
+    float error = simplifier.reduce(target_count);
+    triangles = simplifier.get_triangles();
+    return error;
+}
+
+void MeshSimplifier::build_lods(cgvTriangleMesh& mesh, const std::vector<float>& ratios) {
+    const cgvTriangleMesh& source = mesh; // the const getters keep the levels
+    const std::vector<cgvPoint3D>& vertices = source.get_vertices();
+    const std::vector<cgvTriangle>& triangles = source.get_triangles();
+
+    Simplifier simplifier(vertices, triangles);
+    std::vector<cgvTriangle> lod_triangles;
+    std::vector<LodLevel> levels;
+    std::size_t previous = triangles.size();
+    for (float ratio : ratios) {
+        std::size_t target = static_cast<std::size_t>(triangles.size() * ratio);
+        float error = simplifier.reduce(target);
+        std::vector<cgvTriangle> level = simplifier.get_triangles();
+        if (level.empty() || level.size() >= previous) break; // nothing more to take away
+        previous = level.size();
+
+        MeshOptimizer::optimize_vertex_cache(level, vertices.size());
+        levels.push_back({lod_triangles.size() * 3, level.size() * 3, error});
+        lod_triangles.insert(lod_triangles.end(), level.begin(), level.end());
+    }
+    mesh.set_lods(std::move(lod_triangles), std::move(levels));
+}
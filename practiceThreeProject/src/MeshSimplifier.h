@@ -0,0 +1,34 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+#include "cgvTriangleMesh.h"
+
+// Quadric error simplification (Garland and Heckbert) by collapsing
+// vertices onto one of their neighbours. No vertex is ever moved or
+// created, so every level draws from the mesh's own vertex array and only
+// needs an index list of its own.
+//
+// What the collapses may not change:
+//  - open borders only shrink along themselves, and their quadrics carry
+//    planes through each border edge, so outlines keep their shape;
+//  - vertices shared between attribute seams (same position, different
+//    normals) and around non-manifold edges stay where they are;
+//  - no triangle may flip.
+class MeshSimplifier {
+public:
+    // Fractions of the full triangle count kept by the levels after it.
+    static const std::vector<float>& default_ratios();
+
+    // Collapses until at most target_count triangles are left, or nothing
+    // more can go. Returns the error reached, in object units.
+    static float simplify(const std::vector<cgvPoint3D>& vertices, std::vector<cgvTriangle>& triangles,
+                          std::size_t target_count);
+
+    // Builds one level per ratio, each from the one before, reorders each
+    // level for the vertex cache and hands them to the mesh.
+    static void build_lods(cgvTriangleMesh& mesh, const std::vector<float>& ratios = default_ratios());
+};
+
+#endif // MESH_SIMPLIFIER_H
@@ -1,4 +1,6 @@
 #include "Object3D.h"
+#include "IdPicker.h"
+#include "cgvMath.h"
 
 Object3D::Object3D() {
     translateX = translateY = translateZ = 0.0f;
@@ -6,6 +8,7 @@ Object3D::Object3D() {
     scaleX = scaleY = scaleZ = 1.0f;
     isSelected = false;
     rstMode = true;
+    bounded = false;
     transformationHistory.clear();
 }
 
@@ -17,9 +20,10 @@ void Object3D::translate(float dx, float dy, float dz) {
     translateX += dx;
     translateY += dy;
     translateZ += dz;
+    markLocalDirty();
 
     if (!rstMode) {
-        transformationHistory.emplace_back(TRANSLATE_OP, dx, dy, dz);
+        pushStep(TRANSLATE_OP, dx, dy, dz);
     }
 
     std::cout << "Translation: (" << translateX << ", " << translateY << ", " << translateZ << ")" << std::endl;
@@ -29,9 +33,10 @@ void Object3D::rotate(float rx, float ry, float rz) {
     rotateX += rx;
     rotateY += ry;
     rotateZ += rz;
+    markLocalDirty();
 
     if (!rstMode) {
-        transformationHistory.emplace_back(ROTATE_OP, rx, ry, rz);
+        pushStep(ROTATE_OP, rx, ry, rz);
     }
 
     std::cout << "Rotation: (" << rotateX << ", " << rotateY << ", " << rotateZ << ")" << std::endl;
@@ -41,9 +46,10 @@ void Object3D::scale(float sx, float sy, float sz) {
     scaleX *= sx;
     scaleY *= sy;
     scaleZ *= sz;
+    markLocalDirty();
 
     if (!rstMode) {
-        transformationHistory.emplace_back(SCALE_OP, sx, sy, sz);
+        pushStep(SCALE_OP, sx, sy, sz);
     }
 
     std::cout << "Scale: (" << scaleX << ", " << scaleY << ", " << scaleZ << ")" << std::endl;
@@ -53,36 +59,131 @@ void Object3D::resetTransformations() {
     translateX = translateY = translateZ = 0.0f;
     rotateX = rotateY = rotateZ = 0.0f;
     scaleX = scaleY = scaleZ = 1.0f;
+    markLocalDirty();
+}
+
+void Object3D::setLocalBounds(const BoundingBox& box) {
+    setLocalBounds(box, {box.center(), length(box.halfExtent())});
+}
+
+void Object3D::setLocalBounds(const BoundingBox& box, const BoundingSphere& sphere) {
+    localBounds = box;
+    localSphere = sphere;
+    bounded = !box.isEmpty();
+}
+
+BoundingBox Object3D::getWorldBounds() {
+    return localBounds.transformed(getWorldMatrix());
+}
+
+bool Object3D::intersect(const Ray& ray, RayHit& hit) {
+    if (!bounded) return false;
+    GLfloat t;
+    if (!RayTests::box(ray.transformed(getWorldMatrix().inverse()), localBounds, hit.distance, t)) return false;
+    hit.distance = t;
+    hit.part = hit.triangle = -1;
+    return true;
+}
+
+void Object3D::drawIds(GLuint objectBits) {
+    if (!bounded) return;
+    const vec3& a = localBounds.min;
+    const vec3& b = localBounds.max;
+    const GLfloat corners[8][3] = {
+        {a.x, a.y, a.z}, {b.x, a.y, a.z}, {b.x, b.y, a.z}, {a.x, b.y, a.z},
+        {a.x, a.y, b.z}, {b.x, a.y, b.z}, {b.x, b.y, b.z}, {a.x, b.y, b.z}
+    };
+    static const int faces[6][4] = {
+        {0, 3, 2, 1}, {4, 5, 6, 7}, {0, 1, 5, 4}, {3, 7, 6, 2}, {0, 4, 7, 3}, {1, 2, 6, 5}
+    };
+
+    loadModelView();
+    IdPicker::setColor(objectBits);
+    glBegin(GL_QUADS);
+    for (const auto& face : faces) {
+        for (int corner : face) glVertex3fv(corners[corner]);
+    }
+    glEnd();
 }
 
 void Object3D::applyTransformations() {
+    loadModelView();
+}
+
+// Matrix of one sequential step, as glTranslatef/glRotatef/glScalef apply it.
+static cgvMatrix4 step_matrix(TransformationType type, float x, float y, float z) {
+    switch (type) {
+        case TRANSLATE_OP:
+            return cgvMatrix4::translation(x, y, z);
+        case ROTATE_OP: {
+            cgvMatrix4 r;
+            if (x != 0.0f) r *= cgvMatrix4::rotation(x, 1.0f, 0.0f, 0.0f);
+            if (y != 0.0f) r *= cgvMatrix4::rotation(y, 0.0f, 1.0f, 0.0f);
+            if (z != 0.0f) r *= cgvMatrix4::rotation(z, 0.0f, 0.0f, 1.0f);
+            return r;
+        }
+        case SCALE_OP:
+            return cgvMatrix4::scaling(x, y, z);
+    }
+    return cgvMatrix4();
+}
+
+void Object3D::pushStep(TransformationType type, float x, float y, float z) {
+    transformationHistory.emplace_back(type, x, y, z);
+    transformationHistory.back().before = sequentialMatrix;
+    if (transformationHistory.size() > MAX_UNDO_STEPS) transformationHistory.pop_front();
+    sequentialMatrix *= step_matrix(type, x, y, z);
+}
+
+bool Object3D::undoTransformation() {
+    if (transformationHistory.empty()) return false;
+    const TransformationStep& step = transformationHistory.back();
+    switch (step.type) {
+        case TRANSLATE_OP:
+            translateX -= step.x; translateY -= step.y; translateZ -= step.z;
+            break;
+        case ROTATE_OP:
+            rotateX -= step.x; rotateY -= step.y; rotateZ -= step.z;
+            break;
+        case SCALE_OP:
+            scaleX /= step.x; scaleY /= step.y; scaleZ /= step.z;
+            break;
+    }
+    sequentialMatrix = step.before;
+    transformationHistory.pop_back();
+    markLocalDirty();
+    return true;
+}
+
+void Object3D::updateLocalMatrix() {
     if (rstMode) {
         // RST Mode: Always T-S-R order (reverse of desired R-S-T)
-        glTranslatef(translateX, translateY, translateZ);
-        glScalef(scaleX, scaleY, scaleZ);
-        glRotatef(rotateX, 1.0f, 0.0f, 0.0f);
-        glRotatef(rotateY, 0.0f, 1.0f, 0.0f);
-        glRotatef(rotateZ, 0.0f, 0.0f, 1.0f);
+        localMatrix = cgvMatrix4::translation(translateX, translateY, translateZ)
+                    * cgvMatrix4::scaling(scaleX, scaleY, scaleZ)
+                    * cgvMatrix4::rotation(rotateX, 1.0f, 0.0f, 0.0f)
+                    * cgvMatrix4::rotation(rotateY, 0.0f, 1.0f, 0.0f)
+                    * cgvMatrix4::rotation(rotateZ, 0.0f, 0.0f, 1.0f);
     } else {
         // Sequential Mode: Apply in order of pressing
-        for (const auto& step : transformationHistory) {
-            switch (step.type) {
-                case TRANSLATE_OP:
-                    glTranslatef(step.x, step.y, step.z);
-                    break;
-                case ROTATE_OP:
-                    if (step.x != 0.0f) glRotatef(step.x, 1.0f, 0.0f, 0.0f);
-                    if (step.y != 0.0f) glRotatef(step.y, 0.0f, 1.0f, 0.0f);
-                    if (step.z != 0.0f) glRotatef(step.z, 0.0f, 0.0f, 1.0f);
-                    break;
-                case SCALE_OP:
-                    glScalef(step.x, step.y, step.z);
-                    break;
-            }
-        }
+        localMatrix = sequentialMatrix;
     }
 }
 
 void Object3D::clearTransformationHistory() {
     transformationHistory.clear();
+    sequentialMatrix = cgvMatrix4();
+    markLocalDirty();
+}
+
+void Object3D::submit(RenderQueue& queue) {
+    queue.add(this, RenderPacket::WHOLE_OBJECT, DrawState(), viewDepth());
+}
+
+void Object3D::drawPacket(int) {
+    draw();
+}
+
+float Object3D::viewDepth() {
+    if (!bounded) return 0.0f;
+    return -mat4(getModelViewMatrix()).transform_point(localSphere.center).z;
 }
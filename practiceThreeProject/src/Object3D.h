@@ -1,13 +1,17 @@
 #ifndef PR1_OBJECT3D_H
 #define PR1_OBJECT3D_H
 
+#include <deque>
 #include <iostream>
-#include <vector>
 #ifdef __APPLE__
 #include <GLUT/glut.h>
 #else
 #include <GL/glut.h>
 #endif
+#include "SceneNode.h"
+#include "BoundingVolume.h"
+#include "Ray.h"
+#include "RenderQueue.h"
 
 enum TransformationType {
     TRANSLATE_OP,
@@ -18,12 +22,13 @@ enum TransformationType {
 struct TransformationStep {
     TransformationType type;
     float x, y, z;
+    cgvMatrix4 before; // sequential matrix before this step, restored on undo
 
     TransformationStep(TransformationType t, float _x, float _y, float _z)
         : type(t), x(_x), y(_y), z(_z) {}
 };
 
-class Object3D {
+class Object3D : public SceneNode {
 protected: // Changed to protected to allow access in derived classes if needed
     float translateX, translateY, translateZ;
     float rotateX, rotateY, rotateZ;
@@ -32,7 +37,18 @@ protected: // Changed to protected to allow access in derived classes if needed
 
     bool rstMode; // true = RST, false = Sequential
 
-    std::vector<TransformationStep> transformationHistory;
+    // Sequential mode folds every step into sequentialMatrix as it is made,
+    // so the cost of a transformation does not depend on how many came
+    // before it. Only the most recent steps are kept, for undo.
+    cgvMatrix4 sequentialMatrix;
+    std::deque<TransformationStep> transformationHistory;
+    static const std::size_t MAX_UNDO_STEPS = 64;
+
+    // Extent in the object's own coordinates, for culling. Objects that have
+    // none are always drawn.
+    BoundingBox localBounds;
+    BoundingSphere localSphere;
+    bool bounded;
 
 public:
     Object3D();
@@ -52,19 +68,64 @@ public:
         z = translateZ;
     }
 
+    // Bounds. The sphere is the one around the box unless given.
+    void setLocalBounds(const BoundingBox& box);
+    void setLocalBounds(const BoundingBox& box, const BoundingSphere& sphere);
+    bool hasBounds() const { return bounded; }
+    const BoundingBox& getLocalBounds() const { return localBounds; }
+    const BoundingSphere& getLocalSphere() const { return localSphere; }
+    BoundingBox getWorldBounds(); // the local box under the world matrix
+
+    // Picking. If a world-space ray hits the object before hit.distance,
+    // stores the hit and returns true. Objects with no finer shape are hit
+    // on their local box; objects without bounds are never hit.
+    virtual bool intersect(const Ray& ray, RayHit& hit);
+
+    // Draws the object for the GPU ID pass in flat ID colours (see
+    // IdPicker), objectBits ORed with the part or triangle. By default the
+    // local box is drawn as primitive 0; objects without bounds draw nothing.
+    virtual void drawIds(GLuint objectBits);
+
     // Selection
     void setSelected(bool selected) { isSelected = selected; }
     bool getSelected() const { return isSelected; }
 
-    void setRSTMode(bool mode) { rstMode = mode; }
+    void setRSTMode(bool mode) { rstMode = mode; markLocalDirty(); }
 
     // Virtual methods to be overridden by child classes
     virtual void draw() = 0;
 
-    // Apply transformations
+    // Queues the object's draws for this frame. By default one packet that
+    // runs draw() as a whole, after which the queue assumes nothing about
+    // the GL state; objects that describe their state with packets of their
+    // own are sorted by it and skip what is already set.
+    virtual void submit(RenderQueue& queue);
+    // Draws one submitted packet, with its DrawState already set and the
+    // matrix stack saved by the queue.
+    virtual void drawPacket(int part);
+
+    // Loads the object's cached modelview (camera view * world transform)
+    // into GL, replacing the current modelview matrix.
     void applyTransformations();
 
+    // Forgets the sequential steps: the object is back to the identity in
+    // sequential mode.
     void clearTransformationHistory();
+
+    // Reverts the last sequential step. Returns false when there is nothing
+    // left to undo.
+    bool undoTransformation();
+
+protected:
+    // Distance along the view direction to the centre of the bounds; 0 for
+    // objects without any.
+    float viewDepth();
+
+    // Builds the local matrix from the RST values or takes the sequential one.
+    void updateLocalMatrix() override;
+
+private:
+    void pushStep(TransformationType type, float x, float y, float z);
 };
 
 
@@ -0,0 +1,89 @@
+#include "OffscreenContext.h"
+
+#ifdef PR3_HAVE_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <cstring>
+
+// The Mesa platform that needs neither X nor a GPU device; falls back to the
+// default display where it is missing.
+static EGLDisplay open_display() {
+    const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (extensions && std::strstr(extensions, "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display) {
+            EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) return display;
+        }
+    }
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+OffscreenContext::~OffscreenContext() {
+    if (!display) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context) eglDestroyContext(display, context);
+    if (surface) eglDestroySurface(display, surface);
+    eglTerminate(display);
+}
+
+bool OffscreenContext::create(int width, int height, std::string& error) {
+    EGLDisplay egl_display = open_display();
+    EGLint major, minor;
+    if (egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &major, &minor)) {
+        error = "no EGL display";
+        return false;
+    }
+    display = egl_display;
+
+    const EGLint config_attributes[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_DEPTH_SIZE, 24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configs = 0;
+    if (!eglChooseConfig(egl_display, config_attributes, &config, 1, &configs) || configs == 0) {
+        error = "no EGL config with an RGB pbuffer and a depth buffer";
+        return false;
+    }
+
+    const EGLint surface_attributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+    surface = eglCreatePbufferSurface(egl_display, config, surface_attributes);
+    if (surface == EGL_NO_SURFACE) {
+        surface = nullptr;
+        error = "could not create a pbuffer";
+        return false;
+    }
+
+    // Desktop GL rather than ES; without attributes that is a compatibility
+    // context, which the fixed-function renderer needs.
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        error = "EGL has no desktop OpenGL";
+        return false;
+    }
+    context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, nullptr);
+    if (context == EGL_NO_CONTEXT) {
+        context = nullptr;
+        error = "could not create a GL context";
+        return false;
+    }
+    if (!eglMakeCurrent(egl_display, surface, surface, context)) {
+        error = "could not make the GL context current";
+        return false;
+    }
+    return true;
+}
+
+#else
+
+OffscreenContext::~OffscreenContext() {}
+
+bool OffscreenContext::create(int, int, std::string& error) {
+    error = "built without EGL";
+    return false;
+}
+
+#endif
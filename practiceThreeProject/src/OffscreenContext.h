@@ -0,0 +1,29 @@
+#ifndef OFFSCREEN_CONTEXT_H
+#define OFFSCREEN_CONTEXT_H
+
+#include <string>
+
+// A GL context without a window, for running the renderer where there is no
+// display (the benchmark on a CI box). It renders into an EGL pbuffer, which
+// Mesa provides even with no GPU (llvmpipe) through its surfaceless
+// platform. Builds without EGL get a create() that always fails.
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext();
+
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Creates a compatibility-profile context with an RGB colour and a
+    // depth buffer of the given size, and makes it current on this thread.
+    // On failure, error says why.
+    bool create(int width, int height, std::string& error);
+
+private:
+    void* display = nullptr;
+    void* surface = nullptr;
+    void* context = nullptr;
+};
+
+#endif // OFFSCREEN_CONTEXT_H
@@ -0,0 +1,34 @@
+#include "Picker.h"
+
+PickResult Picker::pick(const std::vector<Object3D*>& objects, const Ray& ray) {
+    // Objects without bounds cannot be hit, so they stay out of the tree.
+    bool sameObjects = objects == pickedObjects;
+    if (!sameObjects) {
+        pickedObjects = objects;
+        treeObjects.clear();
+        for (std::size_t k = 0; k < objects.size(); ++k) {
+            if (objects[k]->hasBounds()) treeObjects.push_back(k);
+        }
+    }
+    treeBounds.resize(treeObjects.size());
+    for (std::size_t b = 0; b < treeObjects.size(); ++b) treeBounds[b] = objects[treeObjects[b]]->getWorldBounds();
+    if (sameObjects) objectTree.refit(treeBounds);
+    else objectTree.build(treeBounds);
+
+    PickResult result;
+    RayHit hit;
+    objectTree.traverse(ray, hit, [&](std::uint32_t b, RayHit& nearest) {
+        std::size_t k = treeObjects[b];
+        if (!objects[k]->intersect(ray, nearest)) return false;
+        result.object = objects[k];
+        result.objectId = static_cast<int>(k);
+        return true;
+    });
+    if (result.hit()) {
+        result.part = hit.part;
+        result.triangle = hit.triangle;
+        result.distance = hit.distance;
+        result.point = ray.at(hit.distance);
+    }
+    return result;
+}
@@ -0,0 +1,40 @@
+#ifndef PICKER_H
+#define PICKER_H
+
+#include <vector>
+#include "BVH.h"
+#include "Object3D.h"
+#include "Ray.h"
+
+// What a ray hit: the object, its index in the list it was picked from, the
+// part and triangle of it (-1 where they do not apply), and where.
+struct PickResult {
+    Object3D* object = nullptr;
+    int objectId = -1;
+    int part = -1;
+    int triangle = -1;
+    GLfloat distance = 0;
+    vec3 point;
+
+    bool hit() const { return object != nullptr; }
+    bool sameTarget(const PickResult& other) const {
+        return object == other.object && part == other.part && triangle == other.triangle;
+    }
+};
+
+// Picks objects on the CPU by casting rays, without drawing anything. The
+// objects' world boxes sit in a BVH that is refitted while the list stays
+// the same and rebuilt when it changes; only objects whose box the ray
+// reaches before the nearest hit so far get their own, finer test.
+class Picker {
+public:
+    PickResult pick(const std::vector<Object3D*>& objects, const Ray& ray);
+
+private:
+    std::vector<Object3D*> pickedObjects; // the list the tree was built for
+    std::vector<std::size_t> treeObjects;  // indices of the bounded ones, in tree order
+    std::vector<BoundingBox> treeBounds;
+    BVH objectTree;
+};
+
+#endif // PICKER_H
@@ -0,0 +1,82 @@
+#ifndef PRIMITIVE_CACHE_H
+#define PRIMITIVE_CACHE_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+#include <map>
+#include <vector>
+
+// Tessellated solids shared by everything that used to call the GLUT/GLU
+// shape functions every frame. Each distinct (shape, size, subdivision) is
+// tessellated once into one shared interleaved position/normal array, which
+// is uploaded to a single vertex buffer when buffer objects are available.
+//
+// The shapes match their GLUT/GLU counterparts: spheres and cubes are
+// centred on the origin, cylinders and cones extend from z = 0 to +height.
+class PrimitiveCache {
+public:
+    static PrimitiveCache& instance();
+
+    void drawSphere(GLfloat radius, GLint slices, GLint stacks);
+    void drawCylinder(GLfloat radius, GLfloat height, GLint slices); // open tube, like gluCylinder
+    void drawCube(GLfloat size);
+    void drawCone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+
+    // A contiguous run of triangles in the shared array.
+    struct Range {
+        GLint first;
+        GLsizei count;
+    };
+
+    // Tessellates on first use and returns where the shape lives, for callers
+    // that draw from the shared buffer themselves.
+    Range sphere(GLfloat radius, GLint slices, GLint stacks);
+    Range cylinder(GLfloat radius, GLfloat height, GLint slices);
+    Range cube(GLfloat size);
+    Range cone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+
+    // Interleaved x, y, z, nx, ny, nz per vertex.
+    static const GLsizei STRIDE = 6 * sizeof(GLfloat);
+    const std::vector<GLfloat>& vertexData() const { return vertices; }
+
+    // Binds the shared buffer (uploading new shapes first) and sets the
+    // vertex/normal pointers. Ranges can then be drawn with glDrawArrays.
+    void bind();
+    void unbind();
+
+    // bind(), one glDrawArrays of the range, unbind().
+    void draw(const Range& range);
+
+private:
+    PrimitiveCache() = default;
+    ~PrimitiveCache();
+
+    enum Shape { SPHERE, CYLINDER, CUBE, CONE };
+
+    struct Key {
+        Shape shape;
+        GLfloat a, b;
+        GLint c, d;
+        bool operator<(const Key& other) const;
+    };
+
+    std::map<Key, Range> ranges;
+    std::vector<GLfloat> vertices;
+
+    GLuint buffer = 0;
+    std::size_t uploadedFloats = 0;
+
+    void addVertex(GLfloat x, GLfloat y, GLfloat z, GLfloat nx, GLfloat ny, GLfloat nz);
+    GLint vertexCount() const { return static_cast<GLint>(vertices.size() / 6); }
+
+    void tessellateSphere(GLfloat radius, GLint slices, GLint stacks);
+    void tessellateCylinder(GLfloat radius, GLfloat height, GLint slices);
+    void tessellateCube(GLfloat size);
+    void tessellateCone(GLfloat base, GLfloat height, GLint slices, GLint stacks);
+};
+
+#endif // PRIMITIVE_CACHE_H
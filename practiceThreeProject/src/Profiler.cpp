@@ -0,0 +1,202 @@
+#include "Profiler.h"
+#include "GLCaps.h"
+#include "GLState.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Frames of GPU samples waiting for their queries; past this the oldest are
+// dropped rather than waited for.
+static const std::size_t MAX_FRAMES_IN_FLIGHT = 6;
+
+static const int HUD_LINE_HEIGHT = 13; // GLUT_BITMAP_8_BY_13
+static const int HUD_CHAR_WIDTH = 8;
+static const int HUD_MARGIN = 6;
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::~Profiler() {
+    // The GL context is usually gone by the time statics are destroyed, so
+    // the queries are left to the driver.
+}
+
+std::size_t Profiler::sectionIndex(const char* name, bool gpu) {
+    for (std::size_t s = 0; s < sections.size(); ++s) {
+        if (sections[s].gpu == gpu && sections[s].name == name) return s;
+    }
+    sections.push_back(Section());
+    sections.back().name = name;
+    sections.back().gpu = gpu;
+    return sections.size() - 1;
+}
+
+void Profiler::addSample(std::size_t section, float ms) {
+    Section& s = sections[section];
+    if (s.history.size() < HISTORY) {
+        s.history.push_back(ms);
+    } else {
+        s.history[s.next] = ms;
+        s.next = (s.next + 1) % HISTORY;
+    }
+    s.last = ms;
+}
+
+void Profiler::addCpuSample(const char* name, double ms) {
+    std::lock_guard<std::mutex> lock(mutex);
+    addSample(sectionIndex(name, false), static_cast<float>(ms));
+}
+
+GLuint Profiler::timestamp() {
+    GLuint query;
+    if (freeQueries.empty()) {
+        glGenQueries(1, &query);
+    } else {
+        query = freeQueries.back();
+        freeQueries.pop_back();
+    }
+    GLCaps::queryTimestamp(query);
+    return query;
+}
+
+void Profiler::recycle(const std::vector<GpuSample>& samples) {
+    for (const GpuSample& sample : samples) {
+        freeQueries.push_back(sample.begin);
+        freeQueries.push_back(sample.end);
+    }
+}
+
+void Profiler::endFrame() {
+    if (!frameSamples.empty()) {
+        inFlight.push_back(std::move(frameSamples));
+        frameSamples.clear();
+    }
+    while (inFlight.size() > MAX_FRAMES_IN_FLIGHT) {
+        recycle(inFlight.front());
+        inFlight.pop_front();
+    }
+
+    // Queries finish in order, so the first frame still running ends the scan.
+    while (!inFlight.empty()) {
+        const std::vector<GpuSample>& frame = inFlight.front();
+        bool ready = true;
+        for (const GpuSample& sample : frame) ready = ready && GLCaps::queryAvailable(sample.end);
+        if (!ready) break;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const GpuSample& sample : frame) {
+            GLuint64 begin = GLCaps::queryResult(sample.begin);
+            GLuint64 end = GLCaps::queryResult(sample.end);
+            addSample(sample.section, end > begin ? static_cast<float>((end - begin) / 1.0e6) : 0.0f);
+        }
+        recycle(frame);
+        inFlight.pop_front();
+    }
+}
+
+std::vector<Profiler::Summary> Profiler::summarize() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Summary> summaries;
+    std::vector<float> sorted;
+    for (const Section& s : sections) {
+        Summary summary = {s.name, s.gpu, s.history.size(), s.last, 0.0, 0.0, 0.0};
+        if (!s.history.empty()) {
+            sorted = s.history;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0;
+            for (float ms : sorted) sum += ms;
+            // Nearest rank: the smallest sample at or above 99% of them.
+            std::size_t rank = static_cast<std::size_t>(std::ceil(0.99 * sorted.size()));
+            summary.min = sorted.front();
+            summary.avg = sum / sorted.size();
+            summary.p99 = sorted[std::max<std::size_t>(rank, 1) - 1];
+        }
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+std::vector<std::string> Profiler::report() const {
+    std::vector<Summary> summaries = summarize();
+    std::size_t width = 4;
+    for (const Summary& s : summaries) width = std::max(width, s.name.size());
+
+    std::vector<std::string> lines;
+    char line[256];
+    std::snprintf(line, sizeof(line), "    %-*s %8s %8s %8s %8s  ms", static_cast<int>(width), "", "last", "min",
+                  "avg", "p99");
+    lines.push_back(line);
+    for (const Summary& s : summaries) {
+        std::snprintf(line, sizeof(line), "%s %-*s %8.3f %8.3f %8.3f %8.3f", s.gpu ? "gpu" : "cpu",
+                      static_cast<int>(width), s.name.c_str(), s.last, s.min, s.avg, s.p99);
+        lines.push_back(line);
+    }
+    if (!GLCaps::timerQueries()) lines.push_back("gpu timer queries not supported");
+    return lines;
+}
+
+void Profiler::drawHud(int windowWidth, int windowHeight) const {
+    std::vector<std::string> lines = report();
+    std::size_t columns = 0;
+    for (const std::string& line : lines) columns = std::max(columns, line.size());
+    const int width = static_cast<int>(columns) * HUD_CHAR_WIDTH + 2 * HUD_MARGIN;
+    const int height = static_cast<int>(lines.size()) * HUD_LINE_HEIGHT + 2 * HUD_MARGIN;
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, windowWidth, windowHeight, 0, -1, 1); // window coordinates, y down
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    GLState::disable(GL_LIGHTING);
+    GLState::disable(GL_DEPTH_TEST);
+    GLState::enable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
+    glRecti(0, 0, width, height);
+    GLState::disable(GL_BLEND);
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    for (std::size_t l = 0; l < lines.size(); ++l) {
+        glRasterPos2i(HUD_MARGIN, HUD_MARGIN + static_cast<int>(l + 1) * HUD_LINE_HEIGHT - 3);
+        for (char c : lines[l]) glutBitmapCharacter(GLUT_BITMAP_8_BY_13, c);
+    }
+
+    GLState::enable(GL_DEPTH_TEST);
+    GLState::enable(GL_LIGHTING);
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+}
+
+bool Profiler::writeCsv(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+    out << "section,clock,samples,last_ms,min_ms,avg_ms,p99_ms\n";
+    for (const Summary& s : summarize()) {
+        out << s.name << ',' << (s.gpu ? "gpu" : "cpu") << ',' << s.samples << ',' << s.last << ',' << s.min << ','
+            << s.avg << ',' << s.p99 << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+GpuProfileScope::GpuProfileScope(const char* name) : section(0) {
+    Profiler& profiler = Profiler::instance();
+    if (!profiler.gpuTiming || !GLCaps::timerQueries()) return;
+    {
+        std::lock_guard<std::mutex> lock(profiler.mutex);
+        section = profiler.sectionIndex(name, true);
+    }
+    begin = profiler.timestamp();
+}
+
+GpuProfileScope::~GpuProfileScope() {
+    if (!begin) return;
+    Profiler& profiler = Profiler::instance();
+    profiler.frameSamples.push_back({section, begin, profiler.timestamp()});
+}
@@ -0,0 +1,128 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Where the frame time goes. Named sections collect CPU times from
+// ProfileScope and GPU times from GpuProfileScope; each keeps its last
+// HISTORY samples, summarised as min/avg/p99 for the HUD and the CSV export.
+//
+// CPU samples may come from any thread (the asset workers record theirs).
+// GPU scopes and everything else belong to the render thread. GPU scopes are
+// pairs of timestamp queries, so they nest, and are read back a few frames
+// later without waiting on the GPU.
+//
+// CPU scopes always record; they cost two clock reads and a lock. GPU
+// scopes issue queries, so they only record while GPU timing is on.
+class Profiler {
+public:
+    static const std::size_t HISTORY = 240;
+
+    struct Summary {
+        std::string name;
+        bool gpu;
+        std::size_t samples; // in the window, at most HISTORY
+        double last, min, avg, p99; // milliseconds
+    };
+
+    static Profiler& instance();
+
+    void setGpuTiming(bool on) { gpuTiming = on; }
+    bool isGpuTiming() const { return gpuTiming; }
+
+    void addCpuSample(const char* name, double ms);
+
+    // Render thread. Call once per frame, before its first GPU scope:
+    // collects the GPU times that have become available.
+    void endFrame();
+
+    // Triangles handed to GL so far, counted by the draw sites. Render thread.
+    void addTriangles(std::uint64_t count) { triangles += count; }
+    std::uint64_t getTriangles() const { return triangles; }
+
+    // Sections in order of first use.
+    std::vector<Summary> summarize() const;
+    // The summaries as a text table, one line per section.
+    std::vector<std::string> report() const;
+    void drawHud(int windowWidth, int windowHeight) const;
+    bool writeCsv(const std::string& path) const;
+
+private:
+    friend class GpuProfileScope;
+
+    struct Section {
+        std::string name;
+        bool gpu;
+        std::vector<float> history; // ring buffer of the last HISTORY samples
+        std::size_t next = 0;
+        float last = 0.0f;
+    };
+
+    // A GPU scope whose timestamps have been issued but not read yet.
+    struct GpuSample {
+        std::size_t section;
+        GLuint begin, end;
+    };
+
+    Profiler() = default;
+    ~Profiler();
+
+    bool gpuTiming = false;
+    std::uint64_t triangles = 0;
+    mutable std::mutex mutex; // sections; CPU samples arrive from any thread
+    std::vector<Section> sections;
+
+    std::vector<GpuSample> frameSamples;          // this frame's
+    std::deque<std::vector<GpuSample>> inFlight;  // earlier frames, oldest first
+    std::vector<GLuint> freeQueries;
+
+    std::size_t sectionIndex(const char* name, bool gpu); // mutex held
+    void addSample(std::size_t section, float ms);        // mutex held
+    GLuint timestamp();
+    void recycle(const std::vector<GpuSample>& samples);
+};
+
+// Times the enclosing block on the CPU. name must outlive the scope.
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : name(name), start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Profiler::instance().addCpuSample(name, std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Times the GL commands issued in the enclosing block on the GPU. Render
+// thread only; does nothing unless GPU timing is on and supported.
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name);
+    ~GpuProfileScope();
+
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    std::size_t section;
+    GLuint begin = 0;
+};
+
+#endif // PROFILER_H
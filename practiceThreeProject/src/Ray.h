@@ -0,0 +1,128 @@
+#ifndef RAY_H
+#define RAY_H
+
+#include <cmath>
+#include <limits>
+#include "BoundingVolume.h"
+#include "cgvMatrix4.h"
+
+// A half line origin + t * direction, t >= 0. Picking rays leave the camera
+// with a unit direction, so t is a world distance; a ray moved into an
+// object's space keeps the same t for the same point.
+struct Ray {
+    vec3 origin;
+    vec3 direction;
+
+    Ray() = default;
+    Ray(const vec3& origin, const vec3& direction) : origin(origin), direction(direction) {}
+
+    vec3 at(GLfloat t) const { return origin + direction * t; }
+
+    // The same ray in the space m maps to (no renormalisation).
+    Ray transformed(const cgvMatrix4& m) const {
+        mat4 a(m);
+        return Ray(a.transform_point(origin), a.transform_vector(direction));
+    }
+};
+
+// The nearest hit of a ray: distance is the t of the hit and doubles as the
+// farthest t still of interest while searching. part and triangle are -1
+// for objects that have none.
+struct RayHit {
+    GLfloat distance = std::numeric_limits<GLfloat>::max();
+    int part = -1;
+    int triangle = -1;
+};
+
+// Ray/shape tests. Each one reports the nearest t in [0, tMax) and returns
+// false when there is none.
+class RayTests {
+public:
+    // Slab test with 1 / direction precomputed, for testing many boxes.
+    static bool box(const Ray& ray, const vec3& inverseDirection, const BoundingBox& b, GLfloat tMax,
+                    GLfloat& t) {
+        GLfloat tNear = 0.0f, tFar = tMax;
+        for (int axis = 0; axis < 3; ++axis) {
+            GLfloat t0 = (b.min[axis] - ray.origin[axis]) * inverseDirection[axis];
+            GLfloat t1 = (b.max[axis] - ray.origin[axis]) * inverseDirection[axis];
+            if (t0 > t1) std::swap(t0, t1);
+            // NaN (a flat box seen exactly edge on) leaves the bounds alone.
+            tNear = t0 > tNear ? t0 : tNear;
+            tFar = t1 < tFar ? t1 : tFar;
+            if (tNear > tFar) return false;
+        }
+        t = tNear;
+        return true;
+    }
+
+    static bool box(const Ray& ray, const BoundingBox& b, GLfloat tMax, GLfloat& t) {
+        return box(ray, inverse(ray.direction), b, tMax, t);
+    }
+
+    static bool sphere(const Ray& ray, const vec3& center, GLfloat radius, GLfloat tMax, GLfloat& t) {
+        vec3 oc = ray.origin - center;
+        GLfloat a = dot(ray.direction, ray.direction);
+        GLfloat b = dot(oc, ray.direction);
+        GLfloat c = dot(oc, oc) - radius * radius;
+        GLfloat discriminant = b * b - a * c;
+        if (a == 0.0f || discriminant < 0.0f) return false;
+        GLfloat root = std::sqrt(discriminant);
+        GLfloat hit = (-b - root) / a;
+        if (hit < 0.0f) hit = (-b + root) / a; // origin inside
+        if (hit < 0.0f || hit >= tMax) return false;
+        t = hit;
+        return true;
+    }
+
+    // Open tube around the z axis from z = 0 to height, like gluCylinder:
+    // a ray through an end sees the inside wall.
+    static bool cylinder(const Ray& ray, GLfloat radius, GLfloat height, GLfloat tMax, GLfloat& t) {
+        const vec3& o = ray.origin;
+        const vec3& d = ray.direction;
+        GLfloat a = d.x * d.x + d.y * d.y;
+        if (a == 0.0f) return false; // parallel to the wall
+        GLfloat b = o.x * d.x + o.y * d.y;
+        GLfloat c = o.x * o.x + o.y * o.y - radius * radius;
+        GLfloat discriminant = b * b - a * c;
+        if (discriminant < 0.0f) return false;
+        GLfloat root = std::sqrt(discriminant);
+        const GLfloat roots[2] = {(-b - root) / a, (-b + root) / a};
+        for (GLfloat hit : roots) {
+            if (hit < 0.0f || hit >= tMax) continue;
+            GLfloat z = o.z + hit * d.z;
+            if (z >= 0.0f && z <= height) {
+                t = hit;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Moller-Trumbore, both faces.
+    static bool triangle(const Ray& ray, const vec3& p0, const vec3& p1, const vec3& p2, GLfloat tMax,
+                         GLfloat& t) {
+        vec3 e1 = p1 - p0, e2 = p2 - p0;
+        vec3 p = cross(ray.direction, e2);
+        GLfloat det = dot(e1, p);
+        if (std::fabs(det) < 1e-12f) return false;
+        GLfloat inverseDet = 1.0f / det;
+        vec3 s = ray.origin - p0;
+        GLfloat u = dot(s, p) * inverseDet;
+        if (u < 0.0f || u > 1.0f) return false;
+        vec3 q = cross(s, e1);
+        GLfloat v = dot(ray.direction, q) * inverseDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        GLfloat hit = dot(e2, q) * inverseDet;
+        if (hit < 0.0f || hit >= tMax) return false;
+        t = hit;
+        return true;
+    }
+
+    // Component-wise 1 / d; zero components become infinities the slab test
+    // handles.
+    static vec3 inverse(const vec3& d) {
+        return vec3(1.0f / d.x, 1.0f / d.y, 1.0f / d.z);
+    }
+};
+
+#endif // RAY_H
@@ -0,0 +1,86 @@
+#include "RenderQueue.h"
+#include "Object3D.h"
+#include <cstring>
+
+static const Material& default_material() {
+    static const Material material;
+    return material;
+}
+
+std::uint64_t RenderQueue::makeKey(RenderPass pass, unsigned material, GLuint texture, float depth) {
+    // Positive floats order like their bit patterns; anything behind the
+    // eye counts as distance 0.
+    std::uint32_t depthBits = 0;
+    if (depth > 0.0f) std::memcpy(&depthBits, &depth, sizeof(depthBits));
+    return (std::uint64_t(pass & 0xf) << 60) | (std::uint64_t(material & 0xffff) << 44) |
+           (std::uint64_t(texture & 0xffff) << 28) | (depthBits >> 4);
+}
+
+void RenderQueue::clear() {
+    packets.clear();
+    materials.clear();
+}
+
+unsigned RenderQueue::materialIndex(const Material* material) {
+    if (!material) return 0;
+    for (std::size_t m = 0; m < materials.size(); ++m) {
+        if (materials[m] == material) return static_cast<unsigned>(m + 1);
+    }
+    materials.push_back(material);
+    return static_cast<unsigned>(materials.size());
+}
+
+void RenderQueue::add(Object3D* object, int part, const DrawState& state, float depth) {
+    packets.push_back({makeKey(state.pass, materialIndex(state.material), state.texture, depth), object, part, state});
+}
+
+void RenderQueue::sort() {
+    // Least significant byte first; each pass is a stable counting sort, and
+    // bytes every key shares are skipped, which with a handful of materials
+    // and textures is most of them.
+    sorted.resize(packets.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::size_t counts[256] = {};
+        for (const RenderPacket& p : packets) ++counts[(p.key >> shift) & 0xff];
+        if (counts[(packets[0].key >> shift) & 0xff] == packets.size()) continue;
+
+        std::size_t offset = 0;
+        for (std::size_t& c : counts) {
+            std::size_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (const RenderPacket& p : packets) sorted[counts[(p.key >> shift) & 0xff]++] = p;
+        packets.swap(sorted);
+    }
+}
+
+void RenderQueue::applyState(const DrawState& state) {
+    const bool lit = state.pass != PASS_UNLIT;
+    if (lit) (state.material ? *state.material : default_material()).apply();
+    GLState::setEnabled(GL_LIGHTING, lit);
+    GLState::setEnabled(GL_TEXTURE_2D, state.texture != 0);
+    if (state.texture != 0) GLState::bindTexture2D(state.texture);
+}
+
+void RenderQueue::execute() {
+    stats = Stats();
+    stats.packets = static_cast<unsigned>(packets.size());
+    if (packets.empty()) return;
+    sort();
+
+    const GLState::Counts before = GLState::getCounts();
+    glPushMatrix();
+    for (const RenderPacket& p : packets) {
+        applyState(p.state);
+        p.object->drawPacket(p.part);
+    }
+    glPopMatrix();
+    // Left as the code around the queue expects them.
+    GLState::enable(GL_LIGHTING);
+    GLState::disable(GL_TEXTURE_2D);
+
+    const GLState::Counts& after = GLState::getCounts();
+    stats.state.issued = after.issued - before.issued;
+    stats.state.filtered = after.filtered - before.filtered;
+}
@@ -0,0 +1,77 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#if defined(__APPLE__) && defined(__MACH__)
+#include <GLUT/glut.h>
+#else
+#include <GL/glut.h>
+#endif
+
+#include <cstdint>
+#include <vector>
+#include "GLState.h"
+#include "Material.h"
+
+class Object3D;
+
+// Passes run in this order. Lighting is on for the opaque pass and off for
+// the unlit one (gizmos, placeholders).
+enum RenderPass : unsigned char { PASS_OPAQUE, PASS_UNLIT, PASS_COUNT };
+
+// The GL state a packet is drawn with. Everything else (colour, matrices,
+// buffers) is the packet's own business.
+struct DrawState {
+    RenderPass pass = PASS_OPAQUE;
+    const Material* material = nullptr; // null: Material's defaults
+    GLuint texture = 0;                 // 0: texturing off
+};
+
+// One draw of one object: the part to hand back to drawPacket(), the state
+// to set first, and the key it is sorted by.
+struct RenderPacket {
+    static const int WHOLE_OBJECT = -1; // drawPacket() runs draw()
+
+    std::uint64_t key;
+    Object3D* object;
+    int part;
+    DrawState state;
+};
+
+// The frame's draws, collected with submit(), sorted so that packets
+// sharing state end up next to each other, and drawn setting that state
+// through GLState, which drops what the previous packet already set.
+//
+// Sort key, most significant first:
+//   pass (4 bits) | material (16) | texture (16) | depth (28)
+// Materials are numbered in order of first use within the frame; the depth
+// is the top bits of the view distance as a float, which order like the
+// distances themselves, so equal state draws front to back.
+class RenderQueue {
+public:
+    struct Stats {
+        unsigned packets = 0;
+        GLState::Counts state; // GL state calls made while drawing
+    };
+
+    void clear();
+    void add(Object3D* object, int part, const DrawState& state, float depth);
+    // Radix sorts the packets by key, then draws them in that order.
+    void execute();
+
+    std::size_t size() const { return packets.size(); }
+    const std::vector<RenderPacket>& getPackets() const { return packets; } // in execution order after execute()
+    const Stats& getStats() const { return stats; } // of the last execute()
+
+    static std::uint64_t makeKey(RenderPass pass, unsigned material, GLuint texture, float depth);
+
+private:
+    std::vector<RenderPacket> packets, sorted;
+    std::vector<const Material*> materials; // numbered this frame
+    Stats stats;
+
+    unsigned materialIndex(const Material* material);
+    void sort();
+    static void applyState(const DrawState& state);
+};
+
+#endif // RENDER_QUEUE_H
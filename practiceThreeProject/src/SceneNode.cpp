@@ -0,0 +1,88 @@
+#include "SceneNode.h"
+#include <algorithm>
+#include <cstring>
+
+cgvMatrix4 SceneNode::viewMatrix;
+unsigned SceneNode::viewVersion = 1;
+
+SceneNode::SceneNode()
+    : parent(nullptr), localDirty(false), worldDirty(false), modelViewVersion(0) {}
+
+SceneNode::~SceneNode() {
+    if (parent) parent->removeChild(this);
+    for (SceneNode* child : children) {
+        child->parent = nullptr;
+        child->markWorldDirty();
+    }
+}
+
+void SceneNode::addChild(SceneNode* child) {
+    if (child->parent == this) return;
+    if (child->parent) child->parent->removeChild(child);
+    child->parent = this;
+    children.push_back(child);
+    child->markWorldDirty();
+}
+
+void SceneNode::removeChild(SceneNode* child) {
+    auto it = std::find(children.begin(), children.end(), child);
+    if (it == children.end()) return;
+    children.erase(it);
+    child->parent = nullptr;
+    child->markWorldDirty();
+}
+
+void SceneNode::setLocalMatrix(const cgvMatrix4& matrix) {
+    localMatrix = matrix;
+    localDirty = false;
+    markWorldDirty();
+}
+
+void SceneNode::markLocalDirty() {
+    localDirty = true;
+    markWorldDirty();
+}
+
+void SceneNode::markWorldDirty() {
+    // A dirty node always has a dirty subtree: a child is only cleaned after
+    // its parent, so there is nothing left to do below a node already dirty.
+    if (worldDirty) return;
+    worldDirty = true;
+    for (SceneNode* child : children) child->markWorldDirty();
+}
+
+const cgvMatrix4& SceneNode::getLocalMatrix() {
+    if (localDirty) {
+        updateLocalMatrix();
+        localDirty = false;
+    }
+    return localMatrix;
+}
+
+const cgvMatrix4& SceneNode::getWorldMatrix() {
+    if (worldDirty) {
+        worldMatrix = parent ? parent->getWorldMatrix() * getLocalMatrix() : getLocalMatrix();
+        worldDirty = false;
+        modelViewVersion = 0;
+    }
+    return worldMatrix;
+}
+
+const cgvMatrix4& SceneNode::getModelViewMatrix() {
+    const cgvMatrix4& world = getWorldMatrix();
+    if (modelViewVersion != viewVersion) {
+        modelViewMatrix = viewMatrix * world;
+        modelViewVersion = viewVersion;
+    }
+    return modelViewMatrix;
+}
+
+void SceneNode::loadModelView() {
+    glLoadMatrixf(getModelViewMatrix().data());
+}
+
+void SceneNode::setViewMatrix(const cgvMatrix4& view) {
+    if (std::memcmp(view.data(), viewMatrix.data(), sizeof(GLfloat) * 16) == 0) return;
+    viewMatrix = view;
+    if (++viewVersion == 0) viewVersion = 1; // 0 marks a modelview as never computed
+}
@@ -0,0 +1,65 @@
+#ifndef SCENE_NODE_H
+#define SCENE_NODE_H
+
+#include <vector>
+#include "cgvMatrix4.h"
+
+// A node of the scene hierarchy. It keeps its local transform, its world
+// transform (parent world * local) and its modelview (view * world), and only
+// recomputes them when something they depend on has changed: changing a
+// node's local transform marks it and its whole subtree dirty, and a new view
+// matrix invalidates every cached modelview at once through a version number.
+// A static object under a still camera therefore costs one glLoadMatrixf.
+class SceneNode {
+public:
+    SceneNode();
+    virtual ~SceneNode(); // detaches from the parent and from every child
+
+    SceneNode(const SceneNode&) = delete;
+    SceneNode& operator=(const SceneNode&) = delete;
+
+    // The child keeps its local transform and is now relative to this node.
+    void addChild(SceneNode* child);
+    void removeChild(SceneNode* child);
+    SceneNode* getParent() const { return parent; }
+
+    void setLocalMatrix(const cgvMatrix4& matrix);
+    const cgvMatrix4& getLocalMatrix();
+    const cgvMatrix4& getWorldMatrix();
+    const cgvMatrix4& getModelViewMatrix();
+
+    // Replaces the GL modelview matrix with this node's modelview.
+    void loadModelView();
+
+    // The camera publishes its view matrix here every frame; cached
+    // modelviews are only invalidated when it actually changed.
+    static void setViewMatrix(const cgvMatrix4& view);
+    static const cgvMatrix4& getViewMatrix() { return viewMatrix; }
+    // Changes whenever the view matrix does; never 0.
+    static unsigned getViewVersion() { return viewVersion; }
+
+protected:
+    // Subclasses that derive the local matrix from other state (translate,
+    // rotate, scale...) mark it stale and rebuild it in updateLocalMatrix().
+    void markLocalDirty();
+    virtual void updateLocalMatrix() {}
+
+    cgvMatrix4 localMatrix;
+
+private:
+    SceneNode* parent;
+    std::vector<SceneNode*> children;
+
+    cgvMatrix4 worldMatrix;
+    cgvMatrix4 modelViewMatrix;
+    bool localDirty;
+    bool worldDirty;
+    unsigned modelViewVersion;
+
+    void markWorldDirty();
+
+    static cgvMatrix4 viewMatrix;
+    static unsigned viewVersion;
+};
+
+#endif // SCENE_NODE_H
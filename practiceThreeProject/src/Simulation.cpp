@@ -0,0 +1,175 @@
+#include "Simulation.h"
+#include "ArticulatedModel.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// The camera animation's speed
+static const float CAMERA_ORBIT_DEG_PER_S = 10.0f;
+
+// The light animation's path: a circle above the floor
+static const float LIGHT_PATH_RADIUS = 7.0f;
+static const float LIGHT_PATH_HEIGHT = 5.0f;
+static const float LIGHT_PATH_SPEED = 0.5f; // radians per second
+
+// Crowd robots posed per job
+static const std::size_t CROWD_CHUNK = 2048;
+
+// Into [0, 360). The orbit is kept wrapped so that it never grows large
+// enough for one step to be lost to float rounding.
+static float wrap_degrees(float degrees) {
+    degrees = std::fmod(degrees, 360.0f);
+    return degrees < 0.0f ? degrees + 360.0f : degrees;
+}
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+Simulation::Simulation(const ArticulatedModel& robot) : robot(robot) {}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::setAnimations(bool model, bool camera, bool light) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        animateModel = model;
+        animateCamera = camera;
+        animateLight = light;
+    }
+    wake.notify_one();
+}
+
+void Simulation::setCrowdPhases(std::vector<float> _phases) {
+    std::lock_guard<std::mutex> lock(mutex);
+    crowdPhases = std::move(_phases);
+    crowdChanged = true;
+}
+
+void Simulation::start(std::function<double()> clock) {
+    if (thread.joinable()) return;
+    stopping = false;
+    thread = std::thread(&Simulation::threadLoop, this, std::move(clock));
+}
+
+void Simulation::stop() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void Simulation::threadLoop(std::function<double()> clock) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        // Nothing to animate: sleep until there is.
+        if (!isAnimating()) {
+            wake.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        advanceTo(clock());
+        const double waitMs = nextStep * STEP_MS - clock();
+        lock.lock();
+        if (waitMs > 0.0 && !stopping) wake.wait_for(lock, std::chrono::duration<double, std::milli>(waitMs));
+    }
+}
+
+void Simulation::advanceTo(double nowMs) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (crowdChanged) {
+            phases = crowdPhases;
+            crowdChanged = false;
+        }
+    }
+
+    const long long due = static_cast<long long>(std::floor(nowMs / STEP_MS));
+    if (steps == 0 || due - nextStep >= MAX_CATCH_UP_STEPS) {
+        // Starting, or back from a pause: the two steps up to now are all
+        // there is to interpolate between.
+        nextStep = due - 1;
+        steps = 0;
+    }
+    if (nextStep > due) return;
+    for (; nextStep <= due; ++nextStep) {
+        step(nextStep * STEP_MS);
+        ++steps;
+    }
+
+    Snapshot& snapshot = snapshots.back();
+    snapshot.previous = previous;
+    snapshot.current = current;
+    snapshot.ready = steps >= 2;
+    snapshots.publish();
+}
+
+void Simulation::step(double timeMs) {
+    // current becomes previous; what was previous before is overwritten, so
+    // its buffers are reused.
+    std::swap(previous, current);
+    current.timeMs = timeMs;
+    const float seconds = static_cast<float>(timeMs / 1000.0);
+
+    if (animateModel) robot.pose_at(seconds, current.robotPose);
+    else std::copy(previous.robotPose, previous.robotPose + 3, current.robotPose);
+
+    current.cameraOrbitDeg = previous.cameraOrbitDeg;
+    if (animateCamera) {
+        current.cameraOrbitDeg =
+            wrap_degrees(current.cameraOrbitDeg + CAMERA_ORBIT_DEG_PER_S * static_cast<float>(STEP_MS / 1000.0));
+    }
+
+    if (animateLight) {
+        current.lightPosition[0] = std::sin(seconds * LIGHT_PATH_SPEED) * LIGHT_PATH_RADIUS;
+        current.lightPosition[1] = LIGHT_PATH_HEIGHT;
+        current.lightPosition[2] = std::cos(seconds * LIGHT_PATH_SPEED) * LIGHT_PATH_RADIUS;
+    } else {
+        std::copy(previous.lightPosition, previous.lightPosition + 3, current.lightPosition);
+    }
+
+    const std::size_t robots = phases.size();
+    if (!animateModel) {
+        current.crowdPoses = previous.crowdPoses;
+        current.crowdPoses.resize(robots * 3, 0.0f);
+        return;
+    }
+    current.crowdPoses.resize(robots * 3);
+    float* poses = current.crowdPoses.data();
+    JobSystem::instance().parallel_for(robots, CROWD_CHUNK, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t r = begin; r < end; ++r) robot.pose_at(seconds + phases[r], poses + 3 * r);
+    });
+}
+
+bool Simulation::sample(double nowMs, SimulationState& state) {
+    snapshots.acquire();
+    const Snapshot& snapshot = snapshots.front();
+    if (!snapshot.ready) return false;
+
+    const SimulationState& a = snapshot.previous;
+    const SimulationState& b = snapshot.current;
+    const double t = (nowMs - STEP_MS - a.timeMs) / (b.timeMs - a.timeMs);
+    const float alpha = static_cast<float>(std::min(1.0, std::max(0.0, t)));
+
+    state.timeMs = a.timeMs + (b.timeMs - a.timeMs) * alpha;
+    for (int d = 0; d < 3; ++d) state.robotPose[d] = lerp(a.robotPose[d], b.robotPose[d], alpha);
+    // Across the wrap, b is a little above 0 and a a little below 360.
+    const float orbitEnd = b.cameraOrbitDeg < a.cameraOrbitDeg - 180.0f ? b.cameraOrbitDeg + 360.0f : b.cameraOrbitDeg;
+    state.cameraOrbitDeg = wrap_degrees(lerp(a.cameraOrbitDeg, orbitEnd, alpha));
+    for (int c = 0; c < 3; ++c) state.lightPosition[c] = lerp(a.lightPosition[c], b.lightPosition[c], alpha);
+    if (a.crowdPoses.size() == b.crowdPoses.size()) {
+        state.crowdPoses.resize(b.crowdPoses.size());
+        for (std::size_t p = 0; p < b.crowdPoses.size(); ++p) {
+            state.crowdPoses[p] = lerp(a.crowdPoses[p], b.crowdPoses[p], alpha);
+        }
+    } else {
+        state.crowdPoses = b.crowdPoses;
+    }
+    return true;
+}
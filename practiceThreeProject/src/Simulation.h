@@ -0,0 +1,95 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "TripleBuffer.h"
+
+class ArticulatedModel;
+
+// Everything the animations move, at one instant.
+struct SimulationState {
+    double timeMs = 0.0;
+    float robotPose[3] = {0.0f, 0.0f, 0.0f};
+    float cameraOrbitDeg = 0.0f; // turned by the camera animation since the start, modulo 360
+    float lightPosition[3] = {0.0f, 0.0f, 0.0f};
+    std::vector<float> crowdPoses; // three DoFs per crowd robot
+};
+
+// Advances the animations in fixed steps of STEP_MS, on a thread of its own
+// or on the caller's, and publishes the last two steps through a triple
+// buffer. The render thread draws the state interpolated between them, one
+// step behind its clock, so a slow frame no longer slows the animations and
+// a fast one still sees them move smoothly.
+//
+// The crowd's robots are posed in parallel on the JobSystem.
+//
+// The steps only depend on the clock, so a replay that drives the clock and
+// calls advanceTo() itself gets the same states every time.
+class Simulation {
+public:
+    static constexpr double STEP_MS = 1000.0 / 120.0;
+    // Further behind than this, the simulation skips ahead instead of
+    // catching up, as after a pause.
+    static const int MAX_CATCH_UP_STEPS = 12;
+
+    // The robot is only asked for pose_at(), which reads its joint limits.
+    explicit Simulation(const ArticulatedModel& robot);
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    // Render thread: which animations to advance, and the crowd's robots by
+    // their animation phases (empty outside crowd mode).
+    void setAnimations(bool model, bool camera, bool light);
+    void setCrowdPhases(std::vector<float> phases);
+
+    // Steps on a thread of its own while any animation runs, keeping up with
+    // clock (milliseconds), which is called from that thread.
+    void start(std::function<double()> clock);
+    void stop();
+    bool isRunning() const { return thread.joinable(); }
+
+    // Without the thread: runs every step due by nowMs on the calling thread.
+    void advanceTo(double nowMs);
+
+    // Render thread: the state at nowMs - STEP_MS, interpolated between the
+    // latest two steps. False until there are two.
+    bool sample(double nowMs, SimulationState& state);
+
+private:
+    struct Snapshot {
+        SimulationState previous, current;
+        bool ready = false;
+    };
+
+    const ArticulatedModel& robot;
+    TripleBuffer<Snapshot> snapshots;
+
+    // Stepping state, owned by whichever thread steps.
+    SimulationState previous, current;
+    long long nextStep = 0; // index of the next step; step n is at n * STEP_MS
+    int steps = 0;          // since the last skip
+    std::vector<float> phases;
+
+    std::atomic<bool> animateModel{false}, animateCamera{false}, animateLight{false};
+
+    std::mutex mutex; // guards the members below
+    std::condition_variable wake;
+    std::vector<float> crowdPhases;
+    bool crowdChanged = false;
+    bool stopping = false;
+
+    std::thread thread;
+
+    void step(double timeMs);
+    void threadLoop(std::function<double()> clock);
+    bool isAnimating() const { return animateModel || animateCamera || animateLight; }
+};
+
+#endif // SIMULATION_H
@@ -1,13 +1,15 @@
 #include "Texture.h"
 #include "lodepng.h"
+#include "GLState.h"
 #include <iostream>
 #include <vector>
 
-Texture::Texture() : textureID(0) {}
+Texture::Texture() : textureID(0), minFilter(GL_LINEAR), magFilter(GL_LINEAR) {}
 
 Texture::~Texture() {
     if (textureID != 0) {
         glDeleteTextures(1, &textureID);
+        GLState::textureDeleted(textureID);
     }
 }
 
@@ -15,44 +17,57 @@ bool Texture::load(const std::string& filename) {
     std::vector<unsigned char> image;
     unsigned int width, height;
 
+    if (!decode(filename, image, width, height)) {
+        return false;
+    }
+    upload(image, width, height);
+    return true;
+}
+
+bool Texture::decode(const std::string& filename, std::vector<unsigned char>& image, unsigned& width, unsigned& height) {
     unsigned error = lodepng::decode(image, width, height, filename);
     if (error) {
         std::cerr << "Lodepng error " << error << ": " << lodepng_error_text(error) << " for file " << filename << std::endl;
         return false;
     }
+    return true;
+}
 
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
+void Texture::upload(const std::vector<unsigned char>& image, unsigned width, unsigned height) {
+    if (textureID == 0) {
+        glGenTextures(1, &textureID);
+    }
+    GLState::bindTexture2D(textureID);
 
     // Lodepng loads as RGBA by default
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &image[0]);
 
-    // Default filters
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return true;
+    GLState::bindTexture2D(0);
 }
 
 void Texture::bind() const {
     if (textureID != 0) {
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::bindTexture2D(textureID);
     }
 }
 
 void Texture::unbind() const {
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GLState::bindTexture2D(0);
 }
 
-void Texture::setFilters(GLint minFilter, GLint magFilter) {
+void Texture::setFilters(GLint _minFilter, GLint _magFilter) {
+    // Remembered so that a texture still being decoded picks them up on upload.
+    minFilter = _minFilter;
+    magFilter = _magFilter;
     if (textureID != 0) {
-        glBindTexture(GL_TEXTURE_2D, textureID);
+        GLState::bindTexture2D(textureID);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        GLState::bindTexture2D(0);
     }
 }
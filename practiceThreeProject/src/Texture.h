@@ -8,6 +8,7 @@
 #endif
 
 #include <string>
+#include <vector>
 
 class Texture {
 public:
@@ -18,9 +19,18 @@ public:
     void bind() const;
     void unbind() const;
     void setFilters(GLint minFilter, GLint magFilter);
+    bool isLoaded() const { return textureID != 0; }
+    GLuint getId() const { return textureID; }
+
+    // Split form of load(): decode() needs no GL context and may run on any
+    // thread, upload() must run on the GL thread.
+    static bool decode(const std::string& filename, std::vector<unsigned char>& image, unsigned& width, unsigned& height);
+    void upload(const std::vector<unsigned char>& image, unsigned width, unsigned height);
 
 private:
     GLuint textureID;
+    GLint minFilter;
+    GLint magFilter;
 };
 
 #endif // TEXTURE_H
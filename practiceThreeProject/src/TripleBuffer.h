@@ -0,0 +1,39 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without locks and
+// without either waiting on the other. The writer fills back() and publishes
+// it; the reader picks up the latest published value with acquire(). A value
+// the reader never picked up is simply overwritten by the next one.
+//
+// Of the three slots, one is the writer's, one the reader's, and the third
+// holds the latest published value; publishing and acquiring swap slots.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer.
+    T& back() { return slots[backIndex]; }
+    void publish() { backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+    // Reader. front() is what the last successful acquire() picked up, or a
+    // default-constructed T before that.
+    bool acquire() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH)) return false;
+        frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return slots[frontIndex]; }
+
+private:
+    static const unsigned INDEX = 3; // the slot bits of middle
+    static const unsigned FRESH = 4; // published and not acquired yet
+
+    T slots[3];
+    unsigned backIndex = 0;
+    unsigned frontIndex = 1;
+    std::atomic<unsigned> middle{2};
+};
+
+#endif // TRIPLE_BUFFER_H
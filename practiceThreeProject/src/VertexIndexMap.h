@@ -0,0 +1,81 @@
+#ifndef VERTEX_INDEX_MAP_H
+#define VERTEX_INDEX_MAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Flat open-addressing hash map from an OBJ (v_idx, n_idx) pair to the index
+// of the vertex emitted for it. Slots live in one contiguous array and are
+// probed linearly, so a lookup touches one or two cache lines and inserting
+// never allocates once the table has been sized.
+//
+// OBJ vertex indices are 1-based, so the packed key 0 marks an empty slot.
+class VertexIndexMap {
+public:
+    explicit VertexIndexMap(std::size_t expected_entries = 0) { reset(expected_entries); }
+
+    // Empties the map and sizes it for about expected_entries insertions.
+    void reset(std::size_t expected_entries) {
+        std::size_t capacity = 16;
+        while (capacity < expected_entries * 2) capacity <<= 1; // load factor <= 0.5
+        slots.assign(capacity, Slot{0, 0});
+        mask = capacity - 1;
+        count = 0;
+    }
+
+    // Returns the index stored for the pair. If the pair is new, stores
+    // new_value for it, sets inserted and returns new_value.
+    unsigned int find_or_insert(unsigned int v_idx, unsigned int n_idx, unsigned int new_value, bool& inserted) {
+        const std::uint64_t key = (static_cast<std::uint64_t>(v_idx) << 32) | n_idx;
+        std::size_t i = hash(key) & mask;
+        while (slots[i].key != 0) {
+            if (slots[i].key == key) {
+                inserted = false;
+                return slots[i].value;
+            }
+            i = (i + 1) & mask;
+        }
+        slots[i] = Slot{key, new_value};
+        inserted = true;
+        if (++count * 2 > slots.size()) grow();
+        return new_value;
+    }
+
+    std::size_t size() const { return count; }
+
+private:
+    struct Slot {
+        std::uint64_t key;
+        unsigned int value;
+    };
+
+    std::vector<Slot> slots;
+    std::size_t mask = 0;
+    std::size_t count = 0;
+
+    // 64-bit finalizer from MurmurHash3; spreads neighbouring indices apart.
+    static std::size_t hash(std::uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return static_cast<std::size_t>(key);
+    }
+
+    void grow() {
+        std::vector<Slot> old;
+        old.swap(slots);
+        slots.assign(old.size() * 2, Slot{0, 0});
+        mask = slots.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.key == 0) continue;
+            std::size_t i = hash(slot.key) & mask;
+            while (slots[i].key != 0) i = (i + 1) & mask;
+            slots[i] = slot;
+        }
+    }
+};
+
+#endif // VERTEX_INDEX_MAP_H
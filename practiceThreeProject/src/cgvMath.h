@@ -0,0 +1,288 @@
+#ifndef CGV_MATH_H
+#define CGV_MATH_H
+
+#include <cmath>
+#include <cstddef>
+#include "cgvPoint3D.h"
+#include "cgvMatrix4.h"
+
+// Header-only vector math: vec3, vec4 and mat4 (column-major, like
+// cgvMatrix4), plus kernels that work on arrays of vectors stored as separate
+// x, y and z arrays (SoA), eight lanes at a time with AVX2 and four with SSE.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define CGV_SSE 1
+#include <emmintrin.h>
+#else
+#define CGV_SSE 0
+#endif
+
+#if defined(__AVX2__)
+#define CGV_AVX2 1
+#include <immintrin.h>
+#else
+#define CGV_AVX2 0
+#endif
+
+struct vec3 {
+    GLfloat x = 0, y = 0, z = 0;
+
+    constexpr vec3() = default;
+    constexpr vec3(GLfloat x, GLfloat y, GLfloat z) : x(x), y(y), z(z) {}
+    constexpr vec3(const cgvPoint3D& p) : x(p[X]), y(p[Y]), z(p[Z]) {}
+    constexpr operator cgvPoint3D() const { return cgvPoint3D(x, y, z); }
+
+    constexpr GLfloat& operator[](unsigned char idx) { return idx == X ? x : idx == Y ? y : z; }
+    constexpr GLfloat operator[](unsigned char idx) const { return idx == X ? x : idx == Y ? y : z; }
+
+    constexpr vec3 operator+(const vec3& v) const { return vec3(x + v.x, y + v.y, z + v.z); }
+    constexpr vec3 operator-(const vec3& v) const { return vec3(x - v.x, y - v.y, z - v.z); }
+    constexpr vec3 operator*(const vec3& v) const { return vec3(x * v.x, y * v.y, z * v.z); }
+    constexpr vec3 operator*(GLfloat s) const { return vec3(x * s, y * s, z * s); }
+    constexpr vec3 operator/(GLfloat s) const { return vec3(x / s, y / s, z / s); }
+    constexpr vec3 operator-() const { return vec3(-x, -y, -z); }
+    constexpr vec3& operator+=(const vec3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+    constexpr vec3& operator-=(const vec3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+    constexpr vec3& operator*=(GLfloat s) { x *= s; y *= s; z *= s; return *this; }
+};
+
+constexpr vec3 operator*(GLfloat s, const vec3& v) { return v * s; }
+constexpr GLfloat dot(const vec3& a, const vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+constexpr vec3 cross(const vec3& a, const vec3& b) {
+    return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+inline GLfloat length(const vec3& v) { return std::sqrt(dot(v, v)); }
+// Near-zero vectors come back unchanged, as with cgvPoint3D::normalize.
+inline vec3 normalize(const vec3& v) {
+    GLfloat len = length(v);
+    return len > IGV_EPSILON ? v / len : v;
+}
+
+struct vec4 {
+    GLfloat x = 0, y = 0, z = 0, w = 0;
+
+    constexpr vec4() = default;
+    constexpr vec4(GLfloat x, GLfloat y, GLfloat z, GLfloat w) : x(x), y(y), z(z), w(w) {}
+    constexpr vec4(const vec3& v, GLfloat w) : x(v.x), y(v.y), z(v.z), w(w) {}
+
+    constexpr vec3 xyz() const { return vec3(x, y, z); }
+
+    constexpr vec4 operator+(const vec4& v) const { return vec4(x + v.x, y + v.y, z + v.z, w + v.w); }
+    constexpr vec4 operator-(const vec4& v) const { return vec4(x - v.x, y - v.y, z - v.z, w - v.w); }
+    constexpr vec4 operator*(GLfloat s) const { return vec4(x * s, y * s, z * s, w * s); }
+};
+
+constexpr GLfloat dot(const vec4& a, const vec4& b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+// out = a * b for column-major 4x4 matrices; out may alias neither input.
+// Each column of the result is a combination of a's columns, added in the
+// same order as the scalar loop so both give the same floats.
+inline void mat4_multiply(const GLfloat* a, const GLfloat* b, GLfloat* out) {
+#if CGV_SSE
+    const __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+    for (int col = 0; col < 4; ++col) {
+        const GLfloat* bc = b + col * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        _mm_storeu_ps(out + col * 4, r);
+    }
+#else
+    for (int col = 0; col < 4; ++col) {
+        for (int row = 0; row < 4; ++row) {
+            GLfloat sum = a[row] * b[col * 4];
+            for (int k = 1; k < 4; ++k) sum += a[k * 4 + row] * b[col * 4 + k];
+            out[col * 4 + row] = sum;
+        }
+    }
+#endif
+}
+
+struct mat4 {
+    GLfloat m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1}; // identity
+
+    constexpr mat4() = default;
+    explicit mat4(const cgvMatrix4& matrix) {
+        for (int i = 0; i < 16; ++i) m[i] = matrix.data()[i];
+    }
+    cgvMatrix4 to_matrix4() const {
+        cgvMatrix4 matrix;
+        for (int col = 0; col < 4; ++col) {
+            for (int row = 0; row < 4; ++row) matrix(row, col) = (*this)(row, col);
+        }
+        return matrix;
+    }
+
+    static constexpr mat4 translation(const vec3& t) {
+        mat4 r;
+        r.m[12] = t.x; r.m[13] = t.y; r.m[14] = t.z;
+        return r;
+    }
+    static constexpr mat4 scaling(const vec3& s) {
+        mat4 r;
+        r.m[0] = s.x; r.m[5] = s.y; r.m[10] = s.z;
+        return r;
+    }
+
+    // Element at (row, column).
+    constexpr GLfloat& operator()(int row, int col) { return m[col * 4 + row]; }
+    constexpr GLfloat operator()(int row, int col) const { return m[col * 4 + row]; }
+
+    constexpr vec4 column(int col) const { return vec4(m[col * 4], m[col * 4 + 1], m[col * 4 + 2], m[col * 4 + 3]); }
+
+    mat4 operator*(const mat4& other) const {
+        mat4 r;
+        mat4_multiply(m, other.m, r.m);
+        return r;
+    }
+    constexpr vec4 operator*(const vec4& v) const {
+        return vec4(m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+                    m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+                    m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+                    m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w);
+    }
+    // Affine transforms: the bottom row is taken to be (0, 0, 0, 1).
+    constexpr vec3 transform_point(const vec3& p) const {
+        return vec3(m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12],
+                    m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+                    m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]);
+    }
+    constexpr vec3 transform_vector(const vec3& v) const {
+        return vec3(m[0] * v.x + m[4] * v.y + m[8] * v.z,
+                    m[1] * v.x + m[5] * v.y + m[9] * v.z,
+                    m[2] * v.x + m[6] * v.y + m[10] * v.z);
+    }
+
+    constexpr mat4 transposed() const {
+        mat4 r;
+        for (int col = 0; col < 4; ++col) {
+            for (int row = 0; row < 4; ++row) r(row, col) = (*this)(col, row);
+        }
+        return r;
+    }
+};
+
+// N vectors as three separate arrays, which is what the batch kernels below
+// and SIMD registers want. Inputs and outputs may be the same arrays.
+struct vec3_soa {
+    GLfloat* x;
+    GLfloat* y;
+    GLfloat* z;
+};
+
+// The widest float registers the build targets, behind a common interface so
+// each batch kernel is written once.
+class cgvSimd {
+public:
+#if CGV_AVX2
+    typedef __m256 batch;
+    static const std::size_t WIDTH = 8;
+    static batch load(const GLfloat* p) { return _mm256_loadu_ps(p); }
+    static void store(GLfloat* p, batch v) { _mm256_storeu_ps(p, v); }
+    static batch set1(GLfloat s) { return _mm256_set1_ps(s); }
+    static batch add(batch a, batch b) { return _mm256_add_ps(a, b); }
+    static batch sub(batch a, batch b) { return _mm256_sub_ps(a, b); }
+    static batch mul(batch a, batch b) { return _mm256_mul_ps(a, b); }
+    static batch div(batch a, batch b) { return _mm256_div_ps(a, b); }
+    static batch sqrt(batch a) { return _mm256_sqrt_ps(a); }
+    static batch greater(batch a, batch b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static batch less(batch a, batch b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static batch mask_or(batch a, batch b) { return _mm256_or_ps(a, b); }
+    static int mask_bits(batch mask) { return _mm256_movemask_ps(mask); } // bit i set if lane i is
+    static batch select(batch mask, batch a, batch b) { return _mm256_blendv_ps(b, a, mask); }
+#elif CGV_SSE
+    typedef __m128 batch;
+    static const std::size_t WIDTH = 4;
+    static batch load(const GLfloat* p) { return _mm_loadu_ps(p); }
+    static void store(GLfloat* p, batch v) { _mm_storeu_ps(p, v); }
+    static batch set1(GLfloat s) { return _mm_set1_ps(s); }
+    static batch add(batch a, batch b) { return _mm_add_ps(a, b); }
+    static batch sub(batch a, batch b) { return _mm_sub_ps(a, b); }
+    static batch mul(batch a, batch b) { return _mm_mul_ps(a, b); }
+    static batch div(batch a, batch b) { return _mm_div_ps(a, b); }
+    static batch sqrt(batch a) { return _mm_sqrt_ps(a); }
+    static batch greater(batch a, batch b) { return _mm_cmpgt_ps(a, b); }
+    static batch less(batch a, batch b) { return _mm_cmplt_ps(a, b); }
+    static batch mask_or(batch a, batch b) { return _mm_or_ps(a, b); }
+    static int mask_bits(batch mask) { return _mm_movemask_ps(mask); } // bit i set if lane i is
+    static batch select(batch mask, batch a, batch b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#else
+    static const std::size_t WIDTH = 1; // scalar tails only
+#endif
+};
+
+// out[i] = m * (in[i], 1), for an affine m.
+inline void transform_points(const mat4& m, const vec3_soa& in, const vec3_soa& out, std::size_t count) {
+    std::size_t i = 0;
+#if CGV_SSE
+    typedef cgvSimd S;
+    const S::batch m0 = S::set1(m.m[0]), m1 = S::set1(m.m[1]), m2 = S::set1(m.m[2]);
+    const S::batch m4 = S::set1(m.m[4]), m5 = S::set1(m.m[5]), m6 = S::set1(m.m[6]);
+    const S::batch m8 = S::set1(m.m[8]), m9 = S::set1(m.m[9]), m10 = S::set1(m.m[10]);
+    const S::batch m12 = S::set1(m.m[12]), m13 = S::set1(m.m[13]), m14 = S::set1(m.m[14]);
+    for (const std::size_t whole = count - count % S::WIDTH; i < whole; i += S::WIDTH) {
+        S::batch x = S::load(in.x + i), y = S::load(in.y + i), z = S::load(in.z + i);
+        S::store(out.x + i, S::add(S::add(S::add(S::mul(m0, x), S::mul(m4, y)), S::mul(m8, z)), m12));
+        S::store(out.y + i, S::add(S::add(S::add(S::mul(m1, x), S::mul(m5, y)), S::mul(m9, z)), m13));
+        S::store(out.z + i, S::add(S::add(S::add(S::mul(m2, x), S::mul(m6, y)), S::mul(m10, z)), m14));
+    }
+#endif
+    for (; i < count; ++i) {
+        vec3 p = m.transform_point(vec3(in.x[i], in.y[i], in.z[i]));
+        out.x[i] = p.x; out.y[i] = p.y; out.z[i] = p.z;
+    }
+}
+
+// out[i] = a[i] x b[i]
+inline void cross(const vec3_soa& a, const vec3_soa& b, const vec3_soa& out, std::size_t count) {
+    std::size_t i = 0;
+#if CGV_SSE
+    typedef cgvSimd S;
+    for (const std::size_t whole = count - count % S::WIDTH; i < whole; i += S::WIDTH) {
+        S::batch ax = S::load(a.x + i), ay = S::load(a.y + i), az = S::load(a.z + i);
+        S::batch bx = S::load(b.x + i), by = S::load(b.y + i), bz = S::load(b.z + i);
+        S::store(out.x + i, S::sub(S::mul(ay, bz), S::mul(az, by)));
+        S::store(out.y + i, S::sub(S::mul(az, bx), S::mul(ax, bz)));
+        S::store(out.z + i, S::sub(S::mul(ax, by), S::mul(ay, bx)));
+    }
+#endif
+    for (; i < count; ++i) {
+        vec3 c = cross(vec3(a.x[i], a.y[i], a.z[i]), vec3(b.x[i], b.y[i], b.z[i]));
+        out.x[i] = c.x; out.y[i] = c.y; out.z[i] = c.z;
+    }
+}
+
+// Normalizes v[0, count) in place; the results match vec3's normalize.
+inline void normalize(const vec3_soa& v, std::size_t count) {
+    std::size_t i = 0;
+#if CGV_SSE
+    typedef cgvSimd S;
+    const S::batch epsilon = S::set1(static_cast<GLfloat>(IGV_EPSILON));
+    const S::batch one = S::set1(1.0f);
+    for (const std::size_t whole = count - count % S::WIDTH; i < whole; i += S::WIDTH) {
+        S::batch x = S::load(v.x + i), y = S::load(v.y + i), z = S::load(v.z + i);
+        S::batch len = S::sqrt(S::add(S::add(S::mul(x, x), S::mul(y, y)), S::mul(z, z)));
+        S::batch divisor = S::select(S::greater(len, epsilon), len, one);
+        S::store(v.x + i, S::div(x, divisor));
+        S::store(v.y + i, S::div(y, divisor));
+        S::store(v.z + i, S::div(z, divisor));
+    }
+#endif
+    for (; i < count; ++i) {
+        vec3 n = normalize(vec3(v.x[i], v.y[i], v.z[i]));
+        v.x[i] = n.x; v.y[i] = n.y; v.z[i] = n.z;
+    }
+}
+
+// Conversions between packed cgvPoint3D arrays and SoA.
+inline void to_soa(const cgvPoint3D* points, std::size_t count, const vec3_soa& out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        out.x[i] = points[i][X]; out.y[i] = points[i][Y]; out.z[i] = points[i][Z];
+    }
+}
+inline void from_soa(const vec3_soa& in, std::size_t count, cgvPoint3D* points) {
+    for (std::size_t i = 0; i < count; ++i) points[i] = cgvPoint3D(in.x[i], in.y[i], in.z[i]);
+}
+
+#endif // CGV_MATH_H
@@ -0,0 +1,130 @@
+#include "cgvMatrix4.h"
+#include "cgvMath.h"
+#include <cmath>
+
+cgvMatrix4::cgvMatrix4() {
+    for (int i = 0; i < 16; ++i) m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+cgvMatrix4 cgvMatrix4::translation(GLfloat x, GLfloat y, GLfloat z) {
+    cgvMatrix4 r;
+    r(0, 3) = x;
+    r(1, 3) = y;
+    r(2, 3) = z;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::rotation(GLfloat degrees, GLfloat x, GLfloat y, GLfloat z) {
+    cgvMatrix4 r;
+    GLfloat length = std::sqrt(x * x + y * y + z * z);
+    if (length == 0.0f) return r;
+    x /= length; y /= length; z /= length;
+
+    // Same matrix glRotatef builds.
+    GLfloat radians = degrees * static_cast<GLfloat>(M_PI) / 180.0f;
+    GLfloat c = std::cos(radians), s = std::sin(radians), t = 1.0f - c;
+    r(0, 0) = x * x * t + c;     r(0, 1) = x * y * t - z * s; r(0, 2) = x * z * t + y * s;
+    r(1, 0) = y * x * t + z * s; r(1, 1) = y * y * t + c;     r(1, 2) = y * z * t - x * s;
+    r(2, 0) = x * z * t - y * s; r(2, 1) = y * z * t + x * s; r(2, 2) = z * z * t + c;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::scaling(GLfloat x, GLfloat y, GLfloat z) {
+    cgvMatrix4 r;
+    r(0, 0) = x;
+    r(1, 1) = y;
+    r(2, 2) = z;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::lookAt(GLfloat eyeX, GLfloat eyeY, GLfloat eyeZ,
+                              GLfloat centerX, GLfloat centerY, GLfloat centerZ,
+                              GLfloat upX, GLfloat upY, GLfloat upZ) {
+    // Forward, side = forward x up, and the corrected up = side x forward.
+    GLfloat f[3] = {centerX - eyeX, centerY - eyeY, centerZ - eyeZ};
+    GLfloat fl = std::sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    if (fl > 0.0f) { f[0] /= fl; f[1] /= fl; f[2] /= fl; }
+
+    GLfloat s[3] = {f[1] * upZ - f[2] * upY, f[2] * upX - f[0] * upZ, f[0] * upY - f[1] * upX};
+    GLfloat sl = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    if (sl > 0.0f) { s[0] /= sl; s[1] /= sl; s[2] /= sl; }
+
+    GLfloat u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+
+    cgvMatrix4 r;
+    r(0, 0) = s[0];  r(0, 1) = s[1];  r(0, 2) = s[2];
+    r(1, 0) = u[0];  r(1, 1) = u[1];  r(1, 2) = u[2];
+    r(2, 0) = -f[0]; r(2, 1) = -f[1]; r(2, 2) = -f[2];
+    return r * translation(-eyeX, -eyeY, -eyeZ);
+}
+
+cgvMatrix4 cgvMatrix4::perspective(GLfloat fovY, GLfloat aspect, GLfloat zNear, GLfloat zFar) {
+    GLfloat f = 1.0f / std::tan(fovY * static_cast<GLfloat>(M_PI) / 360.0f);
+    cgvMatrix4 r;
+    r(0, 0) = f / aspect;
+    r(1, 1) = f;
+    r(2, 2) = (zFar + zNear) / (zNear - zFar);
+    r(2, 3) = 2.0f * zFar * zNear / (zNear - zFar);
+    r(3, 2) = -1.0f;
+    r(3, 3) = 0.0f;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::orthographic(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top,
+                                    GLfloat zNear, GLfloat zFar) {
+    cgvMatrix4 r;
+    r(0, 0) = 2.0f / (right - left);
+    r(1, 1) = 2.0f / (top - bottom);
+    r(2, 2) = -2.0f / (zFar - zNear);
+    r(0, 3) = -(right + left) / (right - left);
+    r(1, 3) = -(top + bottom) / (top - bottom);
+    r(2, 3) = -(zFar + zNear) / (zFar - zNear);
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::inverse() const {
+    // Cofactor expansion over 2x2 sub-determinants of the top and bottom
+    // row pairs.
+    const GLfloat* a = m;
+    GLfloat s0 = a[0] * a[5] - a[4] * a[1], s1 = a[0] * a[9] - a[8] * a[1], s2 = a[0] * a[13] - a[12] * a[1];
+    GLfloat s3 = a[4] * a[9] - a[8] * a[5], s4 = a[4] * a[13] - a[12] * a[5], s5 = a[8] * a[13] - a[12] * a[9];
+    GLfloat c5 = a[10] * a[15] - a[14] * a[11], c4 = a[6] * a[15] - a[14] * a[7], c3 = a[6] * a[11] - a[10] * a[7];
+    GLfloat c2 = a[2] * a[15] - a[14] * a[3], c1 = a[2] * a[11] - a[10] * a[3], c0 = a[2] * a[7] - a[6] * a[3];
+
+    GLfloat det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    cgvMatrix4 r;
+    if (det == 0.0f) return r;
+    GLfloat inv = 1.0f / det;
+
+    r.m[0] = (a[5] * c5 - a[9] * c4 + a[13] * c3) * inv;
+    r.m[4] = (-a[4] * c5 + a[8] * c4 - a[12] * c3) * inv;
+    r.m[8] = (a[7] * s5 - a[11] * s4 + a[15] * s3) * inv;
+    r.m[12] = (-a[6] * s5 + a[10] * s4 - a[14] * s3) * inv;
+
+    r.m[1] = (-a[1] * c5 + a[9] * c2 - a[13] * c1) * inv;
+    r.m[5] = (a[0] * c5 - a[8] * c2 + a[12] * c1) * inv;
+    r.m[9] = (-a[3] * s5 + a[11] * s2 - a[15] * s1) * inv;
+    r.m[13] = (a[2] * s5 - a[10] * s2 + a[14] * s1) * inv;
+
+    r.m[2] = (a[1] * c4 - a[5] * c2 + a[13] * c0) * inv;
+    r.m[6] = (-a[0] * c4 + a[4] * c2 - a[12] * c0) * inv;
+    r.m[10] = (a[3] * s4 - a[7] * s2 + a[15] * s0) * inv;
+    r.m[14] = (-a[2] * s4 + a[6] * s2 - a[14] * s0) * inv;
+
+    r.m[3] = (-a[1] * c3 + a[5] * c1 - a[9] * c0) * inv;
+    r.m[7] = (a[0] * c3 - a[4] * c1 + a[8] * c0) * inv;
+    r.m[11] = (-a[3] * s3 + a[7] * s1 - a[11] * s0) * inv;
+    r.m[15] = (a[2] * s3 - a[6] * s1 + a[10] * s0) * inv;
+    return r;
+}
+
+cgvMatrix4 cgvMatrix4::operator*(const cgvMatrix4& other) const {
+    cgvMatrix4 r;
+    mat4_multiply(m, other.m, r.m);
+    return r;
+}
+
+cgvMatrix4& cgvMatrix4::operator*=(const cgvMatrix4& other) {
+    *this = *this * other;
+    return *this;
+}
@@ -8,6 +8,7 @@
 #endif
 
 #include <cmath>
+#include <type_traits>
 
 #define IGV_EPSILON 0.000001
 
@@ -16,30 +17,52 @@
 enum Coordinates { X, Y, Z };
 #endif
 
+// Everything is inline and the copy operations are the implicit ones, so the
+// class is trivially copyable and the compiler can vectorize loops over it.
+// cgvMath.h has the vec3 it converts to and the batch kernels.
 class cgvPoint3D {
 private:
     GLfloat c[3] = {0,0,0};
 
 public:
     cgvPoint3D() = default;
-    cgvPoint3D(const GLfloat& x, const GLfloat& y, const GLfloat& z);
-    cgvPoint3D(const cgvPoint3D& p);
-    ~cgvPoint3D() = default;
+    constexpr cgvPoint3D(const GLfloat& x, const GLfloat& y, const GLfloat& z) : c{x, y, z} {}
 
-    cgvPoint3D& operator=(const cgvPoint3D& p);
-    GLfloat& operator[](unsigned char idx);
-    GLfloat operator[](unsigned char idx) const;
+    constexpr GLfloat& operator[](unsigned char idx) { return c[idx]; }
+    constexpr GLfloat operator[](unsigned char idx) const { return c[idx]; }
 
-    cgvPoint3D operator+(const cgvPoint3D& p) const;
-    cgvPoint3D& operator+=(const cgvPoint3D& p);
-    cgvPoint3D operator-(const cgvPoint3D& p) const;
+    constexpr cgvPoint3D operator+(const cgvPoint3D& p) const {
+        return cgvPoint3D(c[X] + p.c[X], c[Y] + p.c[Y], c[Z] + p.c[Z]);
+    }
+    constexpr cgvPoint3D& operator+=(const cgvPoint3D& p) {
+        c[X] += p.c[X]; c[Y] += p.c[Y]; c[Z] += p.c[Z];
+        return *this;
+    }
+    constexpr cgvPoint3D operator-(const cgvPoint3D& p) const {
+        return cgvPoint3D(c[X] - p.c[X], c[Y] - p.c[Y], c[Z] - p.c[Z]);
+    }
 
-    cgvPoint3D cross(const cgvPoint3D& p) const;
-    void normalize();
-    GLfloat length() const;
+    constexpr cgvPoint3D cross(const cgvPoint3D& p) const {
+        return cgvPoint3D(
+            c[Y] * p.c[Z] - c[Z] * p.c[Y],
+            c[Z] * p.c[X] - c[X] * p.c[Z],
+            c[X] * p.c[Y] - c[Y] * p.c[X]
+        );
+    }
+
+    void normalize() {
+        GLfloat len = length();
+        if (len > IGV_EPSILON) {
+            c[X] /= len;
+            c[Y] /= len;
+            c[Z] /= len;
+        }
+    }
+
+    GLfloat length() const { return std::sqrt(c[X] * c[X] + c[Y] * c[Y] + c[Z] * c[Z]); }
 };
 
-inline GLfloat& cgvPoint3D::operator[](unsigned char idx) { return c[idx]; }
-inline GLfloat cgvPoint3D::operator[](unsigned char idx) const { return c[idx]; }
+static_assert(std::is_trivially_copyable<cgvPoint3D>::value, "cgvPoint3D is copied with memcpy");
+static_assert(sizeof(cgvPoint3D) == 3 * sizeof(GLfloat), "cgvPoint3D arrays are passed to GL as packed xyz");
 
 #endif
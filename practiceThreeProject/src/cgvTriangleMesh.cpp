@@ -1,4 +1,13 @@
 #include "cgvTriangleMesh.h"
+#include "GLCaps.h"
+#include "GLState.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "cgvMath.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
 
 #if defined(__APPLE__) && defined(__MACH__)
 #include <GLUT/glut.h>
@@ -6,53 +15,563 @@
 #include <GL/glut.h>
 #endif
 
+float cgvTriangleMesh::lod_pixels_per_unit = 0.0f;
+bool cgvTriangleMesh::lod_perspective = true;
+float cgvTriangleMesh::lod_tolerance = 1.0f;
+bool cgvTriangleMesh::lod_enabled = true;
+
+// Wire box shown while the mesh is still being loaded, drawn with lighting
+// off.
+static void draw_placeholder() {
+    static const GLfloat corners[8][3] = {
+        {-1, -1, -1}, {1, -1, -1}, {1, 1, -1}, {-1, 1, -1},
+        {-1, -1, 1}, {1, -1, 1}, {1, 1, 1}, {-1, 1, 1}
+    };
+    static const int edges[12][2] = {
+        {0, 1}, {1, 2}, {2, 3}, {3, 0}, {4, 5}, {5, 6}, {6, 7}, {7, 4},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+
+    glColor3f(0.6f, 0.6f, 0.8f);
+    glBegin(GL_LINES);
+    for (const auto& edge : edges) {
+        glVertex3fv(corners[edge[0]]);
+        glVertex3fv(corners[edge[1]]);
+    }
+    glEnd();
+}
+
+cgvTriangleMesh::cgvTriangleMesh() {
+    set_specular_reflectivity(0.5f);
+    set_shininess(10.0f);
+}
+
+std::size_t cgvTriangleMesh::lod_in_view() {
+    if (lod_levels.empty() || !hasBounds()) return 0;
+    // Nearest point of the bounding sphere in view space decides the level.
+    mat4 modelView(getModelViewMatrix());
+    vec3 center = modelView.transform_point(localSphere.center);
+    float scale = std::max(length(modelView.transform_vector(vec3(1, 0, 0))),
+                           std::max(length(modelView.transform_vector(vec3(0, 1, 0))),
+                                    length(modelView.transform_vector(vec3(0, 0, 1)))));
+    return select_lod(length(center) - localSphere.radius * scale, scale);
+}
+
 void cgvTriangleMesh::draw() {
     glPushMatrix();
+    if (loading) {
+        GLState::disable(GL_LIGHTING);
+        drawPacket(PLACEHOLDER_PART);
+        GLState::enable(GL_LIGHTING);
+    } else {
+        GLState::material(GL_SPECULAR, material.getSpecular());
+        GLState::material(GL_SHININESS, material.getShininess());
+
+        drawPacket(static_cast<int>(lod_in_view()));
+
+        GLfloat default_specular[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        GLState::material(GL_SPECULAR, default_specular);
+        GLState::material(GL_SHININESS, 0.0f);
+    }
+    glPopMatrix();
+}
+
+void cgvTriangleMesh::submit(RenderQueue& queue) {
+    DrawState state;
+    if (loading) {
+        state.pass = PASS_UNLIT;
+        queue.add(this, PLACEHOLDER_PART, state, viewDepth());
+        return;
+    }
+    state.material = &material;
+    queue.add(this, static_cast<int>(lod_in_view()), state, viewDepth());
+}
+
+void cgvTriangleMesh::drawPacket(int part) {
     applyTransformations();
+    if (part == PLACEHOLDER_PART) {
+        draw_placeholder();
+        return;
+    }
 
-    GLfloat specular[] = { specular_reflectivity, specular_reflectivity, specular_reflectivity, 1.0f };
-    glMaterialfv(GL_FRONT, GL_SPECULAR, specular);
-    glMaterialf(GL_FRONT, GL_SHININESS, shininess);
     glColor3f(0.6f, 0.6f, 0.8f);
+    std::size_t level = static_cast<std::size_t>(part);
+    if (use_gpu_buffers && GLCaps::bufferObjects()) {
+        draw_buffers(level);
+    } else {
+        draw_client_arrays(level);
+    }
+}
+
+LodLevel cgvTriangleMesh::get_lod(std::size_t level) const {
+    if (level == 0 || level > lod_levels.size()) return {0, triangles.size() * 3, 0.0f};
+    return lod_levels[level - 1];
+}
+
+const GLvoid* cgvTriangleMesh::lod_offset(std::size_t level) const {
+    if (level == 0 || level > lod_levels.size()) return nullptr;
+    return reinterpret_cast<const GLvoid*>((triangles.size() * 3 + lod_levels[level - 1].first) * sizeof(GLuint));
+}
+
+void cgvTriangleMesh::set_lods(std::vector<cgvTriangle> triangles, std::vector<LodLevel> levels) {
+    lod_triangles = std::move(triangles);
+    lod_levels = std::move(levels);
+    indices_dirty = true;
+}
+
+void cgvTriangleMesh::set_lod_projection(float pixels_per_unit, bool perspective) {
+    lod_pixels_per_unit = pixels_per_unit;
+    lod_perspective = perspective;
+}
+
+std::size_t cgvTriangleMesh::select_lod(float distance, float scale) const {
+    if (!lod_enabled || lod_levels.empty() || lod_pixels_per_unit <= 0.0f) return 0;
+    float pixels_per_error = lod_pixels_per_unit * scale;
+    if (lod_perspective) {
+        if (distance <= 0.0f) return 0; // the camera is inside the bounds
+        pixels_per_error /= distance;
+    }
+    for (std::size_t level = lod_levels.size(); level > 0; --level) {
+        if (lod_levels[level - 1].error * pixels_per_error <= lod_tolerance) return level;
+    }
+    return 0;
+}
+
+void cgvTriangleMesh::draw_client_arrays(std::size_t level) {
+    // A short normal array would be read past its end.
+    const bool has_normals = normals.size() >= vertices.size();
 
     glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_NORMAL_ARRAY);
+    if (has_normals) glEnableClientState(GL_NORMAL_ARRAY);
 
     glVertexPointer(3, GL_FLOAT, 0, vertices.data());
-    glNormalPointer(GL_FLOAT, 0, normals.data());
+    if (has_normals) glNormalPointer(GL_FLOAT, 0, normals.data());
 
-    glDrawElements(GL_TRIANGLES, triangles.size() * 3, GL_UNSIGNED_INT, triangles.data());
+    LodLevel lod = get_lod(level);
+    const GLuint* indices = level == 0 ? reinterpret_cast<const GLuint*>(triangles.data())
+                                       : reinterpret_cast<const GLuint*>(lod_triangles.data()) + lod.first;
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(lod.count), GL_UNSIGNED_INT, indices);
+    Profiler::instance().addTriangles(lod.count / 3);
 
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_NORMAL_ARRAY);
+}
+
+// Binds the buffers and sets up the client-state pointers into them. With a
+// vertex array object this is recorded once and replayed by a single bind.
+static void bind_mesh_buffers(GLuint vertex_buffer, GLuint index_buffer, std::size_t vertex_count) {
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    glNormalPointer(GL_FLOAT, 0, reinterpret_cast<const GLvoid*>(vertex_count * sizeof(cgvPoint3D)));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+}
 
-    GLfloat default_specular[] = { 0.0f, 0.0f, 0.0f, 1.0f };
-    glMaterialfv(GL_FRONT, GL_SPECULAR, default_specular);
-    glMaterialf(GL_FRONT, GL_SHININESS, 0.0f);
+void cgvTriangleMesh::upload_buffers() {
+    if (vertex_buffer == 0) glGenBuffers(1, &vertex_buffer);
+    if (index_buffer == 0) glGenBuffers(1, &index_buffer);
 
-    glPopMatrix();
+    bool layout_changed = false;
+    if (vertices_dirty) {
+        // Normals live right after the positions. A mesh with fewer normals
+        // than vertices gets zero normals for the rest.
+        const std::size_t section = vertices.size() * sizeof(cgvPoint3D);
+        const std::size_t normal_bytes = std::min(normals.size(), vertices.size()) * sizeof(cgvPoint3D);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        if (vertices.size() != uploaded_vertex_count) {
+            glBufferData(GL_ARRAY_BUFFER, 2 * section, nullptr, GL_STATIC_DRAW);
+            uploaded_vertex_count = vertices.size();
+            layout_changed = true;
+        }
+        glBufferSubData(GL_ARRAY_BUFFER, 0, section, vertices.data());
+        if (normal_bytes < section) {
+            std::vector<cgvPoint3D> padded(normals.begin(), normals.begin() + normal_bytes / sizeof(cgvPoint3D));
+            padded.resize(vertices.size(), cgvPoint3D(0, 0, 0));
+            glBufferSubData(GL_ARRAY_BUFFER, section, section, padded.data());
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, section, section, normals.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        vertices_dirty = false;
+    }
+
+    if (indices_dirty) {
+        // The full mesh, then the levels of detail.
+        const std::size_t bytes = triangles.size() * sizeof(cgvTriangle);
+        const std::size_t lod_bytes = lod_triangles.size() * sizeof(cgvTriangle);
+        const std::size_t index_count = (triangles.size() + lod_triangles.size()) * 3;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+        if (index_count != uploaded_index_count) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes + lod_bytes, nullptr, GL_STATIC_DRAW);
+            uploaded_index_count = index_count;
+        }
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes, triangles.data());
+        if (lod_bytes) glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, bytes, lod_bytes, lod_triangles.data());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        indices_dirty = false;
+    }
+
+    if (GLCaps::vertexArrayObjects() && (vertex_array == 0 || layout_changed)) {
+        if (vertex_array == 0) GLCaps::genVertexArrays(1, &vertex_array);
+        GLCaps::bindVertexArray(vertex_array);
+        bind_mesh_buffers(vertex_buffer, index_buffer, uploaded_vertex_count);
+        GLCaps::bindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+GLsizei cgvTriangleMesh::bind_buffers() {
+    if (!GLCaps::bufferObjects()) return 0;
+    if (vertices_dirty || indices_dirty) upload_buffers();
+    if (uploaded_index_count == 0) return 0;
+
+    if (vertex_array != 0) {
+        GLCaps::bindVertexArray(vertex_array);
+    } else {
+        bind_mesh_buffers(vertex_buffer, index_buffer, uploaded_vertex_count);
+    }
+    return static_cast<GLsizei>(triangles.size() * 3);
+}
+
+void cgvTriangleMesh::unbind_buffers() {
+    if (vertex_array != 0) {
+        GLCaps::bindVertexArray(0);
+    } else {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+}
+
+void cgvTriangleMesh::draw_buffers(std::size_t level) {
+    if (bind_buffers() == 0) return;
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(get_lod(level).count), GL_UNSIGNED_INT, lod_offset(level));
+    Profiler::instance().addTriangles(get_lod(level).count / 3);
+    unbind_buffers();
+}
+
+void cgvTriangleMesh::release_buffers() {
+    if (vertex_array != 0) GLCaps::deleteVertexArrays(1, &vertex_array);
+    if (vertex_buffer != 0) glDeleteBuffers(1, &vertex_buffer);
+    if (index_buffer != 0) glDeleteBuffers(1, &index_buffer);
+    vertex_array = vertex_buffer = index_buffer = 0;
+    uploaded_vertex_count = uploaded_index_count = 0;
+    vertices_dirty = indices_dirty = true;
+}
+
+cgvTriangleMesh::~cgvTriangleMesh() {
+    release_buffers();
+}
+
+// With several threads, normals are built in three passes that each split
+// cleanly: face normals per triangle, a compressed vertex -> triangle
+// adjacency, and a per-vertex gather + normalize. Every vertex sums its faces
+// in triangle order with the same float operations as a plain scatter-add,
+// so the result is the same bit for bit whatever the number of threads.
+// Building the adjacency costs about seven times the serial scatter-add in
+// total, mostly in atomic increments, so below NORMALS_MIN_THREADS face
+// normals are scatter-added directly instead.
+
+// Face normal padded to four floats so it loads as one SSE register.
+struct alignas(16) FaceNormal {
+    GLfloat x, y, z, pad;
+};
+
+static const std::size_t NORMALS_BLOCK = 16384; // triangles or vertices per task
+static const std::size_t SCATTER_CHUNK = 256;   // face normals kept in L1 by the serial path
+static const std::size_t SOA_CHUNK = 256;       // vectors gathered for a cgvMath batch kernel
+static const std::size_t NORMALS_MIN_THREADS = 8;
+
+// Face normals of triangles [begin, end), written to faces[0, end - begin).
+// The edges are gathered into SoA chunks for cgvMath's cross kernel.
+static void compute_face_normals(const std::vector<cgvPoint3D>& vertices, const std::vector<cgvTriangle>& triangles,
+                                 std::size_t begin, std::size_t end, FaceNormal* faces) {
+    GLfloat e1[3][SOA_CHUNK], e2[3][SOA_CHUNK], n[3][SOA_CHUNK];
+    const vec3_soa edge1{e1[X], e1[Y], e1[Z]}, edge2{e2[X], e2[Y], e2[Z]}, normal{n[X], n[Y], n[Z]};
+    for (std::size_t chunk = begin; chunk < end; chunk += SOA_CHUNK) {
+        const std::size_t count = std::min(end - chunk, SOA_CHUNK);
+        for (std::size_t i = 0; i < count; ++i) {
+            const cgvTriangle& tri = triangles[chunk + i];
+            const cgvPoint3D& p0 = vertices[tri.v[0]];
+            const cgvPoint3D& p1 = vertices[tri.v[1]];
+            const cgvPoint3D& p2 = vertices[tri.v[2]];
+            for (int axis = 0; axis < 3; ++axis) {
+                e1[axis][i] = p1[axis] - p0[axis];
+                e2[axis][i] = p2[axis] - p0[axis];
+            }
+        }
+        cross(edge1, edge2, normal, count);
+        FaceNormal* out = faces + (chunk - begin);
+        for (std::size_t i = 0; i < count; ++i) out[i] = {n[X][i], n[Y][i], n[Z][i], 0.0f};
+    }
+}
+
+// Normalizes normals[begin, end) in place, a SoA chunk at a time. Near-zero
+// ones are left as they are, like cgvPoint3D::normalize does.
+static void normalize_normals(std::vector<cgvPoint3D>& normals, std::size_t begin, std::size_t end) {
+    GLfloat x[SOA_CHUNK], y[SOA_CHUNK], z[SOA_CHUNK];
+    const vec3_soa soa{x, y, z};
+    for (std::size_t chunk = begin; chunk < end; chunk += SOA_CHUNK) {
+        const std::size_t count = std::min(end - chunk, SOA_CHUNK);
+        to_soa(&normals[chunk], count, soa);
+        normalize(soa, count);
+        from_soa(soa, count, &normals[chunk]);
+    }
+}
+
+static void scatter_normals(const std::vector<cgvPoint3D>& vertices, const std::vector<cgvTriangle>& triangles,
+                            std::vector<cgvPoint3D>& normals) {
+    normals.assign(vertices.size(), cgvPoint3D(0, 0, 0));
+    FaceNormal faces[SCATTER_CHUNK];
+    for (std::size_t begin = 0; begin < triangles.size(); begin += SCATTER_CHUNK) {
+        std::size_t end = std::min(triangles.size(), begin + SCATTER_CHUNK);
+        compute_face_normals(vertices, triangles, begin, end, faces);
+        for (std::size_t t = begin; t < end; ++t) {
+            cgvPoint3D normal(faces[t - begin].x, faces[t - begin].y, faces[t - begin].z);
+            for (unsigned v : triangles[t].v) normals[v] += normal;
+        }
+    }
+    normalize_normals(normals, 0, normals.size());
+}
+
+// Builds first[v]..first[v + 1] as the range of adjacency holding the
+// triangles that use vertex v, in triangle order. The counts are one shared
+// array of atomics, so the scratch memory is one word per vertex and one per
+// corner whatever the thread count. Triangles land in their
+// vertex's range in whatever order the threads get there, so each range is
+// sorted afterwards to keep the normal sums, and with them the normals,
+// reproducible.
+static void build_vertex_triangles(std::size_t vertex_count, const std::vector<cgvTriangle>& triangles,
+                                   std::size_t blocks, std::vector<unsigned>& first,
+                                   std::unique_ptr<unsigned[]>& adjacency) {
+    const std::size_t triangle_count = triangles.size();
+    auto tasks_for = [](std::size_t count) { return (count + NORMALS_BLOCK - 1) / NORMALS_BLOCK; };
+    auto task_range = [](std::size_t task, std::size_t count, std::size_t& begin, std::size_t& end) {
+        begin = task * NORMALS_BLOCK;
+        end = std::min(count, begin + NORMALS_BLOCK);
+    };
+
+    std::unique_ptr<std::atomic<unsigned>[]> counts(new std::atomic<unsigned>[vertex_count]);
+    JobSystem::instance().for_each(tasks_for(vertex_count), [&](std::size_t task) {
+        std::size_t begin, end;
+        task_range(task, vertex_count, begin, end);
+        for (std::size_t v = begin; v < end; ++v) counts[v].store(0, std::memory_order_relaxed);
+    });
+    // Each corner keeps the rank its increment returned, its slot within its
+    // vertex's range, so the fill pass needs no atomics.
+    std::unique_ptr<unsigned[]> ranks(new unsigned[3 * triangle_count]);
+    JobSystem::instance().for_each(tasks_for(triangle_count), [&](std::size_t task) {
+        std::size_t begin, end;
+        task_range(task, triangle_count, begin, end);
+        for (std::size_t t = begin; t < end; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                ranks[3 * t + k] = counts[triangles[t].v[k]].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    // Turn the counts into each vertex's first slot. The prefix sum is split
+    // over vertex ranges: range totals first, then each range is scanned from
+    // its own starting offset.
+    auto vertex_range = [&](std::size_t r, std::size_t& begin, std::size_t& end) {
+        begin = vertex_count * r / blocks;
+        end = vertex_count * (r + 1) / blocks;
+    };
+    std::vector<unsigned> range_offset(blocks + 1, 0);
+    JobSystem::instance().for_each(blocks, [&](std::size_t r) {
+        std::size_t begin, end;
+        vertex_range(r, begin, end);
+        unsigned total = 0;
+        for (std::size_t v = begin; v < end; ++v) total += counts[v].load(std::memory_order_relaxed);
+        range_offset[r + 1] = total;
+    });
+    for (std::size_t r = 0; r < blocks; ++r) range_offset[r + 1] += range_offset[r];
+
+    first.resize(vertex_count + 1);
+    first[vertex_count] = range_offset[blocks];
+    JobSystem::instance().for_each(blocks, [&](std::size_t r) {
+        std::size_t begin, end;
+        vertex_range(r, begin, end);
+        unsigned offset = range_offset[r];
+        for (std::size_t v = begin; v < end; ++v) {
+            first[v] = offset;
+            offset += counts[v].load(std::memory_order_relaxed);
+        }
+    });
+
+    adjacency.reset(new unsigned[first[vertex_count]]);
+    JobSystem::instance().for_each(tasks_for(triangle_count), [&](std::size_t task) {
+        std::size_t begin, end;
+        task_range(task, triangle_count, begin, end);
+        for (std::size_t t = begin; t < end; ++t) {
+            for (int k = 0; k < 3; ++k) {
+                adjacency[first[triangles[t].v[k]] + ranks[3 * t + k]] = static_cast<unsigned>(t);
+            }
+        }
+    });
+
+    // Ranges hold a handful of triangles, so insertion sort.
+    JobSystem::instance().for_each(tasks_for(vertex_count), [&](std::size_t task) {
+        std::size_t begin, end;
+        task_range(task, vertex_count, begin, end);
+        for (std::size_t v = begin; v < end; ++v) {
+            for (unsigned i = first[v] + 1; i < first[v + 1]; ++i) {
+                unsigned t = adjacency[i];
+                unsigned j = i;
+                for (; j > first[v] && adjacency[j - 1] > t; --j) adjacency[j] = adjacency[j - 1];
+                adjacency[j] = t;
+            }
+        }
+    });
+}
+
+static void gather_normals(const std::vector<unsigned>& first, const unsigned* adjacency, const FaceNormal* faces,
+                           std::size_t begin, std::size_t end, std::vector<cgvPoint3D>& normals) {
+    for (std::size_t v = begin; v < end; ++v) {
+#if CGV_SSE
+        __m128 sum = _mm_setzero_ps();
+        for (unsigned i = first[v]; i < first[v + 1]; ++i) sum = _mm_add_ps(sum, _mm_load_ps(&faces[adjacency[i]].x));
+        alignas(16) GLfloat xyz[4];
+        _mm_store_ps(xyz, sum);
+        normals[v] = cgvPoint3D(xyz[X], xyz[Y], xyz[Z]);
+#else
+        cgvPoint3D sum(0, 0, 0);
+        for (unsigned i = first[v]; i < first[v + 1]; ++i) {
+            const FaceNormal& face = faces[adjacency[i]];
+            sum += cgvPoint3D(face.x, face.y, face.z);
+        }
+        normals[v] = sum;
+#endif
+    }
+    normalize_normals(normals, begin, end);
 }
 
 void cgvTriangleMesh::compute_normals() {
     if (vertices.empty() || triangles.empty()) return;
+    vertices_dirty = true;
 
-    normals.assign(vertices.size(), cgvPoint3D(0, 0, 0));
+    const std::size_t triangle_count = triangles.size();
+    const std::size_t vertex_count = vertices.size();
+    const std::size_t blocks =
+        std::min<std::size_t>(JobSystem::instance().thread_count(), triangle_count / NORMALS_BLOCK);
+    if (blocks < NORMALS_MIN_THREADS) {
+        scatter_normals(vertices, triangles, normals);
+        return;
+    }
+
+    auto tasks_for = [](std::size_t count) { return (count + NORMALS_BLOCK - 1) / NORMALS_BLOCK; };
+
+    // Scratch arrays are filled completely, so they are left uninitialized.
+    std::unique_ptr<FaceNormal[]> faces(new FaceNormal[triangle_count]);
+    JobSystem::instance().for_each(tasks_for(triangle_count), [&](std::size_t task) {
+        std::size_t begin = task * NORMALS_BLOCK;
+        compute_face_normals(vertices, triangles, begin, std::min(triangle_count, begin + NORMALS_BLOCK),
+                             faces.get() + begin);
+    });
+
+    std::vector<unsigned> first;
+    std::unique_ptr<unsigned[]> adjacency;
+    build_vertex_triangles(vertex_count, triangles, blocks, first, adjacency);
+
+    normals.resize(vertex_count);
+    JobSystem::instance().for_each(tasks_for(vertex_count), [&](std::size_t task) {
+        std::size_t begin = task * NORMALS_BLOCK;
+        gather_normals(first, adjacency.get(), faces.get(), begin, std::min(vertex_count, begin + NORMALS_BLOCK),
+                       normals);
+    });
+}
 
-    for (const auto& tri : triangles) {
-        cgvPoint3D v0 = vertices[tri.v[0]];
-        cgvPoint3D v1 = vertices[tri.v[1]];
-        cgvPoint3D v2 = vertices[tri.v[2]];
+void cgvTriangleMesh::compute_bounds() {
+    BoundingBox box;
+    for (const cgvPoint3D& v : vertices) box.expand(v);
 
-        cgvPoint3D edge1 = v1 - v0;
-        cgvPoint3D edge2 = v2 - v0;
-        cgvPoint3D normal = edge1.cross(edge2);
-        
-        normals[tri.v[0]] += normal;
-        normals[tri.v[1]] += normal;
-        normals[tri.v[2]] += normal;
+    // Centred on the box, but only as big as the farthest vertex needs.
+    BoundingSphere sphere{box.center(), 0.0f};
+    GLfloat farthest = 0.0f;
+    for (const cgvPoint3D& v : vertices) {
+        vec3 offset = vec3(v) - sphere.center;
+        farthest = std::max(farthest, dot(offset, offset));
     }
+    sphere.radius = std::sqrt(farthest);
+    setLocalBounds(box, sphere);
+}
+
+void cgvTriangleMesh::build_bvh() {
+    std::vector<BoundingBox> boxes(triangles.size());
+    for (std::size_t i = 0; i < triangles.size(); ++i) {
+        for (unsigned int v : triangles[i].v) boxes[i].expand(vertices[v]);
+    }
+    bvh.build(boxes);
+    bvh_dirty = false;
+}
+
+bool cgvTriangleMesh::intersect(const Ray& ray, RayHit& hit) {
+    if (loading) return false; // the placeholder is only an outline
+    if (bvh_dirty) build_bvh();
+
+    Ray local = ray.transformed(getWorldMatrix().inverse());
+    return bvh.traverse(local, hit, [&](std::uint32_t i, RayHit& nearest) {
+        const cgvTriangle& tri = triangles[i];
+        GLfloat t;
+        if (!RayTests::triangle(local, vertices[tri.v[0]], vertices[tri.v[1]], vertices[tri.v[2]],
+                                nearest.distance, t)) {
+            return false;
+        }
+        nearest.distance = t;
+        nearest.part = -1;
+        nearest.triangle = static_cast<int>(i);
+        return true;
+    });
+}
 
-    for (auto& normal : normals) {
-        normal.normalize();
+void cgvTriangleMesh::drawIds(GLuint objectBits) {
+    if (loading || triangles.empty()) return;
+    if (id_arrays_dirty) {
+        id_positions.resize(triangles.size() * 3);
+        for (std::size_t i = 0; i < triangles.size(); ++i) {
+            for (int corner = 0; corner < 3; ++corner) id_positions[i * 3 + corner] = vertices[triangles[i].v[corner]];
+        }
+        id_colors.resize(triangles.size() * 3);
+        id_object_bits = ~objectBits; // force the colours below
+        id_arrays_dirty = false;
     }
+    if (id_object_bits != objectBits) {
+        // Each corner holds the ID's bytes in memory order R, G, B, A.
+        for (std::size_t i = 0; i < triangles.size(); ++i) {
+            GLuint id = objectBits | static_cast<GLuint>(i);
+            const GLubyte bytes[4] = {static_cast<GLubyte>(id >> 24), static_cast<GLubyte>(id >> 16),
+                                      static_cast<GLubyte>(id >> 8), static_cast<GLubyte>(id)};
+            for (int corner = 0; corner < 3; ++corner) std::memcpy(&id_colors[i * 3 + corner], bytes, 4);
+        }
+        id_object_bits = objectBits;
+    }
+
+    loadModelView();
+    if (GLCaps::vertexArrayObjects()) GLCaps::bindVertexArray(0);
+    if (GLCaps::bufferObjects()) glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, id_positions.data());
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, id_colors.data());
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(id_positions.size()));
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+void cgvTriangleMesh::swap_geometry(cgvTriangleMesh& other) {
+    vertices.swap(other.vertices);
+    normals.swap(other.normals);
+    triangles.swap(other.triangles);
+    lod_triangles.swap(other.lod_triangles);
+    lod_levels.swap(other.lod_levels);
+    std::swap(localBounds, other.localBounds);
+    std::swap(localSphere, other.localSphere);
+    std::swap(bounded, other.bounded);
+    std::swap(bvh, other.bvh);
+    std::swap(bvh_dirty, other.bvh_dirty);
+    vertices_dirty = indices_dirty = id_arrays_dirty = true;
+    other.vertices_dirty = other.indices_dirty = other.id_arrays_dirty = true;
 }
@@ -4,37 +4,167 @@
 #include <vector>
 #include "cgvPoint3D.h"
 #include "Object3D.h"
+#include "Material.h"
+#include "BVH.h"
 
 class cgvTriangle {
 public:
     unsigned int v[3];
+    cgvTriangle() = default;
     cgvTriangle(unsigned int v0, unsigned int v1, unsigned int v2) {
         v[0] = v0; v[1] = v1; v[2] = v2;
     }
 };
 
+// A simplified version of a mesh: a range of the index buffer drawing the
+// same vertices with fewer triangles, and how far (in object units) its
+// surface may be from the full mesh.
+struct LodLevel {
+    std::size_t first; // in indices
+    std::size_t count; // in indices
+    float error;
+};
+
 class cgvTriangleMesh : public Object3D {
 protected:
     std::vector<cgvPoint3D> vertices;
     std::vector<cgvPoint3D> normals;
     std::vector<cgvTriangle> triangles;
 
-    float specular_reflectivity = 0.5f;
-    float shininess = 10.0f;
+    // Specular term only: ambient and diffuse follow the colour.
+    Material material;
+
+    bool loading = false;
+
+    // GPU copies of the arrays above. The client arrays stay authoritative;
+    // the buffers are refreshed from them when marked dirty.
+    bool use_gpu_buffers = true;
+    bool vertices_dirty = true;
+    bool indices_dirty = true;
+    GLuint vertex_buffer = 0;  // positions followed by normals
+    GLuint index_buffer = 0;
+    GLuint vertex_array = 0;
+    std::size_t uploaded_vertex_count = 0;
+    std::size_t uploaded_index_count = 0;
+
+    // Triangle hierarchy for picking, rebuilt when the geometry has changed.
+    BVH bvh;
+    bool bvh_dirty = true;
+
+    // Levels of detail after the full mesh, coarser and coarser. Their
+    // triangles follow the full mesh's in the index buffer; first counts
+    // from the start of lod_triangles. Changing the geometry drops them.
+    std::vector<cgvTriangle> lod_triangles;
+    std::vector<LodLevel> lod_levels;
+
+    // How the camera turns object-space error into pixels; see
+    // set_lod_projection.
+    static float lod_pixels_per_unit;
+    static bool lod_perspective;
+    static float lod_tolerance;
+    static bool lod_enabled;
+
+    // Unshared corners of every triangle coloured with its ID, for the GPU
+    // ID pass. The colours are for id_object_bits.
+    std::vector<cgvPoint3D> id_positions;
+    std::vector<GLuint> id_colors;
+    GLuint id_object_bits = 0;
+    bool id_arrays_dirty = true;
+
+    void upload_buffers();
+    void release_buffers();
+    void draw_client_arrays(std::size_t level);
+    void draw_buffers(std::size_t level);
+    void clear_lods() { lod_triangles.clear(); lod_levels.clear(); }
+    std::size_t lod_in_view(); // the level draw() and submit() use this frame
+
+    // drawPacket() part for the wire box shown while loading.
+    static const int PLACEHOLDER_PART = -2;
 
 public:
-    cgvTriangleMesh() = default;
-    ~cgvTriangleMesh() = default;
+    cgvTriangleMesh();
+    ~cgvTriangleMesh();
+
+    // Owns GL objects, so it cannot be copied.
+    cgvTriangleMesh(const cgvTriangleMesh&) = delete;
+    cgvTriangleMesh& operator=(const cgvTriangleMesh&) = delete;
 
     void draw() override;
+    void submit(RenderQueue& queue) override; // one packet, at the level of detail in view
+    void drawPacket(int part) override;
     void compute_normals();
+    // Box and sphere around the vertices, for culling.
+    void compute_bounds();
 
-    std::vector<cgvPoint3D>& get_vertices() { return vertices; }
-    std::vector<cgvPoint3D>& get_normals() { return normals; }
-    std::vector<cgvTriangle>& get_triangles() { return triangles; }
+    // Builds the triangle hierarchy intersect() walks. Loaders call it off
+    // the main thread; otherwise the first pick after a change does.
+    void build_bvh();
+    // Hits the nearest triangle, reporting its index.
+    bool intersect(const Ray& ray, RayHit& hit) override;
+    // Triangles as primitives.
+    void drawIds(GLuint objectBits) override;
+
+    // Exchanges vertices, normals, triangles, levels of detail, bounds and
+    // triangle hierarchy with other.
+    void swap_geometry(cgvTriangleMesh& other);
+
+    // Flags the GPU copy as stale. The non-const getters do this implicitly.
+    void mark_vertices_dirty() { vertices_dirty = true; }
+    void mark_indices_dirty() { indices_dirty = true; }
+
+    // Level 0 is the full mesh.
+    std::size_t get_lod_count() const { return 1 + lod_levels.size(); }
+    LodLevel get_lod(std::size_t level) const;
+    // Byte offset of a level in the bound index buffer.
+    const GLvoid* lod_offset(std::size_t level) const;
+    // Replaces the levels after the full mesh.
+    void set_lods(std::vector<cgvTriangle> triangles, std::vector<LodLevel> levels);
+    const std::vector<cgvTriangle>& get_lod_triangles() const { return lod_triangles; }
+    const std::vector<LodLevel>& get_lod_levels() const { return lod_levels; }
+
+    // The coarsest level whose error stays within the tolerance when seen
+    // from distance (view-space units) with the object scaled by scale.
+    std::size_t select_lod(float distance, float scale) const;
+
+    // Set by the camera every frame before drawing: the size in pixels of
+    // one unit at distance 1 with a perspective projection, or at any
+    // distance with an orthographic one.
+    static void set_lod_projection(float pixels_per_unit, bool perspective);
+    static void set_lod_tolerance(float pixels) { lod_tolerance = pixels; }
+    static void set_lod_enabled(bool enabled) { lod_enabled = enabled; }
+    static bool is_lod_enabled() { return lod_enabled; }
+
+    // Uploads if needed and binds the buffers with the vertex/normal pointers
+    // set, for callers that issue their own draw calls (e.g. instanced ones).
+    // Returns the number of indices of the full mesh, 0 if nothing was bound;
+    // the other levels are drawn with get_lod() and lod_offset().
+    GLsizei bind_buffers();
+    void unbind_buffers();
+
+    // Off: draw straight from the client arrays, as on GL < 1.5.
+    void set_use_gpu_buffers(bool use) { use_gpu_buffers = use; }
+
+    // While loading, draw() shows a placeholder box instead of the mesh.
+    void set_loading(bool _loading) { loading = _loading; }
+    bool is_loading() const { return loading; }
+
+    std::vector<cgvPoint3D>& get_vertices() {
+        vertices_dirty = indices_dirty = bvh_dirty = id_arrays_dirty = true;
+        clear_lods();
+        return vertices;
+    }
+    std::vector<cgvPoint3D>& get_normals() { vertices_dirty = true; return normals; }
+    std::vector<cgvTriangle>& get_triangles() {
+        indices_dirty = bvh_dirty = id_arrays_dirty = true;
+        clear_lods();
+        return triangles;
+    }
+    const std::vector<cgvPoint3D>& get_vertices() const { return vertices; }
+    const std::vector<cgvPoint3D>& get_normals() const { return normals; }
+    const std::vector<cgvTriangle>& get_triangles() const { return triangles; }
 
-    void set_specular_reflectivity(float reflectivity) { specular_reflectivity = reflectivity; }
-    void set_shininess(float s) { shininess = s; }
+    void set_specular_reflectivity(float reflectivity) { material.setSpecular(reflectivity, reflectivity, reflectivity); }
+    void set_shininess(float s) { material.setShininess(s); }
 };
 
 #endif